@@ -0,0 +1,309 @@
+// Parser throughput benchmark.
+//
+//   supercal-bench [--sizes N,N,...] [--min-time SECONDS] [--filter TEXT]
+//                  [--assets DIR] [--rule-stats] [--backtrack] [--memoize]
+//                  [--chunk BYTES] [--max-allocs-per-event N]
+//
+// Runs IcalParser::icalobject() over the dev-assets and over generated
+// corpora of several shapes and sizes, and reports MB/s, events/s and heap
+// allocations per event. Exits with 1 if any input fails to parse.
+//
+// --rule-stats prints per grammar rule counters, and --backtrack the bytes
+// re-read after save_input_pos rollbacks per rule and caller, summed over
+// all cases. Both need a build with -DSUPERCAL_RULE_STATS=ON.
+//
+// --memoize parses with ParserOptions::memoize.
+//
+// --chunk feeds the input to a PushParser in pieces of that size.
+//
+// --max-allocs-per-event fails each case which allocates more than N times
+// per event, to catch copies creeping back into the parser: values are
+// moved from rule to rule, and a deep copy shows as a jump in this count.
+
+#include "IcalParser.hh"
+#include "corpus.hh"
+#include "push_parser.hh"
+#include "rule_stats.hh"
+#include "parser_exceptions.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// -- Allocation counting. -----------------------------------------------------
+namespace {
+std::atomic<std::size_t> allocations{0};
+// Input handed to the parser over all iterations, for --backtrack.
+std::uint64_t parsedBytes = 0;
+}
+
+void* operator new(std::size_t size) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        if (auto p = std::malloc(size ? size : 1))
+                return p;
+        throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) {
+        return operator new(size);
+}
+void* operator new(std::size_t size, std::nothrow_t const &) noexcept {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return std::malloc(size ? size : 1);
+}
+void* operator new[](std::size_t size, std::nothrow_t const &t) noexcept {
+        return operator new(size, t);
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+// -- Corpora. -----------------------------------------------------------------
+enum class Shape {
+        Plain,   // the f1calendar event shape
+        RRule,   // every event recurs, with varied rules
+        Params,  // many parameters per property
+        Folded,  // most lines folded at random widths
+        Utf8     // multi-byte TEXT
+};
+
+char const* name(Shape s) {
+        switch (s) {
+        case Shape::Plain:  return "plain";
+        case Shape::RRule:  return "rrule";
+        case Shape::Params: return "params";
+        case Shape::Folded: return "folded";
+        case Shape::Utf8:   return "utf8";
+        }
+        return "?";
+}
+
+std::string make_corpus(Shape shape, int events) {
+        CorpusOptions opt;
+        opt.events = events;
+        opt.rruleRatio = 0;
+        opt.paramDensity = 0;
+        opt.foldRatio = 0;
+        opt.nonAsciiRatio = 0;
+        opt.xPropsPerEvent = 0;
+        switch (shape) {
+        case Shape::Plain:  break;
+        case Shape::RRule:  opt.rruleRatio = 1; break;
+        case Shape::Params: opt.paramDensity = 1; opt.timezones = 4; break;
+        case Shape::Folded: opt.foldRatio = 0.9; break;
+        case Shape::Utf8:   opt.nonAsciiRatio = 1; break;
+        }
+        return generate_corpus(opt);
+}
+
+// -- Measurement. -------------------------------------------------------------
+struct Options {
+        std::vector<int> sizes = {1000, 10000};
+        double minTime = 0.5;
+        std::string filter;
+        std::string assets = "dev-assets";
+        bool ruleStats = false;
+        bool backtrack = false;
+        std::size_t chunk = 0;
+        double maxAllocsPerEvent = 0; // 0 for no limit
+        ParserOptions parser;
+};
+
+struct Measurement {
+        bool ok = false;
+        std::size_t events = 0;
+        int iterations = 0;
+        double seconds = 0;
+        std::size_t allocations = 0;
+};
+
+std::size_t count_events(Calendar const &cal) {
+        std::size_t ret = 0;
+        for (auto const &c : cal.components)
+                ret += holds_alternative<EventComp>(c);
+        return ret;
+}
+
+bool push_once(std::string const &text, Options const &opt,
+               std::size_t &events
+) {
+        std::size_t count = 0;
+        PushParser parser([&](Component &&c) {
+                count += holds_alternative<EventComp>(c);
+        }, opt.parser);
+        const std::string_view all(text);
+        for (std::size_t i = 0; i < all.size(); i += opt.chunk) {
+                if (!parser.feed(all.substr(i, opt.chunk)))
+                        break;
+        }
+        if (!is_match(parser.finish()))
+                return false;
+        events = count;
+        return true;
+}
+
+bool parse_once(std::string const &text, Options const &opt,
+                std::size_t &events
+) {
+        parsedBytes += text.size();
+        if (opt.chunk != 0)
+                return push_once(text, opt, events);
+        imemstream is(text.data(), text.size());
+        try {
+                IcalParser parser(is, opt.parser);
+                auto ical = parser.icalobject();
+                if (!is_match(ical))
+                        return false;
+                events = count_events(get<Calendar>(ical));
+                return true;
+        } catch (std::exception &e) {
+                std::cerr << "error: " << e.what() << "\n";
+                return false;
+        }
+}
+
+Measurement measure(std::string const &text, Options const &opt) {
+        using clock = std::chrono::steady_clock;
+        Measurement ret;
+        const auto start = clock::now();
+        const auto allocStart = allocations.load();
+        do {
+                if (!parse_once(text, opt, ret.events))
+                        return ret;
+                ++ret.iterations;
+                ret.seconds = std::chrono::duration<double>(
+                        clock::now() - start).count();
+        } while (ret.seconds < opt.minTime);
+        ret.allocations = (allocations.load() - allocStart) / ret.iterations;
+        ret.ok = true;
+        return ret;
+}
+
+void print_header() {
+        std::printf("%-28s %12s %9s %6s %9s %11s %13s\n",
+                    "case", "bytes", "events", "iters",
+                    "MB/s", "events/s", "allocs/event");
+}
+
+bool selected(std::string const &label, Options const &opt) {
+        return opt.filter.empty() || label.find(opt.filter) != std::string::npos;
+}
+
+bool run(std::string const &label, std::string const &text,
+         Options const &opt
+) {
+        const auto m = measure(text, opt);
+        if (!m.ok) {
+                std::printf("%-28s FAILED\n", label.c_str());
+                return false;
+        }
+        const auto perIter = m.seconds / m.iterations;
+        const auto allocsPerEvent =
+                m.events ? double(m.allocations) / m.events : 0.0;
+        const bool tooMany = opt.maxAllocsPerEvent > 0 &&
+                             allocsPerEvent > opt.maxAllocsPerEvent;
+        std::printf("%-28s %12zu %9zu %6d %9.3f %11.0f %13.1f%s\n",
+                    label.c_str(), text.size(), m.events, m.iterations,
+                    text.size() / perIter / 1e6,
+                    m.events / perIter,
+                    allocsPerEvent, tooMany ? " TOO MANY" : "");
+        std::fflush(stdout);
+        return !tooMany;
+}
+
+std::string read_file(std::string const &filename) {
+        std::ifstream f(filename, std::ifstream::binary);
+        if (!f.good())
+                return {};
+        std::stringstream ss;
+        ss << f.rdbuf();
+        return ss.str();
+}
+
+std::vector<int> parse_sizes(std::string const &v) {
+        std::vector<int> ret;
+        std::stringstream ss(v);
+        for (std::string item; std::getline(ss, item, ',');)
+                ret.push_back(std::atoi(item.c_str()));
+        return ret;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+        Options opt;
+        for (int i = 1; i < argc; ++i) {
+                const std::string arg = argv[i];
+                const bool hasValue = i + 1 < argc;
+                if (arg == "--sizes" && hasValue) {
+                        opt.sizes = parse_sizes(argv[++i]);
+                } else if (arg == "--min-time" && hasValue) {
+                        opt.minTime = std::atof(argv[++i]);
+                } else if (arg == "--filter" && hasValue) {
+                        opt.filter = argv[++i];
+                } else if (arg == "--assets" && hasValue) {
+                        opt.assets = argv[++i];
+                } else if (arg == "--rule-stats") {
+                        opt.ruleStats = true;
+                } else if (arg == "--backtrack") {
+                        opt.backtrack = true;
+                } else if (arg == "--memoize") {
+                        opt.parser.memoize = true;
+                } else if (arg == "--chunk" && hasValue) {
+                        opt.chunk = std::strtoul(argv[++i], nullptr, 10);
+                } else if (arg == "--max-allocs-per-event" && hasValue) {
+                        opt.maxAllocsPerEvent = std::atof(argv[++i]);
+                } else {
+                        std::cerr << "usage: " << argv[0]
+                                  << " [--sizes N,N,...] [--min-time SECONDS]"
+                                     " [--filter TEXT] [--assets DIR]"
+                                     " [--rule-stats] [--backtrack]"
+                                     " [--memoize] [--chunk BYTES]"
+                                     " [--max-allocs-per-event N]\n";
+                        return 2;
+                }
+        }
+
+        bool ok = true;
+        print_header();
+        for (auto file : {"mini1.ics", "f1calendar.com/2019_full.ics"}) {
+                if (!selected(file, opt))
+                        continue;
+                const auto text = read_file(opt.assets + "/" + file);
+                if (text.empty()) {
+                        std::cerr << "skipping missing asset " << file << "\n";
+                        continue;
+                }
+                ok &= run(file, text, opt);
+        }
+        for (auto shape : {Shape::Plain, Shape::RRule, Shape::Params,
+                           Shape::Folded, Shape::Utf8}) {
+                for (auto events : opt.sizes) {
+                        const auto label = std::string("gen/") + name(shape) +
+                                           "/" + std::to_string(events);
+                        if (!selected(label, opt))
+                                continue;
+                        ok &= run(label, make_corpus(shape, events), opt);
+                }
+        }
+        if (opt.ruleStats) {
+                std::cout << "\n";
+                print_rule_stats(std::cout);
+        }
+        if (opt.backtrack) {
+                std::cout << "\n";
+                print_backtrack_report(std::cout, parsedBytes);
+        }
+        return ok ? 0 : 1;
+}
@@ -0,0 +1,346 @@
+#include "corpus.hh"
+#include <cmath>
+#include <iterator>
+#include <string_view>
+
+namespace {
+
+// -- Random numbers. ----------------------------------------------------------
+// SplitMix64; unlike the <random> distributions its output is specified, so
+// corpora are reproducible across standard libraries.
+class Rng {
+public:
+        explicit Rng(std::uint64_t seed) : state_(seed) {}
+
+        std::uint64_t next() {
+                auto z = (state_ += 0x9e3779b97f4a7c15ULL);
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+                return z ^ (z >> 31);
+        }
+        // Uniform in [0, n).
+        std::uint32_t below(std::uint32_t n) {
+                return static_cast<std::uint32_t>((next() >> 32) * n >> 32);
+        }
+        int between(int lo, int hi) {
+                return lo + static_cast<int>(below(hi - lo + 1));
+        }
+        bool chance(double p) {
+                return (next() >> 11) * (1.0 / 9007199254740992.0) < p;
+        }
+        // Non-negative integer with the given mean.
+        int count(double mean) {
+                const auto whole = std::floor(mean);
+                return static_cast<int>(whole) + chance(mean - whole);
+        }
+        template <typename T, std::size_t N>
+        T const& pick(T const (&v)[N]) {
+                return v[below(N)];
+        }
+private:
+        std::uint64_t state_;
+};
+
+// -- Vocabulary. --------------------------------------------------------------
+const char *const ascii_words[] = {
+        "Practice", "Qualifying", "Race", "Session", "Grand", "Prix",
+        "Meeting", "Review", "Planning", "Team", "Lunch", "Call", "Weekly",
+        "Sync", "Launch", "Retro", "Workshop", "Circuit", "Park", "Hall"
+};
+const char *const utf8_words[] = {
+        "Grüße", "Köln", "Zürich", "São", "Paulo", "Montréal", "東京",
+        "予選", "決勝", "Гран-при", "России", "Αγώνας", "Ελλάδα", "سباق",
+        "البحرين", "서울", "Kraków", "İstanbul", "Ciudad de México"
+};
+const char *const places[] = {
+        "Melbourne", "Sakhir", "Shanghai", "Baku", "Barcelona", "Monaco",
+        "Montreal", "Le Castellet", "Spielberg", "Silverstone",
+        "Hockenheim", "Budapest", "Spa", "Monza", "Singapore", "Sochi",
+        "Suzuka", "Mexico City", "Austin", "Sao Paulo", "Abu Dhabi"
+};
+const char *const categories[] = {
+        "Formula 1", "Practice", "Qualifying", "Grand Prix", "Work",
+        "Personal", "Travel", "Holiday"
+};
+const char *const rrules[] = {
+        "FREQ=DAILY;COUNT=10",
+        "FREQ=DAILY;INTERVAL=2;UNTIL=20301231T000000Z",
+        "FREQ=WEEKLY;BYDAY=MO,WE,FR",
+        "FREQ=WEEKLY;INTERVAL=2;COUNT=26;WKST=MO;BYDAY=TU",
+        "FREQ=MONTHLY;BYMONTHDAY=1,15",
+        "FREQ=MONTHLY;BYDAY=-1FR;COUNT=12",
+        "FREQ=YEARLY;BYMONTH=3;BYDAY=-1SU",
+        "FREQ=YEARLY;INTERVAL=4;BYMONTH=2;BYMONTHDAY=29"
+};
+const char *const known_zones[] = {
+        "Europe/Berlin", "America/New_York", "Asia/Tokyo",
+        "Australia/Melbourne", "Europe/London", "America/Sao_Paulo",
+        "Asia/Dubai", "Europe/Moscow"
+};
+
+// -- Writer. ------------------------------------------------------------------
+class CorpusWriter {
+public:
+        CorpusWriter(CorpusOptions const &opt, CorpusSink const &sink) :
+                opt_(opt), sink_(sink), rng_(opt.seed)
+        {
+                buf_.reserve(chunk + 4096);
+        }
+
+        void run() {
+                raw("BEGIN:VCALENDAR\r\n");
+                put("VERSION:2.0"); end();
+                put("PRODID:-//supercal//corpus generator//EN"); end();
+                put("CALSCALE:GREGORIAN"); end();
+                put("METHOD:PUBLISH"); end();
+                put("X-WR-CALNAME:Generated "); num(opt_.seed); end();
+                for (int i = 0; i < opt_.timezones; ++i)
+                        timezone(i);
+                for (std::uint64_t i = 0; i != opt_.events; ++i)
+                        event(i);
+                raw("END:VCALENDAR\r\n");
+                flush();
+        }
+
+private:
+        static constexpr std::size_t chunk = std::size_t(1) << 20;
+
+        // -- Output. ----------------------------------------------------------
+        void raw(std::string_view v) {
+                buf_.append(v.data(), v.size());
+        }
+        void put(std::string_view v) {
+                line_.append(v.data(), v.size());
+        }
+        void put(char c) {
+                line_ += c;
+        }
+        void num(std::uint64_t v, int width = 0) {
+                char tmp[20];
+                int n = 0;
+                do {
+                        tmp[n++] = char('0' + v % 10);
+                        v /= 10;
+                } while (v);
+                for (; n < width; ++n)
+                        tmp[n] = '0';
+                while (n)
+                        line_ += tmp[--n];
+        }
+
+        // Terminates the current content line, folding it as configured.
+        void end() {
+                std::size_t width = 75;
+                if (opt_.foldRatio > 0 && rng_.chance(opt_.foldRatio))
+                        width = rng_.between(8, 74);
+                std::size_t pos = 0;
+                while (line_.size() - pos > width) {
+                        // Do not split UTF-8 sequences.
+                        auto n = width;
+                        while (n > 1 && (line_[pos + n] & 0xC0) == 0x80)
+                                --n;
+                        buf_.append(line_, pos, n);
+                        buf_ += "\r\n ";
+                        pos += n;
+                        width = 74; // the leading space counts
+                }
+                buf_.append(line_, pos, std::string::npos);
+                buf_ += "\r\n";
+                line_.clear();
+                if (buf_.size() >= chunk)
+                        flush();
+        }
+
+        void flush() {
+                if (!buf_.empty())
+                        sink_(buf_.data(), buf_.size());
+                buf_.clear();
+        }
+
+        // -- Values. ----------------------------------------------------------
+        void date_time(bool utc) {
+                num(rng_.between(2019, 2030));
+                num(rng_.between(1, 12), 2);
+                num(rng_.between(1, 28), 2);
+                put('T');
+                num(rng_.between(0, 23), 2);
+                num(rng_.below(4) * 15, 2);
+                put("00");
+                if (utc)
+                        put('Z');
+        }
+
+        void words(int n) {
+                const bool utf8 = rng_.chance(opt_.nonAsciiRatio);
+                for (int i = 0; i != n; ++i) {
+                        if (i)
+                                put(' ');
+                        if (utf8 && (i == 0 || rng_.chance(0.5)))
+                                put(rng_.pick(utf8_words));
+                        else
+                                put(rng_.pick(ascii_words));
+                }
+        }
+
+        void text_params() {
+                if (!rng_.chance(opt_.paramDensity))
+                        return;
+                put(";ALTREP=\"http://example.com/doc/");
+                num(rng_.below(100000));
+                put('"');
+                x_params();
+        }
+
+        void x_params() {
+                const int n = rng_.between(1, 3);
+                for (int i = 0; i != n; ++i) {
+                        put(";X-SUPERCAL-P");
+                        num(i);
+                        put(rng_.chance(0.5) ? "=value" : "=\"quoted, value\"");
+                }
+        }
+
+        void tz_name(int i) {
+                if (i < int(std::size(known_zones))) {
+                        put(known_zones[i]);
+                } else {
+                        put("Etc/Generated-");
+                        num(i);
+                }
+        }
+
+        // -- Components. ------------------------------------------------------
+        void timezone(int i) {
+                raw("BEGIN:VTIMEZONE\r\n");
+                put("TZID:"); tz_name(i); end();
+                raw("BEGIN:STANDARD\r\n");
+                put("DTSTART:19701025T030000"); end();
+                put("TZOFFSETFROM:+0200"); end();
+                put("TZOFFSETTO:+0100"); end();
+                put("RRULE:FREQ=YEARLY;BYMONTH=10;BYDAY=-1SU"); end();
+                put("TZNAME:STD"); num(i); end();
+                raw("END:STANDARD\r\n");
+                raw("BEGIN:DAYLIGHT\r\n");
+                put("DTSTART:19700329T020000"); end();
+                put("TZOFFSETFROM:+0100"); end();
+                put("TZOFFSETTO:+0200"); end();
+                put("RRULE:FREQ=YEARLY;BYMONTH=3;BYDAY=-1SU"); end();
+                put("TZNAME:DST"); num(i); end();
+                raw("END:DAYLIGHT\r\n");
+                raw("END:VTIMEZONE\r\n");
+        }
+
+        void event(std::uint64_t i) {
+                raw("BEGIN:VEVENT\r\n");
+
+                put("UID:"); num(i); put('-'); num(rng_.next() >> 40);
+                put("@supercal.example.com"); end();
+
+                put("DTSTAMP:"); date_time(true); end();
+
+                const int tz = opt_.timezones > 0 && rng_.chance(0.5)
+                             ? int(rng_.below(opt_.timezones)) : -1;
+                for (auto prop : {"DTSTART", "DTEND"}) {
+                        put(prop);
+                        if (tz >= 0) {
+                                put(";TZID=");
+                                tz_name(tz);
+                        }
+                        if (rng_.chance(opt_.paramDensity)) {
+                                put(";VALUE=DATE-TIME");
+                                x_params();
+                        }
+                        put(':');
+                        date_time(tz < 0);
+                        end();
+                }
+
+                put("SUMMARY"); text_params(); put(':');
+                words(rng_.between(2, 5)); end();
+
+                put("LOCATION"); text_params(); put(':');
+                put(rng_.pick(places)); end();
+
+                if (rng_.chance(0.5)) {
+                        put("DESCRIPTION"); text_params(); put(':');
+                        const int sentences = rng_.between(1, 4);
+                        for (int s = 0; s != sentences; ++s) {
+                                if (s)
+                                        put("\\n");
+                                words(rng_.between(4, 12));
+                                put("\\, ");
+                                words(2);
+                        }
+                        end();
+                }
+
+                put("CATEGORIES:");
+                put(rng_.pick(categories));
+                if (rng_.chance(0.5)) {
+                        put(',');
+                        put(rng_.pick(categories));
+                }
+                end();
+
+                if (rng_.chance(0.5)) {
+                        put("GEO:");
+                        if (rng_.chance(0.5)) put('-');
+                        num(rng_.below(90)); put('.'); num(rng_.below(10000), 4);
+                        put(';');
+                        if (rng_.chance(0.5)) put('-');
+                        num(rng_.below(180)); put('.'); num(rng_.below(10000), 4);
+                        end();
+                }
+
+                put("SEQUENCE:"); num(rng_.below(10)); end();
+
+                if (rng_.chance(opt_.rruleRatio)) {
+                        put("RRULE:"); put(rng_.pick(rrules)); end();
+                }
+
+                const int xprops = rng_.count(opt_.xPropsPerEvent);
+                for (int x = 0; x != xprops; ++x) {
+                        put("X-SUPERCAL-FIELD");
+                        num(rng_.below(16));
+                        if (rng_.chance(opt_.paramDensity))
+                                x_params();
+                        put(':');
+                        words(rng_.between(1, 3));
+                        end();
+                }
+
+                const int alarms = rng_.count(opt_.alarmsPerEvent);
+                for (int a = 0; a != alarms; ++a) {
+                        raw("BEGIN:VALARM\r\n");
+                        put("ACTION:DISPLAY"); end();
+                        put("DESCRIPTION:Reminder"); end();
+                        put("TRIGGER:-P0DT0H");
+                        num(rng_.between(1, 12) * 5);
+                        put("M0S");
+                        end();
+                        raw("END:VALARM\r\n");
+                }
+
+                raw("END:VEVENT\r\n");
+        }
+
+        CorpusOptions const &opt_;
+        CorpusSink const &sink_;
+        Rng rng_;
+        std::string buf_;
+        std::string line_;
+};
+
+}
+
+void generate_corpus(CorpusOptions const &opt, CorpusSink const &sink) {
+        CorpusWriter(opt, sink).run();
+}
+
+std::string generate_corpus(CorpusOptions const &opt) {
+        std::string ret;
+        generate_corpus(opt, [&ret](char const *data, std::size_t size) {
+                ret.append(data, size);
+        });
+        return ret;
+}
@@ -0,0 +1,45 @@
+#ifndef CORPUS_HH_INCLUDED_20261018
+#define CORPUS_HH_INCLUDED_20261018
+
+// -- Synthetic iCalendar corpora. ---------------------------------------------
+// Generates valid VCALENDAR documents shaped like dev-assets/mini1.ics and
+// the f1calendar.com feed. The output is a pure function of the options,
+// including the seed, on every platform.
+//
+// Only constructs the parser implements are emitted (e.g. no LANGUAGE
+// parameter, no ATTENDEE).
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+struct CorpusOptions {
+        std::uint64_t seed = 1;
+        std::uint64_t events = 1000;
+
+        // Share of events with an RRULE.
+        double rruleRatio = 0.2;
+        // Mean number of VALARMs per event.
+        double alarmsPerEvent = 1.0;
+        // Number of VTIMEZONEs; events then use TZID half of the time.
+        int timezones = 0;
+        // Probability, per property, of carrying extra parameters.
+        double paramDensity = 0.1;
+        // Probability, per property line, of being folded at a random width.
+        // Lines longer than 75 octets are always folded.
+        double foldRatio = 0.05;
+        // Share of TEXT values with non-ASCII characters.
+        double nonAsciiRatio = 0.05;
+        // Mean number of X- properties per event.
+        double xPropsPerEvent = 0.2;
+};
+
+using CorpusSink = std::function<void(char const *data, std::size_t size)>;
+
+// Streams the corpus to `sink` in chunks of about a megabyte.
+void generate_corpus(CorpusOptions const &opt, CorpusSink const &sink);
+
+std::string generate_corpus(CorpusOptions const &opt);
+
+#endif //CORPUS_HH_INCLUDED_20261018
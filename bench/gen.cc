@@ -0,0 +1,80 @@
+// Synthetic iCalendar corpus generator.
+//
+//   supercal-gen [options] [-o FILE]
+//
+//   --seed N          random seed (default 1)
+//   --events N        number of VEVENTs (default 1000)
+//   --rrule P         share of events with an RRULE
+//   --alarms M        mean VALARMs per event
+//   --timezones N     number of VTIMEZONEs
+//   --params P        probability of extra parameters per property
+//   --fold P          probability of folding a line at a random width
+//   --non-ascii P     share of TEXT values with non-ASCII characters
+//   --x-props M       mean X- properties per event
+//
+// The same options always produce the same bytes. Writes to stdout unless
+// -o is given.
+
+#include "corpus.hh"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+void usage(char const *self) {
+        std::cerr << "usage: " << self
+                  << " [--seed N] [--events N] [--rrule P] [--alarms M]"
+                     " [--timezones N] [--params P] [--fold P]"
+                     " [--non-ascii P] [--x-props M] [-o FILE]\n";
+}
+}
+
+int main(int argc, char *argv[]) {
+        CorpusOptions opt;
+        std::string output;
+        for (int i = 1; i < argc; ++i) {
+                const std::string arg = argv[i];
+                if (i + 1 >= argc) {
+                        usage(argv[0]);
+                        return 2;
+                }
+                const char *value = argv[++i];
+                if (arg == "--seed") opt.seed = std::strtoull(value, nullptr, 10);
+                else if (arg == "--events") opt.events = std::strtoull(value, nullptr, 10);
+                else if (arg == "--rrule") opt.rruleRatio = std::atof(value);
+                else if (arg == "--alarms") opt.alarmsPerEvent = std::atof(value);
+                else if (arg == "--timezones") opt.timezones = std::atoi(value);
+                else if (arg == "--params") opt.paramDensity = std::atof(value);
+                else if (arg == "--fold") opt.foldRatio = std::atof(value);
+                else if (arg == "--non-ascii") opt.nonAsciiRatio = std::atof(value);
+                else if (arg == "--x-props") opt.xPropsPerEvent = std::atof(value);
+                else if (arg == "-o") output = value;
+                else {
+                        usage(argv[0]);
+                        return 2;
+                }
+        }
+
+        std::FILE *f = output.empty() ? stdout : std::fopen(output.c_str(), "wb");
+        if (!f) {
+                std::cerr << "cannot open \"" << output << "\": "
+                          << std::strerror(errno) << "\n";
+                return 1;
+        }
+        bool ok = true;
+        generate_corpus(opt, [&](char const *data, std::size_t size) {
+                ok = ok && std::fwrite(data, 1, size, f) == size;
+        });
+        ok = std::fflush(f) == 0 && ok;
+        if (f != stdout)
+                ok = std::fclose(f) == 0 && ok;
+        if (!ok) {
+                std::cerr << "write error\n";
+                return 1;
+        }
+        return 0;
+}
@@ -18,8 +18,11 @@
 //   - [RFC 5646](https://tools.ietf.org/html/rfc5646)
 
 // -- Includes. ----------------------------------------------------------------
+#include <cstdint>
 #include <iosfwd>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
 #include <variant>
@@ -34,6 +37,31 @@ using std::nullopt;
 using std::istream;
 using std::variant;
 
+// -- Options. -----------------------------------------------------------------
+struct ParserOptions {
+        // Components which fail to parse are skipped up to their END line,
+        // and recorded in IcalParser::diagnostics(), instead of failing the
+        // whole calendar.
+        bool lenient = false;
+        // Lenient mode keeps at most this many diagnostics; the rest are
+        // only counted.
+        std::size_t maxDiagnostics = 100;
+        // Cache the results of rules which alternatives try at the same
+        // position (packrat parsing), e.g. the properties shared by the
+        // VALARM kinds. Costs a hash lookup per call.
+        bool memoize = false;
+        // Pool for parameter names, TZIDs, CATEGORIES, LOCATION and x-names;
+        // nullptr is StringPool::global(). Must outlive the results.
+        StringPool *strings = nullptr;
+};
+
+// A component skipped in lenient mode.
+struct Diagnostic {
+        ParserPos componentPos; // the BEGIN line
+        string component;       // e.g. "VEVENT"
+        ParsingError error;
+};
+
 class IcalParser {
 
         struct Unfolder {
@@ -60,15 +88,26 @@ class IcalParser {
                         return print_location(pos, u.is_);
                 }
 
+                // Skips any folds at the current position. Rules which read
+                // from the raw stream must call this first.
+                bool absorb_folds() {
+                        bool ret = false;
+                        while (absorb_fold())
+                                ret = true;
+                        return ret;
+                }
+
         private:
-                void absorb_folds() {
+                // A fold is a line break followed by exactly one SP or HTAB,
+                // both of which vanish when unfolding (RFC 5545, 3.1).
+                bool absorb_fold() {
                         save_input_pos ptran(is_);
 
                         using ct = std::char_traits<char>;
 
                         auto x = is_.get();
                         if (x == ct::eof()) {
-                                return;
+                                return false;
                         } else if (x == ct::to_int_type('\n')) {
                                 x = is_.get();
                         } else if (x == ct::to_int_type('\r')) {
@@ -77,28 +116,32 @@ class IcalParser {
                                         x = is_.get();
                                 }
                         } else {
-                                return;
+                                return false;
                         }
 
-                        if (x == ct::eof()) {
-                                return;
-                        } else if (x == ' ' || x == '\t') {
-                                do {
-                                        x = is_.get();
-                                } while (x == ' ' || x == '\t');
-                                is_.unget();
-                        } else {
-                                return;
-                        }
+                        if (x != ' ' && x != '\t')
+                                return false;
 
                         ptran.commit();
+                        return true;
                 }
         };
         Unfolder is;
 public:
-        explicit IcalParser(std::istream &is) : is{is} {
+        explicit IcalParser(std::istream &is,
+                            ParserOptions const &options = ParserOptions()) :
+                is{is},
+                options_(options),
+                strings_(options.strings ? *options.strings
+                                         : StringPool::global()),
+                source_(dynamic_cast<memory_streambuf *>(is.rdbuf()))
+        {
         }
 
+        // Lenient mode only.
+        vector<Diagnostic> const& diagnostics() const { return diagnostics_; }
+        std::size_t skipped_components() const { return skippedComponents_; }
+
         // -- Helpers. ---------------------------------------------------------
         string expect_token(string const &tok);
         string expect_newline();
@@ -115,7 +158,20 @@ public:
         result<string> digit(int min, int max);
         result<string> digits(int at_least, int at_most);
         result<string> digits(int num);
+        // The longest run of up to `atMost` characters of `cls` (US-ASCII
+        // classes only), which folds may interrupt. It is consumed, and
+        // empty if there is none. The view is into the input if that is an
+        // imemstream and no fold interrupts the run, else into a buffer of
+        // the parser's. Either way it is valid until the next call.
+        std::string_view lexeme(std::uint16_t cls,
+                                std::size_t atMost = std::size_t(-1));
         result<string> alnum();
+        ContentHash source_hash(std::istream::pos_type begin,
+                                std::istream::pos_type end);
+        // The current position, for SYNTAX_ERROR. The line index is built
+        // on first use, i.e. only for inputs which have errors.
+        ParserPos parser_pos();
+        ParserPos parser_pos(std::istream::pos_type pos);
 
 
         // -- Methods. ---------------------------------------------------------
@@ -241,8 +297,8 @@ public:
         bool summparam_single();
         result<SummParams> summparam();
         result<Summary> summary();
-        bool transparam();
-        bool transvalue();
+        result<TranspParams> transparam();
+        result<string> transvalue();
         result<Transp> transp();
         result<Uri> uri();
         bool urlparam();
@@ -372,6 +428,37 @@ public:
         result<XParam> x_param();
         ICalParameter expect_icalparameter();
         result<ICalParameter> icalparameter();
+
+private:
+        bool skip_component(ParserPos const &begin, ParsingError const &error);
+
+        // -- Memoization. -----------------------------------------------------
+        // memo<&IcalParser::rule>() calls rule(), or with
+        // ParserOptions::memoize returns its earlier result at the current
+        // position and skips to where that ended.
+        template <auto Rule> auto memo();
+        void clear_memo();
+
+        struct MemoTableBase {
+                virtual ~MemoTableBase() = default;
+                virtual void clear() = 0;
+        };
+        template <typename Result> struct MemoTable;
+
+        InternedString intern(std::string_view s) {
+                return strings_.intern(s);
+        }
+
+        ParserOptions options_;
+        StringPool &strings_;
+        vector<std::unique_ptr<MemoTableBase>> memo_;
+        optional<LineIndex> lineIndex_;
+        vector<Diagnostic> diagnostics_;
+        std::size_t skippedComponents_ = 0;
+
+        // The input, if it is in memory, see lexeme().
+        memory_streambuf *source_ = nullptr;
+        string lexeme_;
 };
 
 #endif //PARSER_AS_CLASS_HH_INCLUDED_20190220
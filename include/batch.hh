@@ -0,0 +1,53 @@
+#ifndef BATCH_HH_INCLUDED_20261018
+#define BATCH_HH_INCLUDED_20261018
+
+// -- Batch parsing. -----------------------------------------------------------
+// Parses many files concurrently on a fixed number of threads. Files are
+// dealt out largest first to per-thread queues. A thread takes from the back
+// of its own queue and, once that is empty, steals from the front of the
+// others, so that a few huge files do not leave the rest of the pool idle.
+//
+// Each file is parsed with its own StringPool, so memory does not grow with
+// the number of files.
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+#include "IcalParser.hh"
+
+struct BatchOptions {
+        unsigned threads = 0;   // 0 is std::thread::hardware_concurrency()
+        ParserOptions parser;   // `strings` is ignored, see above
+};
+
+struct FileResult {
+        std::string path;
+        std::size_t bytes = 0;
+        std::size_t components = 0;
+        std::size_t events = 0;
+        std::size_t skippedComponents = 0;      // lenient mode
+        bool ok = false;
+        std::string error;
+        ParserPos errorPos;
+};
+
+struct BatchSummary {
+        std::size_t files = 0;
+        std::size_t failed = 0;
+        std::size_t bytes = 0;
+        std::size_t events = 0;
+        double seconds = 0;
+};
+
+// The regular files named *.ics below each of `roots`; roots which are
+// files themselves are taken as they are. Largest first.
+std::vector<std::string> find_ics_files(std::vector<std::string> const &roots);
+
+// Parses `files` and calls `report` for each one as it is done. Calls to
+// `report` come from the worker threads, but one at a time.
+BatchSummary parse_batch(std::vector<std::string> const &files,
+                         BatchOptions const &options,
+                         std::function<void(FileResult const &)> const &report);
+
+#endif //BATCH_HH_INCLUDED_20261018
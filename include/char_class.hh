@@ -0,0 +1,193 @@
+#ifndef CHAR_CLASS_HH_INCLUDED_20261018
+#define CHAR_CLASS_HH_INCLUDED_20261018
+
+// -- Character classes of RFC 5234 and RFC 5545. -----------------------------
+// One compile-time table of 256 bitmasks replaces the per-character switch
+// statements. Only US-ASCII is classified here: NON-US-ASCII, which SAFE-,
+// QSAFE-, VALUE- and TSAFE-CHAR include, is multi-byte and validated by
+// rfc3629, see append_utf8_run().
+//
+//     ALPHA         = %x41-5A / %x61-7A
+//     DIGIT         = %x30-39
+//     HEXDIG        = DIGIT / "A"-"F" / "a"-"f"
+//     WSP           = SP / HTAB
+//     SAFE-CHAR     = WSP / %x21 / %x23-2B / %x2D-39 / %x3C-7E
+//     QSAFE-CHAR    = WSP / %x21 / %x23-7E
+//     VALUE-CHAR    = WSP / %x21-7E
+//     TSAFE-CHAR    = WSP / %x21 / %x23-2B / %x2D-39 / %x3C-5B / %x5D-7E
+//     CONTROL       = %x00-08 / %x0A-1F / %x7F
+//     iana-token    = 1*(ALPHA / DIGIT / "-")
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+#include "rfc3629.hh"
+
+enum CharClass : std::uint16_t {
+        cc_alpha   = 1 << 0,
+        cc_digit   = 1 << 1,
+        cc_hexdig  = 1 << 2,
+        cc_wsp     = 1 << 3,
+        cc_safe    = 1 << 4,
+        cc_qsafe   = 1 << 5,
+        cc_value   = 1 << 6,
+        cc_tsafe   = 1 << 7,
+        cc_control = 1 << 8,
+        cc_iana    = 1 << 9,
+};
+
+namespace char_class_detail {
+constexpr std::uint16_t classify(int c) {
+        std::uint16_t ret = 0;
+        const bool alpha = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+        const bool digit = c >= '0' && c <= '9';
+        const bool wsp = c == ' ' || c == '\t';
+        const bool visible = c >= 0x21 && c <= 0x7E;
+        if (alpha) ret |= cc_alpha;
+        if (digit) ret |= cc_digit;
+        if (digit || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f'))
+                ret |= cc_hexdig;
+        if (wsp) ret |= cc_wsp;
+        if (wsp || (visible && c != '"' && c != ';' && c != ':' && c != ','))
+                ret |= cc_safe;
+        if (wsp || (visible && c != '"'))
+                ret |= cc_qsafe;
+        if (wsp || visible)
+                ret |= cc_value;
+        if (wsp || (visible && c != '"' && c != ';' && c != ':' &&
+                    c != ',' && c != '\\'))
+                ret |= cc_tsafe;
+        if ((c >= 0x00 && c <= 0x08) || (c >= 0x0A && c <= 0x1F) || c == 0x7F)
+                ret |= cc_control;
+        if (alpha || digit || c == '-')
+                ret |= cc_iana;
+        return ret;
+}
+
+constexpr std::array<std::uint16_t, 256> make_table() {
+        std::array<std::uint16_t, 256> ret{};
+        for (int c = 0; c != 256; ++c)
+                ret[c] = classify(c);
+        return ret;
+}
+
+inline constexpr std::array<std::uint16_t, 256> table = make_table();
+}
+
+// `cls` may combine several classes. `c` as returned by std::istream::get();
+// EOF is in no class.
+constexpr bool is_in(int c, std::uint16_t cls) {
+        return c >= 0 && c < 256 && (char_class_detail::table[c] & cls) != 0;
+}
+constexpr bool is_in(char c, std::uint16_t cls) {
+        return (char_class_detail::table[static_cast<unsigned char>(c)] &
+                cls) != 0;
+}
+
+// -- ASCII case folding. -----------------------------------------------------
+// Quoted strings in ABNF are case-insensitive (RFC 5234, 2.3), and so are
+// the names and enumerated values of RFC 5545. Letters compare equal in
+// either case; anything else must be equal.
+
+constexpr bool equal_ignore_case(int a, int b) {
+        return a == b || (is_in(a, cc_alpha) && (a ^ 0x20) == b);
+}
+
+// Compares eight bytes per step. `lit` must be US-ASCII: its letters get a
+// 0x20 mask, so that OR-ing it into both sides folds exactly the letter
+// positions, and never turns, say, CR (0x0D) into "-" (0x2D).
+inline bool equal_ignore_case(char const *input, char const *lit,
+                              std::size_t n
+) {
+        constexpr std::uint64_t ones = 0x0101010101010101ull;
+        constexpr std::uint64_t high = 0x8080808080808080ull;
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+                std::uint64_t a, b;
+                std::memcpy(&a, input + i, 8);
+                std::memcpy(&b, lit + i, 8);
+                // Letters of `lit`: 'a' <= (b | 0x20) <= 'z', per byte.
+                const auto lower = b | (ones * 0x20);
+                const auto geA = (lower + ones * (0x80 - 'a')) & high;
+                const auto gtZ = (lower + ones * (0x7F - 'z')) & high;
+                const auto mask = ((geA & ~gtZ) >> 2);
+                if (((a | mask) ^ (b | mask)) != 0)
+                        return false;
+        }
+        for (; i != n; ++i)
+                if (!equal_ignore_case(input[i], lit[i]))
+                        return false;
+        return true;
+}
+
+inline bool equal_ignore_case(std::string_view input, std::string_view lit) {
+        return input.size() == lit.size() &&
+               equal_ignore_case(input.data(), lit.data(), lit.size());
+}
+
+// The length of the run of characters in `cls` at `p`, up to `atMost`.
+inline std::size_t run_length(char const *p, char const *end,
+                              std::uint16_t cls,
+                              std::size_t atMost = std::size_t(-1)
+) {
+        const auto avail = static_cast<std::size_t>(end - p);
+        const auto limit = atMost < avail ? atMost : avail;
+        std::size_t n = 0;
+        while (n != limit && is_in(p[n], cls))
+                ++n;
+        return n;
+}
+
+// Consumes the longest run of characters in `cls` from `sb`, up to
+// `atMost`, and appends it to `out`; returns its length. Line breaks belong
+// to no class, so a run never crosses a fold, and callers absorb folds
+// between runs.
+inline std::size_t append_run(std::streambuf &sb, std::uint16_t cls,
+                              std::string &out,
+                              std::size_t atMost = std::size_t(-1)
+) {
+        using traits = std::streambuf::traits_type;
+        std::size_t n = 0;
+        for (auto c = sb.sgetc();
+             n != atMost && c != traits::eof() &&
+             is_in(traits::to_char_type(c), cls);
+             c = sb.snextc()) {
+                out += traits::to_char_type(c);
+                ++n;
+        }
+        return n;
+}
+
+// Like append_run(), but also takes NON-US-ASCII. The run is validated as
+// a whole; if that fails, it is cut back to its valid prefix, leaving the
+// offending character for the per-character rules to report.
+inline std::size_t append_utf8_run(std::streambuf &sb, std::uint16_t cls,
+                                   std::string &out
+) {
+        using traits = std::streambuf::traits_type;
+        const auto start = out.size();
+        bool ascii = true;
+        for (auto c = sb.sgetc(); c != traits::eof(); c = sb.snextc()) {
+                const auto ch = traits::to_char_type(c);
+                if (static_cast<unsigned char>(ch) >= 0x80)
+                        ascii = false;
+                else if (!is_in(ch, cls))
+                        break;
+                out += ch;
+        }
+        auto n = out.size() - start;
+        if (!ascii && !is_valid_utf8(out.data() + start, n)) {
+                const auto valid = valid_utf8_prefix(out.data() + start, n);
+                sb.pubseekoff(-static_cast<std::streamoff>(n - valid),
+                              std::ios::cur, std::ios::in);
+                out.resize(start + valid);
+                n = valid;
+        }
+        return n;
+}
+
+#endif //CHAR_CLASS_HH_INCLUDED_20261018
@@ -0,0 +1,132 @@
+#ifndef COMPACT_EVENT_HH_INCLUDED_20261018
+#define COMPACT_EVENT_HH_INCLUDED_20261018
+
+// -- Compact events. ----------------------------------------------------------
+// EventComp keeps its properties in a vector<EventProp>: each element is as
+// large as the largest alternative (RRule, over 600 bytes), and finding the
+// DTSTART is a linear search. CompactEvent keeps the properties which RFC
+// 5545, 3.6.1 allows at most once in slots of their own type, with a bitmap
+// of those present, so that get<DtStart>() is a bit test. The slots most
+// events fill are inline; the rarer ones share one allocation, made when the
+// first of them is set. Everything else (RRULE, ATTENDEE, X- and IANA
+// properties, and repeats of the slot properties) goes into a side vector.
+//
+//     CompactEvent e(std::move(event));
+//     if (auto start = e.get<DtStart>())
+//             ...
+
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include "ical.hh"
+
+// Position of T in Tuple, or the size of Tuple if not there.
+template <typename T, typename ...Ts>
+constexpr std::size_t index_of(std::tuple<Ts...> const *) {
+        constexpr bool same[] = {std::is_same_v<T, Ts>..., false};
+        std::size_t i = 0;
+        while (i != sizeof...(Ts) && !same[i])
+                ++i;
+        return i;
+}
+
+class CompactEvent : public having_content_hash {
+public:
+        using Inline = std::tuple<DtStamp, Uid, DtStart, DtEnd, Summary,
+                                  Description, Location, Seq, Status, Transp>;
+        using Boxed = std::tuple<Class, Created, Geo, LastMod, Organizer,
+                                 Priority, Url, RecurId, Duration>;
+
+        CompactEvent() = default;
+        explicit CompactEvent(EventComp event);
+        CompactEvent(CompactEvent const &other);
+        CompactEvent(CompactEvent &&) = default;
+        CompactEvent& operator=(CompactEvent const &other);
+        CompactEvent& operator=(CompactEvent &&) = default;
+
+        // -- Slots. -----------------------------------------------------------
+        template <typename T>
+        static constexpr bool has_slot() {
+                return inline_index<T>() != std::tuple_size_v<Inline> ||
+                       boxed_index<T>() != std::tuple_size_v<Boxed>;
+        }
+
+        template <typename T>
+        bool has() const {
+                return (present_ & bit<T>()) != 0;
+        }
+
+        // Null if not present.
+        template <typename T>
+        T const* get() const {
+                if (!has<T>())
+                        return nullptr;
+                if constexpr (is_inline<T>())
+                        return &std::get<T>(inline_);
+                else
+                        return &std::get<T>(*boxed_);
+        }
+
+        template <typename T>
+        void set(T v) {
+                if constexpr (is_inline<T>()) {
+                        std::get<T>(inline_) = std::move(v);
+                } else {
+                        if (!boxed_)
+                                boxed_ = std::make_unique<Boxed>();
+                        std::get<T>(*boxed_) = std::move(v);
+                }
+                present_ |= bit<T>();
+        }
+
+        template <typename T>
+        void reset() {
+                if (has<T>())
+                        set(T());
+                present_ &= ~bit<T>();
+        }
+
+        // -- All properties. --------------------------------------------------
+        // Into its slot if it has one which is free, else into others().
+        void add(EventProp p);
+
+        // In the order added.
+        vector<EventProp> const& others() const { return others_; }
+
+        std::size_t property_count() const;
+
+        // The slots in the order of Inline and Boxed, then others(). Which
+        // is the file order only for files written in that order.
+        EventComp to_event() const;
+
+        vector<Alarm> alarms;
+
+private:
+        template <typename T>
+        static constexpr std::size_t inline_index() {
+                return index_of<T>(static_cast<Inline const *>(nullptr));
+        }
+        template <typename T>
+        static constexpr std::size_t boxed_index() {
+                return index_of<T>(static_cast<Boxed const *>(nullptr));
+        }
+        template <typename T>
+        static constexpr bool is_inline() {
+                return inline_index<T>() != std::tuple_size_v<Inline>;
+        }
+        template <typename T>
+        static constexpr std::uint32_t bit() {
+                static_assert(has_slot<T>(), "a property without a slot");
+                return std::uint32_t(1) << (is_inline<T>()
+                        ? inline_index<T>()
+                        : std::tuple_size_v<Inline> + boxed_index<T>());
+        }
+
+        std::uint32_t present_ = 0;
+        Inline inline_;
+        std::unique_ptr<Boxed> boxed_;
+        vector<EventProp> others_;
+};
+
+#endif //COMPACT_EVENT_HH_INCLUDED_20261018
@@ -0,0 +1,66 @@
+#ifndef CONTENT_HASH_HH_INCLUDED_20261018
+#define CONTENT_HASH_HH_INCLUDED_20261018
+
+// -- Stable 128 bit content hashes. -------------------------------------------
+// The hash function is MurmurHash3 (x64, 128 bit variant). Its output does
+// not depend on the platform, the compiler or the process, so hashes can be
+// persisted and compared across machines.
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct ContentHash {
+        std::uint64_t lo = 0, hi = 0;
+};
+
+inline bool operator== (ContentHash const &a, ContentHash const &b) {
+        return a.lo == b.lo && a.hi == b.hi;
+}
+inline bool operator!= (ContentHash const &a, ContentHash const &b) {
+        return !(a == b);
+}
+inline bool operator< (ContentHash const &a, ContentHash const &b) {
+        return a.hi != b.hi ? a.hi < b.hi : a.lo < b.lo;
+}
+
+// 32 lowercase hex digits, high word first.
+std::string to_string(ContentHash const &v);
+
+ContentHash hash128(void const *data, std::size_t len, std::uint64_t seed = 0);
+inline ContentHash hash128(std::string_view v, std::uint64_t seed = 0) {
+        return hash128(v.data(), v.size(), seed);
+}
+
+// Hashes the canonical form of a component:
+//  - lines are unfolded (line break followed by one SP or HTAB),
+//  - CRLF, LF and CR are all accepted as line breaks,
+//  - the order of content lines within a component does not matter,
+//  - nested components (e.g. VALARM) are hashed recursively and enter the
+//    parent as a single, order independent element.
+// Feed it unfolded content lines in document order, starting with the
+// BEGIN line of the component and ending with its END line.
+class ComponentHasher {
+public:
+        void add_line(std::string_view line);
+        ContentHash finish();
+private:
+        // One entry per open component; the outermost is levels_[0].
+        std::vector<std::vector<ContentHash>> levels_;
+};
+
+// Splits and unfolds `text` and runs it through a ComponentHasher.
+ContentHash hash_component_text(std::string_view text);
+
+namespace std {
+template <> struct hash<ContentHash> {
+        std::size_t operator() (ContentHash const &v) const noexcept {
+                return static_cast<std::size_t>(v.lo ^ (v.hi * 31));
+        }
+};
+}
+
+#endif //CONTENT_HASH_HH_INCLUDED_20261018
@@ -0,0 +1,129 @@
+#ifndef EVENT_STORE_HH_INCLUDED_20261018
+#define EVENT_STORE_HH_INCLUDED_20261018
+
+// -- Columnar event store. ----------------------------------------------------
+// The VEVENTs of any number of calendars, stored as a struct of arrays: one
+// contiguous column per field, row i of every column being the i-th event.
+// A filter such as "confirmed events starting this week" then reads two
+// flat arrays instead of visiting the property variants of every event, and
+// its loop is branch-free, so that the compiler vectorizes it (on x86, its
+// 64 bit compares need AVX2, e.g. -march=x86-64-v3).
+//
+// Times are seconds since 1970-01-01T00:00:00. There is no time zone
+// database here: floating times and times with a TZID are taken as UTC,
+// and flagged as local (see EventFlags), so that callers can tell.
+//
+// Strings (UID, SUMMARY, LOCATION) are stored once per store and referred
+// to by a StringId; SUMMARY and LOCATION are kept unescaped.
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "ical.hh"
+
+enum class EventStatus : std::uint8_t {
+        None,           // no STATUS
+        Tentative,
+        Confirmed,
+        Cancelled
+};
+
+enum EventFlags : std::uint8_t {
+        event_all_day     = 1,  // DTSTART is a DATE
+        event_start_local = 2,  // DTSTART is floating or has a TZID
+        event_end_local   = 4,  // likewise DTEND
+        event_transparent = 8,  // TRANSP:TRANSPARENT
+};
+
+// The parts of an RRULE which planning occurrences starts from.
+struct RRulePlan {
+        Freq freq = Daily;
+        std::int32_t interval = 1;
+        std::int32_t count = 0;                         // 0 if none
+        std::int64_t until = std::numeric_limits<std::int64_t>::max();
+};
+
+// Rows whose DTSTART is in [startFrom, startTo) and whose status is in
+// `statuses`, a mask of (1 << EventStatus).
+struct EventQuery {
+        std::int64_t startFrom = std::numeric_limits<std::int64_t>::min();
+        std::int64_t startTo = std::numeric_limits<std::int64_t>::max();
+        std::uint8_t statuses = 0xFF;
+        std::uint8_t withoutFlags = 0;  // EventFlags a row must not have
+
+        EventQuery& status(EventStatus s) {
+                statuses = std::uint8_t(1u << static_cast<unsigned>(s));
+                return *this;
+        }
+};
+
+class EventStore {
+public:
+        using StringId = std::uint32_t;
+        static constexpr StringId no_string = 0;        // the empty string
+        static constexpr std::uint32_t no_rrule =
+                std::numeric_limits<std::uint32_t>::max();
+        static constexpr std::int64_t no_time =
+                std::numeric_limits<std::int64_t>::min();
+
+        EventStore();
+
+        void add(Calendar const &cal);
+        void add(EventComp const &event);
+        void reserve(std::size_t events);
+
+        std::size_t size() const { return dtStart_.size(); }
+        bool empty() const { return dtStart_.empty(); }
+
+        // -- Columns, one entry per event. ------------------------------------
+        std::vector<std::int64_t> const& dtstart() const { return dtStart_; }
+        std::vector<std::int64_t> const& dtend() const { return dtEnd_; }
+        std::vector<EventStatus> const& status() const { return status_; }
+        std::vector<std::uint8_t> const& flags() const { return flags_; }
+        std::vector<std::int32_t> const& sequence() const { return sequence_; }
+        std::vector<StringId> const& uid() const { return uid_; }
+        std::vector<StringId> const& summary() const { return summary_; }
+        std::vector<StringId> const& location() const { return location_; }
+        // Into rrules(), or no_rrule.
+        std::vector<std::uint32_t> const& rrule() const { return rrule_; }
+
+        // Rows with an RRULE, ascending, and their plans.
+        std::vector<std::uint32_t> const& recurring() const {
+                return recurring_;
+        }
+        std::vector<RRulePlan> const& rrules() const { return rrules_; }
+
+        std::string_view str(StringId id) const { return strings_[id]; }
+        std::size_t string_count() const { return strings_.size(); }
+
+        // -- Scans. -----------------------------------------------------------
+        // Matching rows, ascending.
+        std::vector<std::uint32_t> select(EventQuery const &q) const;
+        std::size_t count(EventQuery const &q) const;
+
+private:
+        StringId intern(std::string_view v);
+        void match(EventQuery const &q, std::uint8_t *hits) const;
+
+        std::vector<std::int64_t> dtStart_;
+        std::vector<std::int64_t> dtEnd_;
+        std::vector<EventStatus> status_;
+        std::vector<std::uint8_t> flags_;
+        std::vector<std::int32_t> sequence_;
+        std::vector<StringId> uid_;
+        std::vector<StringId> summary_;
+        std::vector<StringId> location_;
+        std::vector<std::uint32_t> rrule_;
+
+        std::vector<std::uint32_t> recurring_;
+        std::vector<RRulePlan> rrules_;
+
+        std::vector<std::string> strings_;
+        std::unordered_map<std::string, StringId> stringIds_;
+};
+
+#endif //EVENT_STORE_HH_INCLUDED_20261018
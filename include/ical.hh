@@ -4,10 +4,13 @@
 #include <iosfwd>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <vector>
 
+#include "content_hash.hh"
 #include "rfc3986.hh"
+#include "string_pool.hh"
 #include "xvariant.hh"
 
 // string
@@ -36,17 +39,19 @@ struct SourceCodePos {
         string function;
 };
 struct ParserPos {
-        int line = -1, col = -1;
+        int line = -1, col = -1; // 1-based
+        long long offset = -1;   // bytes from the start of the input
 };
 struct ParsingError {
         SourceCodePos sourceCodePos;
         ParserPos parserPos;
         string msg;
 };
+// Needs a parser_pos() in scope, as IcalParser::parser_pos().
 #define SYNTAX_ERROR(msg) \
         ParsingError{ \
                 SourceCodePos{__LINE__, __FILE__, __func__}, \
-                ParserPos{}, \
+                parser_pos(), \
                 msg \
         }
 
@@ -66,11 +71,42 @@ inline bool is_match(result<T> const &r) {
         return holds_alternative<T>(r);
 }
 
+// `*v` reads the value in place; `*std::move(v)` moves it out, which is how
+// the parser hands values on: copying would be a deep copy of every string,
+// vector and nested variant below.
 template <typename T>
-inline T operator* (result<T> const &r) {
+inline T const& operator* (result<T> const &r) {
         return get<T>(r);
 }
 
+template <typename T>
+inline T operator* (result<T> &&r) {
+        return get<T>(std::move(r));
+}
+
+
+// TEXT values (RFC 5545, 3.3.11) are kept as in the file, escapes and all,
+// and only decoded when asked for: most consumers index or forward them.
+class Text {
+public:
+        Text() = default;
+        Text(string raw);
+
+        string const& raw() const { return raw_; }
+        bool has_escapes() const { return hasEscapes_; }
+        // Decoded on the first call. That call must not race with others
+        // on the same object.
+        string const& decoded() const;
+
+private:
+        string raw_;
+        bool hasEscapes_ = false;
+        mutable optional<string> decoded_;
+};
+// "\\" to "\", "\;" to ";", "\," to "," and "\N" or "\n" to a newline.
+string unescape_text(std::string_view raw);
+// The reverse, with "\n" for a newline.
+string escape_text(std::string_view text);
 
 // mixins
 struct having_string_name { string name; };
@@ -79,13 +115,20 @@ struct having_integer_value { int value; };
 template <typename T> struct having_value { T value; };
 struct having_string_values { vector<string> values; };
 struct having_uri_values { vector<Uri> values; };
+// For strings which repeat across components, see string_pool.hh.
+struct having_interned_name { InternedString name; };
+struct having_interned_value { InternedString value; };
+struct having_interned_values { vector<InternedString> values; };
+struct having_text_value { Text value; };
+// Hash of the component's canonical source text, see content_hash.hh.
+struct having_content_hash { ContentHash contentHash; };
 
 // ICalendar types
-struct XParam : having_string_name, having_string_values {};
+struct XParam : having_interned_name, having_string_values {};
 struct IanaParam : having_string_values { string token; };
 using OtherParam = xvariant<IanaParam, XParam>;
 
-struct Param : having_string_name, having_string_values {};
+struct Param : having_interned_name, having_string_values {};
 
 struct having_other_params {  vector<OtherParam> params; };
 struct having_params { vector<Param> params; };
@@ -141,7 +184,7 @@ struct SentByParam : having_string_value {};
 struct TzIdPrefix : having_string_value {};
 struct TzIdParam : having_string_value {
         optional<TzIdPrefix> prefix;
-        string paramtext;
+        InternedString paramtext;
 };
 
 struct ValueType : having_string_value {};
@@ -238,7 +281,7 @@ struct DescParams : having_other_params {
         optional<AltRepParam> alt_rep;
         optional<LanguageParam> language;
 };
-struct Description : having_string_value {
+struct Description : having_text_value {
         DescParams params;
 };
 struct GeoParams : having_other_params {};
@@ -272,7 +315,7 @@ struct LocParams : having_other_params {
         optional<AltRepParam> alt_rep;
         optional<LanguageParam> language;
 };
-struct Location : having_string_value {
+struct Location : having_interned_value {
         LocParams params;
 };
 
@@ -290,10 +333,13 @@ struct SummParams : having_other_params {
         optional<AltRepParam> alt_rep;
         optional<LanguageParam> language;
 };
-struct Summary : having_string_value {
+struct Summary : having_text_value {
         SummParams params;
 };
-struct Transp {};
+struct TranspParams : having_other_params {};
+struct Transp : having_string_value {
+        TranspParams params;
+};
 struct Url {};
 
 struct RecurId {};
@@ -387,7 +433,7 @@ struct Attendee {};
 struct CatParams : having_other_params {
         optional<LanguageParam> language;
 };
-struct Categories : having_string_values {
+struct Categories : having_interned_values {
         CatParams params;
 };
 struct Comment {};
@@ -398,7 +444,7 @@ struct Related {};
 struct Resources {};
 struct RDate {};
 struct XProp :
-        having_string_name,
+        having_interned_name,
         having_string_value
 {
 vector<ICalParameter> params;
@@ -528,14 +574,14 @@ using EventProp = xvariant<DtStamp,
                            RDate,
                            XProp,
                            IanaProp>;
-struct EventComp {
+struct EventComp : having_content_hash {
         vector<EventProp> properties;
         vector<Alarm> alarms;
 };
 
-struct TodoComp {};
-struct JournalComp {};
-struct FreeBusyComp {};
+struct TodoComp : having_content_hash {};
+struct JournalComp : having_content_hash {};
+struct FreeBusyComp : having_content_hash {};
 
 struct TzIdPropParam : having_other_params {};
 struct TzUrlParam : having_other_params {};
@@ -596,7 +642,7 @@ struct StandardC {
 struct DaylightC {
         TzProp tzProp;
 };
-struct TimezoneComp {
+struct TimezoneComp : having_content_hash {
         TzId tzId;
         optional<LastMod> lastMod;
         optional<TzUrl> tzUrl;
@@ -605,8 +651,8 @@ struct TimezoneComp {
         vector<XProp> xProps;
         vector<IanaProp> ianaProps;
 };
-struct IanaComp {};
-struct XComp {};
+struct IanaComp : having_content_hash {};
+struct XComp : having_content_hash {};
 using Component = xvariant<EventComp,
                            TodoComp,
                            JournalComp,
@@ -615,6 +661,14 @@ using Component = xvariant<EventComp,
                            IanaComp,
                            XComp>;
 
+inline ContentHash content_hash(Component const &v) {
+        ContentHash ret;
+        visit([&ret](having_content_hash const &c) {
+                ret = c.contentHash;
+        }, v);
+        return ret;
+}
+
 struct Calendar {
         CalProps properties;
         vector<Component> components;
@@ -3,6 +3,9 @@
 
 #include "ical.hh"
 
+// TEXT is written as in the file, with its escapes.
+std::ostream& operator<<(std::ostream& os, Text const &);
+
 std::ostream& operator<<(std::ostream& os, ProdId const &);
 std::ostream& operator<<(std::ostream& os, Version const &);
 std::ostream& operator<<(std::ostream& os, ContentLine const &);
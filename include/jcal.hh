@@ -0,0 +1,43 @@
+#ifndef JCAL_HH_INCLUDED_20261018
+#define JCAL_HH_INCLUDED_20261018
+
+// -- jCal (RFC 7265). ---------------------------------------------------------
+// Writes a calendar as jCal, straight into an OutputBuffer: there is no
+// JSON document in between. With a sink-backed buffer, memory stays bounded
+// however many components there are.
+//
+//     ["vcalendar", [properties], [components]]
+//     ["vevent", [properties], [["valarm", [...], []], ...]]
+//     ["dtstart", {"tzid": "Europe/Berlin"}, "date-time", "2019-03-15T12:00:00"]
+//
+// TEXT values are written decoded, as RFC 7265, 3.4.1 asks. X- and IANA
+// properties keep their raw value, with type "unknown" unless they carry a
+// VALUE parameter. Components and properties which the AST does not model
+// yet (VTODO, DURATION, ...) are left out.
+
+#include <string>
+#include <string_view>
+#include "IcalParser.hh"
+#include "ical.hh"
+#include "output_buffer.hh"
+
+void write_jcal(OutputBuffer &out, Calendar const &cal);
+// A single component, e.g. from a PushParser.
+void write_jcal(OutputBuffer &out, Component const &c);
+std::string to_jcal(Calendar const &cal);
+
+// -- jCal input. --------------------------------------------------------------
+// Reads jCal into the same AST as IcalParser. Dates, durations, UTC offsets
+// and RECUR values go through IcalParser's rules for them. Properties the
+// AST has no node for become IanaProps, with their type as VALUE
+// parameter; X- and IANA properties of the calendar itself are dropped, as
+// by IcalParser. Returns no_match if `json` does not start with
+// ["vcalendar", and an error with the line and column in the JSON.
+// `options.lenient` does not apply.
+result<Calendar> parse_jcal(std::string_view json,
+                            ParserOptions const &options = ParserOptions());
+
+// `v` as a JSON string, quotes included.
+void append_json_string(OutputBuffer &out, std::string_view v);
+
+#endif //JCAL_HH_INCLUDED_20261018
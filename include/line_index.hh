@@ -0,0 +1,42 @@
+#ifndef LINE_INDEX_HH_INCLUDED_20261018
+#define LINE_INDEX_HH_INCLUDED_20261018
+
+// -- Line index. --------------------------------------------------------------
+// Maps byte offsets to 1-based line:column. The start of every line is
+// recorded in one sweep over the input; lookups are a binary search.
+//
+// CRLF, lone CR and lone LF each end a line, as in print_location() before.
+// Columns count bytes, and folded lines are counted as they are in the file.
+
+#include <cstddef>
+#include <iosfwd>
+#include <string_view>
+#include <vector>
+
+class LineIndex {
+public:
+        struct Location {
+                int line = -1, col = -1;
+        };
+
+        LineIndex() = default;
+        explicit LineIndex(std::string_view text);
+        // Reads the whole stream through its streambuf; the read position
+        // and state of `is` are left as they were.
+        explicit LineIndex(std::istream &is);
+
+        // Offsets past the end are reported relative to the last line.
+        Location locate(std::streamoff offset) const;
+
+        std::size_t lines() const { return lineStarts_.size(); }
+
+private:
+        void scan(char const *data, std::size_t size);
+        void finish();
+
+        std::vector<std::streamoff> lineStarts_{0};
+        std::streamoff scanned_ = 0;
+        bool pendingCR_ = false;
+};
+
+#endif //LINE_INDEX_HH_INCLUDED_20261018
@@ -0,0 +1,43 @@
+#ifndef MAPPED_FILE_HH_INCLUDED_20261018
+#define MAPPED_FILE_HH_INCLUDED_20261018
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+public:
+        MappedFile() = default;
+        explicit MappedFile(std::string const &filename);
+        ~MappedFile();
+
+        MappedFile(MappedFile &&other) noexcept;
+        MappedFile& operator= (MappedFile &&other) noexcept;
+
+        MappedFile(MappedFile const &) = delete;
+        MappedFile& operator= (MappedFile const &) = delete;
+
+        char const* data() const { return data_; }
+        std::size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+private:
+        void unmap();
+
+        char const *data_ = nullptr;
+        std::size_t size_ = 0;
+#ifdef _WIN32
+        void *file_ = nullptr;
+        void *mapping_ = nullptr;
+#endif
+};
+
+class mapping_error : public std::runtime_error {
+public:
+        mapping_error(std::string const &filename, std::string const &what) :
+                std::runtime_error("cannot map '" + filename + "': " + what)
+        {}
+};
+
+#endif //MAPPED_FILE_HH_INCLUDED_20261018
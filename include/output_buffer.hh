@@ -0,0 +1,82 @@
+#ifndef OUTPUT_BUFFER_HH_INCLUDED_20261018
+#define OUTPUT_BUFFER_HH_INCLUDED_20261018
+
+// -- Output buffer for the writers. -------------------------------------------
+// The jCal and xCal writers append to an OutputBuffer, which is a growable
+// string. Without a sink it keeps everything; with one, it hands its
+// contents over whenever they exceed `flushAt` bytes, so that writing any
+// number of components takes bounded memory.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+class OutputBuffer {
+public:
+        OutputBuffer() = default;
+        explicit OutputBuffer(std::ostream &sink,
+                              std::size_t flushAt = std::size_t(1) << 16);
+        ~OutputBuffer();
+
+        OutputBuffer(OutputBuffer const &) = delete;
+        OutputBuffer& operator=(OutputBuffer const &) = delete;
+
+        void put(char c) {
+                buffer_ += c;
+                if (sink_ && buffer_.size() >= flushAt_)
+                        flush();
+        }
+        void append(std::string_view v) {
+                buffer_.append(v.data(), v.size());
+                if (sink_ && buffer_.size() >= flushAt_)
+                        flush();
+        }
+        OutputBuffer& operator<<(std::string_view v) {
+                append(v);
+                return *this;
+        }
+        OutputBuffer& operator<<(char c) {
+                put(c);
+                return *this;
+        }
+
+        // Writes the contents to the sink, if any.
+        void flush();
+
+        // What has not been flushed yet; without a sink, everything.
+        std::string const& str() const { return buffer_; }
+        std::string take() { return std::move(buffer_); }
+
+private:
+        std::string buffer_;
+        std::ostream *sink_ = nullptr;
+        std::size_t flushAt_ = 0;
+};
+
+// -- Scanning for bytes to escape, eight at a time. ---------------------------
+// Each writer escapes a few bytes of its own; the bulk of real text needs
+// none, and is copied in runs. The tests below are exact for the question
+// "is there such a byte in the word", not for which one it is.
+namespace swar {
+constexpr std::uint64_t ones = 0x0101010101010101ull;
+constexpr std::uint64_t high = 0x8080808080808080ull;
+
+inline std::uint64_t load(char const *p) {
+        std::uint64_t ret;
+        std::memcpy(&ret, p, 8);
+        return ret;
+}
+// Some byte of `x` is below `n`, for n <= 128.
+constexpr bool has_below(std::uint64_t x, unsigned n) {
+        return ((x - ones * n) & ~x & high) != 0;
+}
+// Some byte of `x` is `c`.
+constexpr bool has_byte(std::uint64_t x, unsigned char c) {
+        return has_below(x ^ (ones * c), 1);
+}
+}
+
+#endif //OUTPUT_BUFFER_HH_INCLUDED_20261018
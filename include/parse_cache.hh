@@ -0,0 +1,75 @@
+#ifndef PARSE_CACHE_HH_INCLUDED_20261018
+#define PARSE_CACHE_HH_INCLUDED_20261018
+
+// -- Content addressed parse cache. -------------------------------------------
+// Maps the hash of a raw iCalendar document to its parsed Calendar. Feeds that
+// did not change since the last fetch cost one hash pass instead of a parse.
+//
+// Cached calendars are immutable and shared; holders of a returned pointer
+// keep it alive even after it was evicted. Only successful parses are cached.
+// All member functions are thread safe; parsing runs outside of the lock.
+
+#include "ical.hh"
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+class ParseCache {
+public:
+        struct Limits {
+                // Upper bound on the number of cached calendars.
+                std::size_t maxEntries = 256;
+                // Upper bound on the memory charged to the cache. Each entry is
+                // charged the size of its source text, which is a reasonable
+                // proxy for the size of the AST.
+                std::size_t maxBytes = std::size_t(256) << 20;
+        };
+
+        struct Stats {
+                std::size_t hits = 0;
+                std::size_t misses = 0;
+                std::size_t evictions = 0;
+                std::size_t entries = 0;
+                std::size_t bytes = 0;
+        };
+
+        ParseCache() = default;
+        explicit ParseCache(Limits limits) : limits_(limits) {}
+
+        ParseCache(ParseCache const &) = delete;
+        ParseCache& operator= (ParseCache const &) = delete;
+
+        // Returns the cached calendar for `text`, or parses and caches it.
+        // Exceptions thrown by the parser propagate.
+        result<std::shared_ptr<const Calendar>> parse(std::string_view text);
+
+        // Lookup only; null if absent. Counts as a use for LRU purposes.
+        std::shared_ptr<const Calendar> find(ContentHash const &key);
+
+        void clear();
+        Stats stats() const;
+        Limits limits() const { return limits_; }
+
+private:
+        struct Entry {
+                ContentHash key;
+                std::shared_ptr<const Calendar> calendar;
+                std::size_t bytes;
+        };
+        using Lru = std::list<Entry>; // most recently used first
+
+        std::shared_ptr<const Calendar> find_locked(ContentHash const &key);
+        void insert_locked(Entry entry);
+
+        Limits limits_;
+        mutable std::mutex mutex_;
+        Lru lru_;
+        std::unordered_map<ContentHash, Lru::iterator> index_;
+        Stats stats_;
+};
+
+#endif //PARSE_CACHE_HH_INCLUDED_20261018
@@ -9,6 +9,9 @@
 
 #include <sstream>
 
+#include "line_index.hh"
+#include "rule_stats.hh"
+
 inline namespace parser_helpers {
 
 using std::string;
@@ -16,107 +19,6 @@ using std::vector;
 using std::optional; // TODO: Should use a variant type to signal errors.
 using std::nullopt;
 
-class CallStack {
-public:
-        class Entry {
-        public:
-                Entry() = delete;
-                Entry(Entry const &) = delete;
-                Entry& operator= (Entry const &) = delete;
-
-                Entry(Entry &&other) {
-                        entries_ = other.entries_;
-                        other.entries_ = nullptr;
-                }
-                Entry& operator= (Entry &&other) {
-                        entries_ = other.entries_;
-                        other.entries_ = nullptr;
-                        return *this;
-                }
-
-                Entry(std::vector<const char*> &entries, const char *what)
-                        : entries_(&entries)
-                {
-                        entries_->push_back(what);
-
-                        /*
-                        std::cerr << "  ";
-                        for (auto i=0; i<entries_->size(); ++i)
-                                std::cerr << "  ";
-                        std::cerr << "entered " << what << "\n";
-                        */
-                        std::stringstream ss;
-                        bool first = true;
-                        for (auto &f : *entries_) {
-                                if (!first) ss << " ";
-                                ss << "[" << f << "]";
-                                first = false;
-                        }
-                        std::cerr << shorten("[" + ss.str() + "]\n", 120);
-                }
-                ~Entry() {
-                        if (entries_)
-                                entries_->pop_back();
-                }
-        private:
-                friend class CallStack;
-                std::vector<const char*> *entries_;
-
-                static std::string shorten(std::string const &v, int maxLen=8) {
-                        if (v.size()<maxLen)
-                                return v;
-                        const auto rem = (v.size() - maxLen) + 3;
-                        const auto h = (v.size() - rem) / 2;
-                        const auto left = v.substr(0, h + !(maxLen%2));
-                        const auto right = v.substr(v.size() - h);
-                        return left + "..." + right;
-                }
-        };
-
-        CallStack() = default;
-        CallStack(CallStack const&) = default;
-        CallStack& operator= (CallStack const&) = default;
-
-        Entry push(const char* name) {
-                Entry ret {entries_, name};
-                //std::cerr << *this;
-                return std::move(ret);
-        }
-
-        friend std::ostream& operator<< (
-                std::ostream& os, CallStack const &cs
-        ) {
-                os << "CallStack{\n";
-                for (auto i=0; i!=cs.entries_.size(); ++i) {
-                        /*os << " ..";
-                        for (auto x=0; x!=i; ++x) {
-                                os << "..";
-                        }*/
-                        os << "  " << cs.entries_[i] << "\n";
-                }
-                os << "}\n";
-                return os;
-        }
-private:
-
-        std::vector<const char*> entries_;
-};
-
-extern CallStack callStack;
-
-#if 0
-#define CALLSTACK \
-        print_location(is.tellg(), is);\
-        CallStack::Entry \
-                call_stack_entry_##__LINE__ = callStack.push(__func__);
-#elif 0
-#define CALLSTACK \
-        std::cerr << "[func: " << std::setw(16) << __func__ << "] \n"; \
-        print_location(is.tellg(), is);
-#else
-#define CALLSTACK
-#endif
-
 class not_implemented : public std::runtime_error {
 public:
         not_implemented(std::istream::pos_type pos,
@@ -139,7 +41,11 @@ public:
                         is.tellg(), __func__, __FILE__, __LINE__); \
         }while(false)
 
+// Prints " (while parsing line L:C)" to std::cerr. The first form scans all
+// of `is` (without moving its read position); pass a LineIndex to report
+// several positions in one input.
 void print_location(std::istream::pos_type pos, std::istream &is);
+void print_location(std::istream::pos_type pos, LineIndex const &index);
 
 // -- Utils. -------------------------------------------------------------------
 class save_flags final {
@@ -170,11 +76,22 @@ public:
 class save_input_pos final {
         std::istream *s_;
         std::istream::pos_type pos_;
+        std::ios::iostate state_;
 public:
-        explicit save_input_pos(std::istream &s) : s_(&s), pos_(s.tellg()) { }
+        explicit save_input_pos(std::istream &s) :
+                s_(&s), pos_(s.tellg()), state_(s.rdstate()) { }
         ~save_input_pos() {
                 if (s_ != nullptr) {
-                        try { s_->seekg(pos_); }
+#ifdef ICAL_RULE_STATS
+                        rule_stats_detail::rolled_back(*s_, pos_);
+#endif
+                        // Reading past the end sets failbit, which would
+                        // make seekg() fail; the state is rolled back too.
+                        try {
+                                s_->clear();
+                                s_->seekg(pos_);
+                                s_->clear(state_);
+                        }
                         catch(...) { /* must not throw here. */ }
                 }
         }
@@ -186,7 +103,43 @@ public:
         save_input_pos(save_input_pos const &) = delete;
         save_input_pos& operator= (save_input_pos const &) = delete;
 
-        void commit() { s_ = nullptr; }
+        void commit() {
+#ifdef ICAL_RULE_STATS
+                rule_stats_detail::committed();
+#endif
+                s_ = nullptr;
+        }
+};
+
+// Read-only, seekable stream buffer over memory owned by someone else. Lets
+// the parser run directly over a buffer without copying it into a
+// std::stringstream.
+class memory_streambuf final : public std::streambuf {
+public:
+        memory_streambuf(char const *data, std::size_t size) {
+                auto p = const_cast<char*>(data);
+                setg(p, p, p + size);
+        }
+
+        // The unread input, for rules which scan it in place.
+        char const* cursor() const { return gptr(); }
+        char const* limit() const { return egptr(); }
+        void advance(std::size_t n) { gbump(static_cast<int>(n)); }
+
+protected:
+        pos_type seekoff(off_type off, std::ios::seekdir dir,
+                         std::ios::openmode which) override;
+        pos_type seekpos(pos_type pos, std::ios::openmode which) override;
+};
+
+class imemstream final : public std::istream {
+        memory_streambuf buf_;
+public:
+        imemstream(char const *data, std::size_t size) :
+                std::istream(nullptr), buf_(data, size)
+        {
+                rdbuf(&buf_);
+        }
 };
 
 void dump_remainder(std::istream &is);
@@ -0,0 +1,74 @@
+#ifndef PUSH_PARSER_HH_INCLUDED_20261018
+#define PUSH_PARSER_HH_INCLUDED_20261018
+
+// -- Push parser. -------------------------------------------------------------
+// Parses a calendar which arrives in chunks of any size, e.g. from a socket,
+// without buffering the whole document. Input is split at the lines which
+// begin and end top-level components; each complete component is parsed by
+// an IcalParser over just its bytes and handed to the handler, and then
+// dropped from the buffer.
+//
+// A line break at the end of a chunk may turn out to be a fold, so the last
+// line of a chunk waits for the first byte of the next one, or for finish().
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include "IcalParser.hh"
+
+class PushParser {
+public:
+        using ComponentHandler = std::function<void(Component &&)>;
+
+        explicit PushParser(ComponentHandler onComponent,
+                            ParserOptions const &options = ParserOptions());
+
+        // Parses what the new bytes complete. Returns false once the input
+        // turned out not to be a calendar, or to have an error; the rest is
+        // then ignored.
+        bool feed(std::string_view chunk);
+
+        // The end of the input. Returns the calendar properties, the error,
+        // or no_match if the input did not start with BEGIN:VCALENDAR.
+        result<CalProps> finish();
+
+        // Lenient mode only, with positions in the whole input.
+        vector<Diagnostic> const& diagnostics() const { return diagnostics_; }
+        std::size_t components() const { return components_; }
+        std::size_t skipped_components() const { return skipped_; }
+
+private:
+        enum class State { Header, Body, Done, NotCalendar, Failed };
+
+        void parse(bool final);
+        std::size_t line_end(bool final);
+        std::string_view line(std::size_t end) const;
+        bool header(std::string_view text);
+        bool component(std::string_view text);
+        void consume(std::size_t size);
+        ParserPos parser_pos();
+        ParserPos global_pos(ParserPos pos) const;
+        void fail(ParsingError error);
+
+        ComponentHandler onComponent_;
+        ParserOptions options_;
+        State state_ = State::Header;
+
+        // Unparsed input. Offsets are relative to its start, which is
+        // `offset_` bytes and `line_` lines into the whole input.
+        string buffer_;
+        long long offset_ = 0;
+        int line_ = 1;
+        std::size_t lineBegin_ = 0;     // of the line being looked at
+        std::size_t scanned_ = 0;       // searched for its end up to here
+        int depth_ = 0;                 // of BEGIN lines in the component
+
+        CalProps properties_;
+        std::size_t components_ = 0;
+        std::size_t skipped_ = 0;
+        vector<Diagnostic> diagnostics_;
+        optional<ParsingError> error_;
+};
+
+#endif //PUSH_PARSER_HH_INCLUDED_20261018
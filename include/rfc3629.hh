@@ -4,6 +4,7 @@
 // -- Support for RFC 3629: UTF-8, a transformation format of ISO 10646. -------
 // * [RFC 3629](https://tools.ietf.org/html/rfc3629)
 
+#include <cstddef>
 #include <iosfwd>
 #include <string>
 #include <optional>
@@ -20,6 +21,12 @@ optional<string> read_utf8_4(std::istream &is);
 
 optional<string> read_utf8_tail(std::istream &is);
 
+// Whether [data, data+size) is a sequence of whole UTF8-chars. Checks 16
+// bytes at a time with SSSE3 where the CPU has it.
+bool is_valid_utf8(char const *data, std::size_t size);
+// Length of the longest prefix of whole, valid UTF8-chars.
+std::size_t valid_utf8_prefix(char const *data, std::size_t size);
+
 }
 
 #endif //RFC3629_HH_INCLUDED_20190311
@@ -4,8 +4,10 @@
 // -- URI (RFC 3986) Parser Helpers. ------------------------------------
 // [RFC 3986](https://tools.ietf.org/html/rfc3986)
 
+#include <cstddef>
 #include <iosfwd>
 #include <string>
+#include <string_view>
 #include <optional>
 
 
@@ -57,6 +59,23 @@ optional<string> read_path_absolute(std::istream &is);
 optional<string> read_path_noscheme(std::istream &is);
 optional<string> read_path_rootless(std::istream &is);
 optional<string> read_path_empty(std::istream &is);
+// Whether `c` can occur in a URI at all: unreserved, reserved or "%".
+inline bool is_uri_char(int c) {
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+            (c >= '0' && c <= '9'))
+                return true;
+        switch (c) {
+        case '-': case '.': case '_': case '~':                    // unreserved
+        case ':': case '/': case '?': case '#': case '[': case ']':
+        case '@':                                                  // gen-delims
+        case '!': case '$': case '&': case '\'': case '(': case ')':
+        case '*': case '+': case ',': case ';': case '=':          // sub-delims
+        case '%':
+                return true;
+        }
+        return false;
+}
+
 optional<string> read_path(std::istream &is);
 optional<string> read_port(std::istream &is);
 optional<string> read_reg_name(std::istream &is);
@@ -79,6 +98,31 @@ optional<Uri> read_URI(std::istream &is);
 optional<string> read_absolute_URI(std::istream &is);
 optional<string> read_relative_ref(std::istream &is);
 
+// -- Span recognizer. ---------------------------------------------------
+// scan_URI() recognizes a URI in one pass over contiguous bytes, driven by
+// a character class table and a state transition table. Components are
+// reported as offsets into the input; nothing is copied or allocated.
+
+struct UriSpan {
+        std::size_t begin = 0, end = 0;
+        bool present = false;   // "x:?" has an empty query, "x:" none
+
+        std::string_view in(std::string_view text) const {
+                return text.substr(begin, end - begin);
+        }
+};
+
+struct UriSpans {
+        std::size_t length = 0;
+        UriSpan scheme, hier_part, authority, userinfo, host, port, path,
+                query, fragment;
+};
+
+// Recognizes the longest prefix of `text` that is a URI. An authority that
+// does not match userinfo, host and port ends the URI after "scheme:/".
+optional<UriSpans> scan_URI(std::string_view text);
+Uri to_uri(std::string_view text, UriSpans const &spans);
+
 std::ostream& operator<<(std::ostream& os, Uri const &v);
 
 }
@@ -0,0 +1,196 @@
+#ifndef RULE_STATS_HH_INCLUDED_20261018
+#define RULE_STATS_HH_INCLUDED_20261018
+
+// -- Per grammar rule statistics. ---------------------------------------------
+// Every rule starts with CALLSTACK. With ICAL_RULE_STATS defined (CMake:
+// -DSUPERCAL_RULE_STATS=ON) that places a probe which counts, per rule:
+//
+//   calls          entries into the rule
+//   matches        calls which committed a save_input_pos or consumed input
+//   noMatches      all other calls, including those left by an exception
+//   bytesConsumed  input consumed by matching calls
+//   rollbacks      save_input_pos rollbacks in the rule which gave back input
+//   bytesRolledBack input given back by those, i.e. bytes read twice
+//   nanoseconds    wall time, children included
+//
+// Rollbacks are additionally recorded per (rule, calling rule) pair, which
+// shows where alternatives are tried over the same input; see
+// collect_backtrack_stats().
+//
+// Counters live in thread-local blocks and are only summed up on request.
+// Without ICAL_RULE_STATS, CALLSTACK expands to nothing and the functions
+// below report empty results.
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#ifdef ICAL_RULE_STATS
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <istream>
+#endif
+
+struct RuleStats {
+        std::string name;
+        std::uint64_t calls = 0;
+        std::uint64_t matches = 0;
+        std::uint64_t noMatches = 0;
+        std::uint64_t bytesConsumed = 0;
+        std::uint64_t rollbacks = 0;
+        std::uint64_t bytesRolledBack = 0;
+        std::uint64_t nanoseconds = 0;
+};
+
+struct BacktrackStats {
+        std::string rule;
+        std::string caller; // empty at the top level
+        std::uint64_t rollbacks = 0;
+        std::uint64_t bytesRolledBack = 0;
+};
+
+constexpr bool rule_stats_enabled() {
+#ifdef ICAL_RULE_STATS
+        return true;
+#else
+        return false;
+#endif
+}
+
+// Sums the counters of all threads; rules never called are left out. Sorted
+// by descending time.
+std::vector<RuleStats> collect_rule_stats();
+// Zeroes all counters. Only exact while no parser is running.
+void reset_rule_stats();
+void print_rule_stats(std::ostream &os);
+
+// Rollbacks per (rule, caller), sorted by descending wasted bytes.
+std::vector<BacktrackStats> collect_backtrack_stats();
+// `inputBytes`, if given, is used to put the waste into proportion.
+void print_backtrack_report(std::ostream &os, std::uint64_t inputBytes = 0);
+
+#ifdef ICAL_RULE_STATS
+namespace rule_stats_detail {
+
+struct Counters {
+        // Only the owning thread writes, so relaxed load + store suffices.
+        std::atomic<std::uint64_t> calls{0};
+        std::atomic<std::uint64_t> matches{0};
+        std::atomic<std::uint64_t> noMatches{0};
+        std::atomic<std::uint64_t> bytesConsumed{0};
+        std::atomic<std::uint64_t> rollbacks{0};
+        std::atomic<std::uint64_t> bytesRolledBack{0};
+        std::atomic<std::uint64_t> nanoseconds{0};
+};
+
+inline void add(std::atomic<std::uint64_t> &c, std::uint64_t v) {
+        c.store(c.load(std::memory_order_relaxed) + v,
+                std::memory_order_relaxed);
+}
+
+std::size_t register_rule(char const *name);
+Counters& counters(std::size_t rule);
+void record_backtrack(std::size_t rule, std::size_t caller, std::uint64_t bytes);
+
+inline std::istream::pos_type position(std::istream &is) {
+        return is.rdbuf()->pubseekoff(0, std::ios::cur, std::ios::in);
+}
+
+// IcalParser::Unfolder and friends dereference to their stream.
+inline std::istream& stream(std::istream &is) { return is; }
+template <typename Wrapper>
+std::istream& stream(Wrapper &w) { return *w; }
+
+class Probe {
+public:
+        template <typename Stream>
+        Probe(std::size_t rule, Stream &is) :
+                rule_(rule),
+                is_(stream(is)),
+                start_(position(is_)),
+                exceptions_(std::uncaught_exceptions()),
+                time_(std::chrono::steady_clock::now()),
+                parent_(current())
+        {
+                current() = this;
+        }
+
+        ~Probe() {
+                current() = parent_;
+                auto &c = counters(rule_);
+                add(c.calls, 1);
+                add(c.nanoseconds, std::chrono::duration_cast<
+                        std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now() - time_
+                        ).count());
+
+                const auto end = position(is_);
+                const bool valid = start_ != -1 && end != -1;
+                const bool advanced = valid && end > start_;
+                const bool thrown = std::uncaught_exceptions() > exceptions_;
+                if (!thrown && (committed_ || advanced)) {
+                        add(c.matches, 1);
+                        if (advanced)
+                                add(c.bytesConsumed, end - start_);
+                } else {
+                        add(c.noMatches, 1);
+                }
+        }
+
+        Probe(Probe const &) = delete;
+        Probe& operator= (Probe const &) = delete;
+
+        static Probe*& current() {
+                thread_local Probe *ret = nullptr;
+                return ret;
+        }
+
+        std::size_t rule() const { return rule_; }
+        Probe const* parent() const { return parent_; }
+        void commit() { committed_ = true; }
+
+private:
+        std::size_t rule_;
+        std::istream &is_;
+        std::istream::pos_type start_;
+        int exceptions_;
+        std::chrono::steady_clock::time_point time_;
+        Probe *parent_;
+        bool committed_ = false;
+};
+
+// Hooks for save_input_pos.
+inline void committed() {
+        if (auto p = Probe::current())
+                p->commit();
+}
+
+inline void rolled_back(std::istream &is, std::istream::pos_type to) {
+        const auto p = Probe::current();
+        if (!p)
+                return;
+        const auto from = position(is);
+        if (to == -1 || from == -1 || from <= to)
+                return;
+        const std::uint64_t bytes = from - to;
+        auto &c = counters(p->rule());
+        add(c.rollbacks, 1);
+        add(c.bytesRolledBack, bytes);
+        record_backtrack(p->rule(),
+                         p->parent() ? p->parent()->rule() : std::size_t(-1),
+                         bytes);
+}
+
+}
+
+#define CALLSTACK \
+        static const std::size_t rule_stats_id_ = \
+                rule_stats_detail::register_rule(__func__); \
+        rule_stats_detail::Probe rule_stats_probe_(rule_stats_id_, is)
+#else
+#define CALLSTACK
+#endif
+
+#endif //RULE_STATS_HH_INCLUDED_20261018
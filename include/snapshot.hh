@@ -0,0 +1,241 @@
+#ifndef SNAPSHOT_HH_INCLUDED_20261018
+#define SNAPSHOT_HH_INCLUDED_20261018
+
+// -- Binary calendar snapshots. -----------------------------------------------
+// A snapshot is a read-optimized, relocatable image of a parsed Calendar. It
+// can be memory mapped and queried in place, without parsing or allocating.
+//
+// Layout (all sections 8 byte aligned):
+//
+//   SnapshotHeader
+//   strings     char[]          string bytes, referenced by SnapStr
+//   lists       SnapStr[]       string lists (e.g. CATEGORIES)
+//   components  SnapComponent[] in document order
+//   properties  SnapProperty[]  grouped by component
+//
+// Integers are stored in host byte order; SnapshotHeader::byteOrder lets a
+// reader on a foreign platform reject the file instead of misreading it.
+// All references are offsets or indices, never pointers. The header carries
+// a checksum over itself, which makes opening a snapshot O(1); the payload
+// checksum is only verified on request (SnapshotView::verify_payload()).
+//
+// The snapshot is a projection: properties that the AST does not model in
+// detail yet (PRIORITY, URL, ...) are stored by kind only.
+
+#include "ical.hh"
+#include "mapped_file.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+inline constexpr char snapshot_magic[8] = {'I','C','A','L','S','N','A','P'};
+inline constexpr std::uint16_t snapshot_version_major = 1;
+inline constexpr std::uint16_t snapshot_version_minor = 0;
+// Written as a native integer; reads back differently on a foreign byte order.
+inline constexpr std::uint32_t snapshot_byte_order = 0x01020304;
+
+struct SnapStr {
+        std::uint32_t offset = 0; // into the string section
+        std::uint32_t length = 0;
+};
+
+struct SnapList {
+        std::uint32_t first = 0;  // into the list section
+        std::uint32_t count = 0;
+};
+
+enum SnapDateTimeFlags : std::uint8_t {
+        snap_has_date = 1,
+        snap_has_time = 2,
+        snap_is_utc   = 4
+};
+
+struct SnapDateTime {
+        std::int16_t year = 0;
+        std::uint8_t month = 0, day = 0;
+        std::uint8_t hour = 0, minute = 0, second = 0;
+        std::uint8_t flags = 0; // SnapDateTimeFlags
+};
+
+enum class SnapComponentKind : std::uint16_t {
+        Event,
+        Todo,
+        Journal,
+        FreeBusy,
+        Timezone,
+        Iana,
+        X
+};
+
+struct SnapComponent {
+        std::uint16_t kind = 0;   // SnapComponentKind
+        std::uint16_t reserved = 0;
+        std::uint32_t alarmCount = 0;
+        std::uint32_t firstProperty = 0;
+        std::uint32_t propertyCount = 0;
+        ContentHash contentHash;
+};
+
+// Values are persisted; only ever append.
+enum class SnapPropertyKind : std::uint16_t {
+        Other,
+        DtStamp,      // dateTime
+        Uid,          // value
+        DtStart,      // dateTime, name: TZID
+        DtEnd,        // dateTime, name: TZID
+        Class,        // value
+        Created,      // dateTime
+        Description,  // value
+        Geo,          // name: latitude, value: longitude
+        LastMod,      // dateTime
+        Location,     // value
+        Organizer,    // value: address, name: CN
+        Seq,          // integer
+        Status,       // value
+        Summary,      // value
+        RRule,        // flags: Freq, integer: COUNT, aux: INTERVAL,
+                      // dateTime: UNTIL
+        Categories,   // list
+        XProp,        // name, value
+        IanaProp,     // name, value
+        TzId,         // value
+        Standard,     // dateTime: DTSTART, integer: TZOFFSETTO,
+        Daylight,     //   aux: TZOFFSETFROM (both in seconds)
+        Priority,
+        Transp,       // value
+        Url,
+        RecurId,
+        Duration,
+        Attach,
+        Attendee,
+        Comment,
+        Contact,
+        ExDate,
+        RStatus,
+        Related,
+        Resources,
+        RDate
+};
+
+struct SnapProperty {
+        std::uint16_t kind = 0;   // SnapPropertyKind
+        std::uint16_t flags = 0;
+        std::int32_t integer = 0;
+        std::int32_t aux = 0;
+        std::uint32_t reserved = 0;
+        SnapStr name;
+        union {
+                SnapStr value;
+                SnapList list;
+        };
+        SnapDateTime dateTime;
+
+        SnapProperty() : value() {}
+};
+
+struct SnapSection {
+        std::uint64_t offset = 0;
+        std::uint64_t count = 0;  // elements, not bytes
+};
+
+struct SnapshotHeader {
+        char magic[8];
+        std::uint16_t versionMajor;
+        std::uint16_t versionMinor;
+        std::uint32_t headerSize;
+        std::uint64_t totalSize;
+        std::uint32_t byteOrder;
+        std::uint32_t flags;
+        std::uint64_t headerChecksum;  // over the header, this field zeroed
+        std::uint64_t payloadChecksum; // over everything after the header
+
+        SnapSection strings;
+        SnapSection lists;
+        SnapSection components;
+        SnapSection properties;
+
+        SnapStr prodId;
+        SnapStr version;
+        SnapStr calScale;
+        SnapStr method;
+};
+
+static_assert(sizeof(SnapStr) == 8);
+static_assert(sizeof(SnapDateTime) == 8);
+static_assert(sizeof(SnapComponent) == 32);
+static_assert(sizeof(SnapProperty) == 40);
+static_assert(sizeof(SnapshotHeader) == 144);
+static_assert(std::is_trivially_copyable_v<SnapProperty>);
+static_assert(std::is_trivially_copyable_v<SnapshotHeader>);
+
+class invalid_snapshot : public std::runtime_error {
+public:
+        explicit invalid_snapshot(std::string const &what) :
+                std::runtime_error("invalid snapshot: " + what)
+        {}
+};
+
+// -- Writer. ------------------------------------------------------------------
+std::vector<char> make_snapshot(Calendar const &cal);
+void write_snapshot(std::ostream &os, Calendar const &cal);
+
+// -- Reader. ------------------------------------------------------------------
+template <typename T>
+class SnapRange {
+public:
+        SnapRange() = default;
+        SnapRange(T const *begin, std::size_t size) :
+                begin_(begin), size_(size) {}
+
+        T const* begin() const { return begin_; }
+        T const* end() const { return begin_ + size_; }
+        std::size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        T const& operator[] (std::size_t i) const { return begin_[i]; }
+private:
+        T const *begin_ = nullptr;
+        std::size_t size_ = 0;
+};
+
+// Non-owning view of a snapshot. The constructor validates the header and
+// the section bounds (throws invalid_snapshot); references found in the
+// payload are range checked on access.
+class SnapshotView {
+public:
+        SnapshotView() = default;
+        SnapshotView(void const *data, std::size_t size);
+        explicit SnapshotView(MappedFile const &file) :
+                SnapshotView(file.data(), file.size()) {}
+
+        SnapshotHeader const& header() const { return *header_; }
+
+        std::string_view prod_id() const { return str(header_->prodId); }
+        std::string_view version() const { return str(header_->version); }
+        std::string_view cal_scale() const { return str(header_->calScale); }
+        std::string_view method() const { return str(header_->method); }
+
+        SnapRange<SnapComponent> components() const { return components_; }
+        SnapRange<SnapProperty> properties(SnapComponent const &c) const;
+
+        std::string_view str(SnapStr const &v) const;
+        SnapRange<SnapStr> list(SnapList const &v) const;
+
+        // Recomputes the payload checksum; O(size of the snapshot).
+        bool verify_payload() const;
+
+private:
+        char const *data_ = nullptr;
+        std::size_t size_ = 0;
+        SnapshotHeader const *header_ = nullptr;
+        std::string_view strings_;
+        SnapRange<SnapStr> lists_;
+        SnapRange<SnapComponent> components_;
+        SnapRange<SnapProperty> properties_;
+};
+
+#endif //SNAPSHOT_HH_INCLUDED_20261018
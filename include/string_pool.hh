@@ -0,0 +1,74 @@
+#ifndef STRING_POOL_HH_INCLUDED_20261018
+#define STRING_POOL_HH_INCLUDED_20261018
+
+// -- String interning. --------------------------------------------------------
+// Feeds repeat the same few strings thousands of times: parameter names,
+// TZIDs, CATEGORIES, LOCATION. Those are stored once in a StringPool, and
+// the calendar holds InternedStrings, which are one pointer each.
+//
+// A pool never frees its strings before it is destroyed, and must outlive
+// every InternedString it returned. StringPool::global() lives as long as
+// the process.
+
+#include <cstddef>
+#include <deque>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+class InternedString {
+public:
+        InternedString();               // the empty string
+
+        std::string const& str() const { return *str_; }
+        operator std::string const&() const { return *str_; }
+        std::string_view view() const { return *str_; }
+        char const* c_str() const { return str_->c_str(); }
+        std::size_t size() const { return str_->size(); }
+        bool empty() const { return str_->empty(); }
+
+        // Equal strings from the same pool share their pointer; strings
+        // from different pools are compared by content.
+        friend bool operator==(InternedString const &a,
+                               InternedString const &b) {
+                return a.str_ == b.str_ || *a.str_ == *b.str_;
+        }
+        friend bool operator!=(InternedString const &a,
+                               InternedString const &b) {
+                return !(a == b);
+        }
+
+private:
+        friend class StringPool;
+        explicit InternedString(std::string const *s) : str_(s) {}
+
+        std::string const *str_;
+};
+
+std::ostream& operator<<(std::ostream& os, InternedString const &v);
+
+class StringPool {
+public:
+        StringPool() = default;
+        StringPool(StringPool const &) = delete;
+        StringPool& operator=(StringPool const &) = delete;
+
+        // Thread-safe.
+        InternedString intern(std::string_view s);
+
+        std::size_t size() const;       // distinct strings
+        std::size_t bytes() const;      // their characters
+
+        static StringPool& global();
+
+private:
+        mutable std::mutex mutex_;
+        std::deque<std::string> strings_;       // never moves its elements
+        // Views into strings_.
+        std::unordered_map<std::string_view, std::string const *> index_;
+        std::size_t bytes_ = 0;
+};
+
+#endif //STRING_POOL_HH_INCLUDED_20261018
@@ -0,0 +1,28 @@
+#ifndef VALUE_FORMAT_HH_INCLUDED_20261018
+#define VALUE_FORMAT_HH_INCLUDED_20261018
+
+// -- Value formats of jCal and xCal. ------------------------------------------
+// RFC 7265, 3.6 and RFC 6321, 3.6 write values alike: dates and times with
+// separators ("2019-03-15T12:00:00Z"), UTC offsets as "+01:00", durations
+// as in RFC 5545. The jCal and xCal writers share these.
+
+#include <string>
+#include <string_view>
+#include "ical.hh"
+
+char const* to_string(Freq v);
+char const* to_string(WeekDay v);
+// "-1SU".
+std::string to_string(WeekDayNum const &v);
+
+void append_value(std::string &out, Date const &v);
+void append_value(std::string &out, DateTime const &v);
+void append_value(std::string &out, UtcOffset const &v);
+void append_value(std::string &out, DurValue const &v);
+
+Date const& date_of(EndDate const &v);
+
+// Property, parameter and component names are lower case in both.
+std::string lower_case(std::string_view v);
+
+#endif //VALUE_FORMAT_HH_INCLUDED_20261018
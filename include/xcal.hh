@@ -0,0 +1,37 @@
+#ifndef XCAL_HH_INCLUDED_20261018
+#define XCAL_HH_INCLUDED_20261018
+
+// -- xCal (RFC 6321). ---------------------------------------------------------
+// Writes a calendar as xCal, element by element into an OutputBuffer, as
+// write_jcal() does for jCal: there is no DOM, and with a sink-backed
+// buffer memory stays bounded however many components there are.
+//
+//     <icalendar xmlns="urn:ietf:params:xml:ns:icalendar-2.0">
+//      <vcalendar><properties>...</properties><components>
+//       <vevent><properties>
+//        <dtstart>
+//         <parameters><tzid><text>Europe/Berlin</text></tzid></parameters>
+//         <date-time>2019-03-15T12:00:00</date-time>
+//        </dtstart>
+//       ...
+//
+// (without the indentation.) Values are formatted as for jCal, TEXT is
+// decoded, and X- and IANA properties are typed as there. The same things
+// the AST does not model yet are left out.
+
+#include <string>
+#include <string_view>
+#include "ical.hh"
+#include "output_buffer.hh"
+
+// A document, from the XML declaration to </icalendar>.
+void write_xcal(OutputBuffer &out, Calendar const &cal);
+// A single component, e.g. from a PushParser.
+void write_xcal(OutputBuffer &out, Component const &c);
+std::string to_xcal(Calendar const &cal);
+
+// `v` as XML character data: "&", "<" and ">" become entity references, and
+// CR a character reference so that it survives end-of-line handling.
+void append_xml_text(OutputBuffer &out, std::string_view v);
+
+#endif //XCAL_HH_INCLUDED_20261018
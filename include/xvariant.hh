@@ -15,9 +15,9 @@ using std::get_if;
 // Variant of variant whose `xvariant(T&& t)` is not implicit.
 // TODO: review noexcepts
 template<class... Types>
-class xvariant : public variant<Types...> {
+class xvariant : public std::variant<Types...> {
 public:
-        using variant = variant<Types...>;
+        using variant = std::variant<Types...>;
 
         constexpr xvariant() : variant() {}
         constexpr xvariant(const xvariant& other) : variant(other) {}
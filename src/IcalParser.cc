@@ -1,4 +1,8 @@
+#include <atomic>
+#include <cctype>
+#include <cstring>
 #include <iostream>
+#include <unordered_map>
 #include "rfc3629.hh"
 #include "rfc3986.hh"
 #include "rfc4288.hh"
@@ -7,7 +11,9 @@
 #include "IcalParser.hh"
 #include "parser_helpers.hh"
 #include "parser_exceptions.hh"
+#include "char_class.hh"
 
+// Tokens are matched case-insensitively, see equal_ignore_case().
 string IcalParser::expect_token(string const &tok) {
         CALLSTACK;
         save_input_pos ptran(*is);
@@ -16,7 +22,7 @@ string IcalParser::expect_token(string const &tok) {
                 if(i == EOF) {
                         throw unexpected_token(is.tellg(), tok);
                 }
-                if(i != c) {
+                if(!equal_ignore_case(i, c)) {
                         throw syntax_error(is.tellg(), tok);
                 }
         }
@@ -26,6 +32,22 @@ string IcalParser::expect_token(string const &tok) {
 
 result<string> IcalParser::token(string const &tok) {
         CALLSTACK;
+        // Fast path: unless a fold interrupts the token, which needs the
+        // character by character match below, the raw bytes are compared
+        // in one go.
+        char buf[32];
+        if (tok.size() <= sizeof(buf)) {
+                save_input_pos ptran(*is);
+                is.absorb_folds();
+                const auto n = static_cast<std::size_t>(
+                        is->rdbuf()->sgetn(buf, tok.size()));
+                if (n == tok.size() && equal_ignore_case(buf, tok.data(), n)) {
+                        ptran.commit();
+                        return tok;
+                }
+                if (!std::memchr(buf, '\r', n) && !std::memchr(buf, '\n', n))
+                        return no_match;
+        }
         try {
                 return expect_token(tok);
         } catch(syntax_error &) {
@@ -81,176 +103,76 @@ result<string> IcalParser::hex() {
         CALLSTACK;
         save_input_pos ptran(*is);
         const auto i = is.get();
-        switch(i) {
-        default:
-        case EOF:
+        if (!is_in(i, cc_hexdig))
                 return no_match;
-        case '0':
-        case '1':
-        case '2':
-        case '3':
-        case '4':
-        case '5':
-        case '6':
-        case '7':
-        case '8':
-        case '9':
-        case 'a':
-        case 'A':
-        case 'b':
-        case 'B':
-        case 'c':
-        case 'C':
-        case 'd':
-        case 'D':
-        case 'e':
-        case 'E':
-        case 'f':
-        case 'F':
-                break;
-        }
-
-        ptran.commit();
-        return string() + (char)i;
+        ptran.commit();
+        return string(1, char(i));
 }
 
 string IcalParser::expect_alpha() {
         CALLSTACK;
-        save_input_pos ptran(*is);
-        const auto i = is.get();
-        switch(i) {
-        default:
-        case EOF:
-                throw syntax_error(is.tellg());
-        case 'a':
-        case 'b':
-        case 'c':
-        case 'd':
-        case 'e':
-        case 'f':
-        case 'g':
-        case 'h':
-        case 'i':
-        case 'j':
-        case 'k':
-        case 'l':
-        case 'm':
-        case 'n':
-        case 'o':
-        case 'p':
-        case 'q':
-        case 'r':
-        case 's':
-        case 't':
-        case 'u':
-        case 'v':
-        case 'w':
-        case 'x':
-        case 'y':
-        case 'z':
-        case 'A':
-        case 'B':
-        case 'C':
-        case 'D':
-        case 'E':
-        case 'F':
-        case 'G':
-        case 'H':
-        case 'I':
-        case 'J':
-        case 'K':
-        case 'L':
-        case 'M':
-        case 'N':
-        case 'O':
-        case 'P':
-        case 'Q':
-        case 'R':
-        case 'S':
-        case 'T':
-        case 'U':
-        case 'V':
-        case 'W':
-        case 'X':
-        case 'Y':
-        case 'Z':
-                break;
-        }
-        ptran.commit();
-        return string() + (char)i;
+        if (auto v = alpha(); is_match(v))
+                return *std::move(v);
+        throw syntax_error(is.tellg());
 }
 
 result<string> IcalParser::alpha() {
         CALLSTACK;
-        try {
-                return expect_alpha();
-        } catch (syntax_error &) {
+        save_input_pos ptran(*is);
+        const auto i = is.get();
+        if (!is_in(i, cc_alpha))
                 return no_match;
-        }
+        ptran.commit();
+        return string(1, char(i));
 }
 
 
 string IcalParser::expect_digit() {
         CALLSTACK;
-        save_input_pos ptran(*is);
-        const auto i = is.get();
-        if (i<'0' || i>'9')
-                throw syntax_error(is.tellg(), "expected digit");
-        ptran.commit();
-        return string() + (char)i;
+        if (auto v = digit(); is_match(v))
+                return *std::move(v);
+        throw syntax_error(is.tellg(), "expected digit");
 }
 
 string IcalParser::expect_digit(int min, int max) {
         CALLSTACK;
-        save_input_pos ptran(*is);
-        const auto i = is.get();
-        if (i<'0'+min || i>'0'+max)
-                throw syntax_error(is.tellg(),
-                                   "expected digit in range [" +
-                                   std::to_string(min) + ".." +
-                                   std::to_string(max) + "]");
-        ptran.commit();
-        return string() + (char)i;
+        if (auto v = digit(min, max); is_match(v))
+                return *std::move(v);
+        throw syntax_error(is.tellg(),
+                           "expected digit in range [" +
+                           std::to_string(min) + ".." +
+                           std::to_string(max) + "]");
 }
 
 result<string> IcalParser::digit() {
         CALLSTACK;
-        try {
-                return expect_digit();
-        } catch (syntax_error &) {
+        save_input_pos ptran(*is);
+        const auto i = is.get();
+        if (!is_in(i, cc_digit))
                 return no_match;
-        }
+        ptran.commit();
+        return string(1, char(i));
 }
 
 result<string> IcalParser::digit(int min, int max) {
         CALLSTACK;
-        try {
-                return expect_digit(min, max);
-        } catch (syntax_error &) {
+        save_input_pos ptran(*is);
+        const auto i = is.get();
+        if (i<'0'+min || i>'0'+max)
                 return no_match;
-        }
+        ptran.commit();
+        return string(1, char(i));
 }
 
 result<string> IcalParser::digits(int at_least, int at_most) {
         CALLSTACK;
         save_input_pos ptran(*is);
-        int c = 0;
-        string ret;
-        while (at_most<0 || c<at_most) {
-                const auto tmp = digit();
-                if (is_error(tmp)) return tmp;
-                if (!is_match(tmp)) break;
-                ++c;
-                ret += *tmp;
-        }
-
-        if (at_least >= 0 && c<at_least)
+        const auto v = lexeme(cc_digit, at_most < 0 ? std::size_t(-1)
+                                                    : std::size_t(at_most));
+        if (at_least >= 0 && v.size() < std::size_t(at_least))
                 return no_match;
-        if (at_most >= 0 && c>at_most)
-                return no_match;
-
         ptran.commit();
-        return ret;
+        return string(v);
 }
 
 result<string> IcalParser::digits(int num) {
@@ -260,24 +182,136 @@ result<string> IcalParser::digits(int num) {
 
 string IcalParser::expect_alnum() {
         CALLSTACK;
-        save_input_pos ptran(*is);
-        if (auto v = alpha(); is_match(v)) {
-                ptran.commit();
-                return *v;
-        } else if (auto v = digit(); is_match(v)) {
-                ptran.commit();
-                return *v;
-        }
+        if (auto v = alnum(); is_match(v))
+                return *std::move(v);
         throw syntax_error(is.tellg(), "expected alpha or digit");
 }
 
 result<string> IcalParser::alnum() {
         CALLSTACK;
-        try {
-                return expect_alnum();
-        } catch (syntax_error &) {
+        save_input_pos ptran(*is);
+        const auto i = is.get();
+        if (!is_in(i, cc_alpha | cc_digit))
                 return no_match;
+        ptran.commit();
+        return string(1, char(i));
+}
+
+std::string_view IcalParser::lexeme(std::uint16_t cls, std::size_t atMost) {
+        CALLSTACK;
+        is.absorb_folds();
+        auto &sb = *is->rdbuf();
+        lexeme_.clear();
+        if (source_ == &sb) {
+                const auto p = source_->cursor();
+                const auto n = run_length(p, source_->limit(), cls, atMost);
+                source_->advance(n);
+                const auto next = sb.sgetc();
+                if (n == atMost || (next != '\r' && next != '\n'))
+                        return {p, n};
+                lexeme_.assign(p, n);
+        } else {
+                append_run(sb, cls, lexeme_, atMost);
+        }
+        // A fold may interrupt the run. One that does not is left alone.
+        while (lexeme_.size() < atMost) {
+                const auto next = sb.sgetc();
+                if (next != '\r' && next != '\n')
+                        break;
+                save_input_pos fold(*is);
+                is.absorb_folds();
+                if (!append_run(sb, cls, lexeme_, atMost - lexeme_.size()))
+                        break;
+                fold.commit();
+        }
+        return lexeme_;
+}
+
+// Hashes the raw source text in [begin, end), see hash_component_text().
+// The stream position is left untouched.
+// -- Memoization. -------------------------------------------------------------
+namespace {
+std::size_t next_memo_id() {
+        static std::atomic<std::size_t> next{0};
+        return next++;
+}
+}
+
+template <typename Result>
+struct IcalParser::MemoTable final : IcalParser::MemoTableBase {
+        struct Entry {
+                Result value;
+                std::streamoff end;
+        };
+        std::unordered_map<std::streamoff, Entry> entries;
+
+        void clear() override { entries.clear(); }
+};
+
+template <auto Rule>
+auto IcalParser::memo() {
+        using Result = decltype((this->*Rule)());
+        if (!options_.memoize)
+                return (this->*Rule)();
+        const std::streamoff pos = is.tellg();
+        if (pos < 0)
+                return (this->*Rule)();
+
+        static const std::size_t id = next_memo_id();
+        if (memo_.size() <= id)
+                memo_.resize(id + 1);
+        if (!memo_[id])
+                memo_[id] = std::make_unique<MemoTable<Result>>();
+        auto &entries = static_cast<MemoTable<Result>&>(*memo_[id]).entries;
+
+        if (auto it = entries.find(pos); it != entries.end()) {
+                is->seekg(it->second.end);
+                return it->second.value;
         }
+        auto ret = (this->*Rule)();
+        const std::streamoff end = is.tellg();
+        if (end >= 0)
+                entries.emplace(pos,
+                        typename MemoTable<Result>::Entry{ret, end});
+        return ret;
+}
+
+// Entries are only ever needed within one component, so they are dropped
+// between components to keep the memory bounded.
+void IcalParser::clear_memo() {
+        for (auto &table : memo_)
+                if (table)
+                        table->clear();
+}
+
+
+ContentHash IcalParser::source_hash(
+        std::istream::pos_type begin,
+        std::istream::pos_type end
+) {
+        CALLSTACK;
+        save_input_pos ptran(*is);
+        string text(static_cast<std::size_t>(end - begin), '\0');
+        is->seekg(begin);
+        is->read(&text[0], text.size());
+        text.resize(static_cast<std::size_t>(is->gcount()));
+        is->clear();
+        return hash_component_text(text);
+}
+
+ParserPos IcalParser::parser_pos() {
+        return parser_pos(
+                is->rdbuf()->pubseekoff(0, std::ios::cur, std::ios::in));
+}
+
+ParserPos IcalParser::parser_pos(std::istream::pos_type pos) {
+        const std::streamoff offset = pos;
+        if (offset < 0)
+                return ParserPos{};
+        if (!lineIndex_)
+                lineIndex_.emplace(*is);
+        const auto where = lineIndex_->locate(offset);
+        return ParserPos{where.line, where.col, offset};
 }
 
 
@@ -351,16 +385,16 @@ result<ContentLine> IcalParser::contentline() {
         save_input_pos ptran(*is);
         ContentLine ret;
 
-        if (auto v = name(); is_match(v)) ret.name = *v;
+        if (auto v = name(); is_match(v)) ret.name = *std::move(v);
         else return no_match;
 
         while (is_match(token(";"))) {
-                if (auto v = param(); is_match(v)) ret.params.push_back(*v);
+                if (auto v = param(); is_match(v)) ret.params.push_back(*std::move(v));
                 else SYNTAX_ERROR("");
         }
         if (!is_match(token(":"))) return SYNTAX_ERROR("");
 
-        if (auto v = value(); is_match(v)) ret.value = *v;
+        if (auto v = value(); is_match(v)) ret.value = *std::move(v);
         else return no_match;
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -375,9 +409,9 @@ result<string> IcalParser::name() {
         save_input_pos ptran(*is);
 
         if (auto v = iana_token(); is_match(v))
-                return *v;
+                return *std::move(v);
         if (auto v = x_name(); is_match(v))
-                return *v;
+                return *std::move(v);
 
         ptran.commit();
         return no_match;
@@ -390,28 +424,20 @@ result<string> IcalParser::iana_token_char() {
         save_input_pos ptran(*is);
         string ret;
 
-        if (auto v = alnum(); is_match(v)) ret = *v;
-        if (auto v = token("-"); is_match(v)) ret = *v;
+        if (auto v = alnum(); is_match(v)) ret = *std::move(v);
+        else if (auto v = token("-"); is_match(v)) ret = *std::move(v);
+        else return no_match;
 
         ptran.commit();
-        return no_match;
+        return ret;
 }
 result<string> IcalParser::iana_token() {
         CALLSTACK;
-        save_input_pos ptran(*is);
-
-        string ret;
-        if (auto v = iana_token_char(); is_match(v)) {
-                ret += *v;
-        } else {
+        const auto v = lexeme(cc_iana);
+        if (v.empty())
                 return no_match;
-        }
-        for (auto v = iana_token_char(); is_match(v); v = iana_token_char()) {
-                ret += *v;
-        }
         // TODO: IANA iCalendar identifiers
-        ptran.commit();
-        return ret;
+        return string(v);
 }
 
 //     vendorid      = 3*(ALPHA / DIGIT)
@@ -420,21 +446,12 @@ result<string> IcalParser::vendorid() {
         CALLSTACK;
         save_input_pos ptran(*is);
 
-        string ret;
-        if (auto v = alnum(); is_match(v)) ret += *v;
-        else return no_match;
-
-        if (auto v = alnum(); is_match(v)) ret += *v;
-        else return no_match;
-
-        if (auto v = alnum(); is_match(v)) ret += *v;
-        else return no_match;
-
-        for (auto v = alnum(); is_match(v); v = alnum())
-                ret += *v;
+        const auto v = lexeme(cc_alpha | cc_digit);
+        if (v.size() < 3)
+                return no_match;
 
         ptran.commit();
-        return ret;
+        return string(v);
 }
 
 //     SAFE-CHAR     = WSP / %x21 / %x23-2B / %x2D-39 / %x3C-7E / NON-US-ASCII
@@ -443,114 +460,15 @@ result<string> IcalParser::safe_char() {
         CALLSTACK;
         {
                 save_input_pos ptran(*is);
-                // WSP
-                if (auto v = read_wsp(*is)) {
-                        ptran.commit();
-                        return *v;
-                }
                 const auto i = is.get();
-                switch (i) {
-                        // %x21
-                case '!':
-                        // %x23-2B
-                case '#':
-                case '$':
-                case '%':
-                case '&':
-                case '\'':
-                case '(':
-                case ')':
-                case '*':
-                case '+':
-                        // %x2D-39
-                case '-':
-                case '.':
-                case '/':
-                case '0':
-                case '1':
-                case '2':
-                case '3':
-                case '4':
-                case '5':
-                case '6':
-                case '7':
-                case '8':
-                case '9':
-                        // %x3C-7E
-                case '<':
-                case '=':
-                case '>':
-                case '?':
-                case '@':
-                case 'A':
-                case 'B':
-                case 'C':
-                case 'D':
-                case 'E':
-                case 'F':
-                case 'G':
-                case 'H':
-                case 'I':
-                case 'J':
-                case 'K':
-                case 'L':
-                case 'M':
-                case 'N':
-                case 'O':
-                case 'P':
-                case 'Q':
-                case 'R':
-                case 'S':
-                case 'T':
-                case 'U':
-                case 'V':
-                case 'W':
-                case 'X':
-                case 'Y':
-                case 'Z':
-                case '[':
-                case '\\':
-                case ']':
-                case '^':
-                case '_':
-                case '`':
-                case 'a':
-                case 'b':
-                case 'c':
-                case 'd':
-                case 'e':
-                case 'f':
-                case 'g':
-                case 'h':
-                case 'i':
-                case 'j':
-                case 'k':
-                case 'l':
-                case 'm':
-                case 'n':
-                case 'o':
-                case 'p':
-                case 'q':
-                case 'r':
-                case 's':
-                case 't':
-                case 'u':
-                case 'v':
-                case 'w':
-                case 'x':
-                case 'y':
-                case 'z':
-                case '{':
-                case '|':
-                case '}':
-                case '~':
+                if (is_in(i, cc_safe)) {
                         ptran.commit();
-                        return string() + char(i);
+                        return string(1, char(i));
                 }
         }
 
         if (auto v = non_us_ascii(); is_match(v))
-                return *v;
+                return *std::move(v);
         return no_match;
 }
 
@@ -560,115 +478,15 @@ result<string> IcalParser::value_char() {
         CALLSTACK;
         {
                 save_input_pos ptran(*is);
-                // WSP
-                if (auto v = read_wsp(*is)) {
-                        ptran.commit();
-                        return *v;
-                }
                 const auto i = is.get();
-                switch (i) {
-                        // %x21-7E
-                case '!':
-                case '"':
-                case '#':
-                case '$':
-                case '%':
-                case '&':
-                case '\'':
-                case '(':
-                case ')':
-                case '*':
-                case '+':
-                case ',':
-                case '-':
-                case '.':
-                case '/':
-                case '0':
-                case '1':
-                case '2':
-                case '3':
-                case '4':
-                case '5':
-                case '6':
-                case '7':
-                case '8':
-                case '9':
-                case ':':
-                case ';':
-                case '<':
-                case '=':
-                case '>':
-                case '?':
-                case '@':
-                case 'A':
-                case 'B':
-                case 'C':
-                case 'D':
-                case 'E':
-                case 'F':
-                case 'G':
-                case 'H':
-                case 'I':
-                case 'J':
-                case 'K':
-                case 'L':
-                case 'M':
-                case 'N':
-                case 'O':
-                case 'P':
-                case 'Q':
-                case 'R':
-                case 'S':
-                case 'T':
-                case 'U':
-                case 'V':
-                case 'W':
-                case 'X':
-                case 'Y':
-                case 'Z':
-                case '[':
-                case '\\':
-                case ']':
-                case '^':
-                case '_':
-                case '`':
-                case 'a':
-                case 'b':
-                case 'c':
-                case 'd':
-                case 'e':
-                case 'f':
-                case 'g':
-                case 'h':
-                case 'i':
-                case 'j':
-                case 'k':
-                case 'l':
-                case 'm':
-                case 'n':
-                case 'o':
-                case 'p':
-                case 'q':
-                case 'r':
-                case 's':
-                case 't':
-                case 'u':
-                case 'v':
-                case 'w':
-                case 'x':
-                case 'y':
-                case 'z':
-                case '{':
-                case '|':
-                case '}':
-                case '~':
+                if (is_in(i, cc_value)) {
                         ptran.commit();
-                        return string() + char(i);
+                        return string(1, char(i));
                 }
         }
 
         if (auto v = non_us_ascii(); is_match(v))
-                return *v;
+                return *std::move(v);
         return no_match;
 }
 
@@ -678,115 +496,15 @@ result<string> IcalParser::qsafe_char() {
         CALLSTACK;
         {
                 save_input_pos ptran(*is);
-                // WSP
-                if (auto v = read_wsp(*is)) {
-                        ptran.commit();
-                        return *v;
-                }
                 const auto i = is.get();
-                switch (i) {
-                        // %x21
-                case '!':
-                        // %x23-7E
-                case '#':
-                case '$':
-                case '%':
-                case '&':
-                case '\'':
-                case '(':
-                case ')':
-                case '*':
-                case '+':
-                case ',':
-                case '-':
-                case '.':
-                case '/':
-                case '0':
-                case '1':
-                case '2':
-                case '3':
-                case '4':
-                case '5':
-                case '6':
-                case '7':
-                case '8':
-                case '9':
-                case ':':
-                case ';':
-                case '<':
-                case '=':
-                case '>':
-                case '?':
-                case '@':
-                case 'A':
-                case 'B':
-                case 'C':
-                case 'D':
-                case 'E':
-                case 'F':
-                case 'G':
-                case 'H':
-                case 'I':
-                case 'J':
-                case 'K':
-                case 'L':
-                case 'M':
-                case 'N':
-                case 'O':
-                case 'P':
-                case 'Q':
-                case 'R':
-                case 'S':
-                case 'T':
-                case 'U':
-                case 'V':
-                case 'W':
-                case 'X':
-                case 'Y':
-                case 'Z':
-                case '[':
-                case '\\':
-                case ']':
-                case '^':
-                case '_':
-                case '`':
-                case 'a':
-                case 'b':
-                case 'c':
-                case 'd':
-                case 'e':
-                case 'f':
-                case 'g':
-                case 'h':
-                case 'i':
-                case 'j':
-                case 'k':
-                case 'l':
-                case 'm':
-                case 'n':
-                case 'o':
-                case 'p':
-                case 'q':
-                case 'r':
-                case 's':
-                case 't':
-                case 'u':
-                case 'v':
-                case 'w':
-                case 'x':
-                case 'y':
-                case 'z':
-                case '{':
-                case '|':
-                case '}':
-                case '~':
+                if (is_in(i, cc_qsafe)) {
                         ptran.commit();
-                        return string() + char(i);
+                        return string(1, char(i));
                 }
         }
 
         if (auto v = non_us_ascii(); is_match(v))
-                return *v;
+                return *std::move(v);
         return no_match;
 }
 
@@ -794,12 +512,17 @@ result<string> IcalParser::qsafe_char() {
 //     ; UTF8-2, UTF8-3, and UTF8-4 are defined in [RFC3629]
 result<string> IcalParser::non_us_ascii() {
         CALLSTACK;
+        save_input_pos ptran(*is);
+        string ret;
+        is.absorb_folds();
 
-        if (auto v = read_utf8_2(*is)) return *v;
-        else if (auto v = read_utf8_3(*is)) return *v;
-        else if (auto v = read_utf8_4(*is)) return *v;
+        if (auto v = read_utf8_2(*is)) ret = *std::move(v);
+        else if (auto v = read_utf8_3(*is)) ret = *std::move(v);
+        else if (auto v = read_utf8_4(*is)) ret = *std::move(v);
+        else return no_match;
 
-        return no_match;
+        ptran.commit();
+        return ret;
 }
 
 //     CONTROL       = %x00-08 / %x0A-1F / %x7F
@@ -807,27 +530,24 @@ result<string> IcalParser::non_us_ascii() {
 result<string> IcalParser::control() {
         CALLSTACK;
         save_input_pos ptran(*is);
-
-        const auto a = is.get();
-
-        const auto A = (a>=0x00) && (a<=0x08);
-        const auto B = (a>=0x0A) && (a<=0x1F);
-        const auto C = (a==0x7F);
-
-        const auto match = A || B || C;
-        if (!match)
+        const auto i = is.get();
+        if (!is_in(i, cc_control))
                 return no_match;
-
         ptran.commit();
-        return string() + char(a);
+        return string(1, char(i));
 }
 
 //     value         = *VALUE-CHAR
 result<string> IcalParser::value() {
         CALLSTACK;
         string ret;
-        for (auto v = value_char(); is_match(v); v = value_char())
-                ret += *v;
+        while (true) {
+                is.absorb_folds();
+                if (append_utf8_run(*is->rdbuf(), cc_value, ret))
+                        continue;
+                if (auto v = value_char(); is_match(v)) ret += *v;
+                else break;
+        }
         return ret;
 }
 
@@ -842,17 +562,17 @@ result<Param> IcalParser::param() {
         save_input_pos ptran(*is);
         Param ret;
 
-        if (auto v = param_name(); is_match(v)) ret.name = *v;
+        if (auto v = param_name(); is_match(v)) ret.name = intern(*v);
         else return no_match;
 
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
-        if (auto v = param_value(); is_match(v)) ret.values.push_back(*v);
+        if (auto v = param_value(); is_match(v)) ret.values.push_back(*std::move(v));
         else return SYNTAX_ERROR("");
 
         for (auto v = token(","); is_match(v); v = token(",")) {
                 if (auto v = param_value(); is_match(v))
-                        ret.values.push_back(*v);
+                        ret.values.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         ptran.commit();
@@ -863,9 +583,9 @@ result<Param> IcalParser::param() {
 result<string> IcalParser::param_name() {
         CALLSTACK;
         if (auto v = iana_token(); is_match(v))
-                return *v;
+                return *std::move(v);
         if (auto v = x_name(); is_match(v))
-                return *v;
+                return *std::move(v);
         throw syntax_error(is.tellg(), "expected param-name");
 }
 
@@ -880,10 +600,10 @@ result<string> IcalParser::param_value() {
         //       will successfully return an empty string.
         //       Therefore, we switched it here.
         if (auto v = quoted_string(); is_match(v))  {
-                return *v;
+                return *std::move(v);
         }
         if (auto v = paramtext(); is_match(v)) {
-                return *v;
+                return *std::move(v);
         }
         return no_match;
 }
@@ -892,8 +612,13 @@ result<string> IcalParser::param_value() {
 result<string> IcalParser::paramtext() {
         CALLSTACK;
         string ret;
-        for (auto v = safe_char(); is_match(v); v = safe_char())
-                ret += *v;
+        while (true) {
+                is.absorb_folds();
+                if (append_utf8_run(*is->rdbuf(), cc_safe, ret))
+                        continue;
+                if (auto v = safe_char(); is_match(v)) ret += *v;
+                else break;
+        }
         return ret;
 }
 
@@ -906,8 +631,12 @@ result<string> IcalParser::quoted_string() {
                 return no_match;
 
         string ret;
-        for (auto v = qsafe_char(); is_match(v); v = qsafe_char()) {
-                ret += *v;
+        while (true) {
+                is.absorb_folds();
+                if (append_utf8_run(*is->rdbuf(), cc_qsafe, ret))
+                        continue;
+                if (auto v = qsafe_char(); is_match(v)) ret += *v;
+                else break;
         }
 
         if (!is_match(dquote()))
@@ -936,7 +665,9 @@ result<Calendar> IcalParser::icalobject() {
         if (!is_match(key_value_newline("BEGIN", "VCALENDAR")))
                 return no_match;
         if (auto v = icalbody(); is_match(v))
-                ret = *v;
+                ret = *std::move(v);
+        else if (is_error(v))
+                return v;
         if (!is_match(key_value_newline("END", "VCALENDAR")))
                 return SYNTAX_ERROR("");
         ptran.commit();
@@ -950,15 +681,16 @@ result<Calendar> IcalParser::icalbody() {
         save_input_pos ptran(*is);
         Calendar ret;
 
-        std::cerr << "expect_icalbody: parsing calprops ...\n";
-        if (auto v = calprops(); is_match(v)) ret.properties = *v;
+        // std::cerr << "expect_icalbody: parsing calprops ...\n";
+        if (auto v = calprops(); is_match(v)) ret.properties = *std::move(v);
         else return SYNTAX_ERROR("");
 
-        std::cerr << "expect_icalbody: parsing components ...\n";
-        if (auto v = component(); is_match(v)) ret.components = *v;
+        // std::cerr << "expect_icalbody: parsing components ...\n";
+        if (auto v = component(); is_match(v)) ret.components = *std::move(v);
+        else if (is_error(v)) return get<ParsingError>(v);
         else return SYNTAX_ERROR("");
 
-        std::cerr << "expect_icalbody: done\n";
+        // std::cerr << "expect_icalbody: done\n";
         ptran.commit();
         return ret;
 }
@@ -992,14 +724,16 @@ result<CalProps> IcalParser::calprops() {
 
         while (true) {
                 if (auto val = prodid(); is_match(val)) {
-                        ret.prodId = *val;
+                        ret.prodId = *std::move(val);
                         ++prodidc;
                 } else if (auto val = version(); is_match(val)) {
-                        // ret.version = ...
+                        ret.version = *std::move(val);
                         ++versionc;
                 } else if (auto val = calscale(); is_match(val)) {
+                        ret.calScale = *std::move(val);
                         ++calscalec;
                 } else if (auto val = method(); is_match(val)) {
+                        ret.method = *std::move(val);
                         ++methodc;
                 } else if (auto val = x_prop(); is_match(val)) {
                 } else if (auto val = iana_prop(); is_match(val)) {
@@ -1019,12 +753,12 @@ result<ProdId> IcalParser::prodid() {
 
         if (!is_match(token("PRODID"))) return no_match;
 
-        if (auto v = pidparam(); is_match(v)) ret.params = *v;
+        if (auto v = pidparam(); is_match(v)) ret.params = *std::move(v);
         else return SYNTAX_ERROR("");
 
-        if (is_match(token(":"))) return SYNTAX_ERROR("");
+        if (!is_match(token(":"))) return SYNTAX_ERROR("");
 
-        if (auto v = pidvalue(); is_match(v)) ret.value = *v;
+        if (auto v = pidvalue(); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -1041,12 +775,12 @@ result<Version> IcalParser::version() {
 
         if (!is_match(token("VERSION"))) return no_match;
 
-        if (auto v = verparam(); is_match(v)) ret.params = *v;
+        if (auto v = verparam(); is_match(v)) ret.params = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");
 
-        if (auto v = vervalue(); is_match(v)) ret.value = *v;
+        if (auto v = vervalue(); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -1061,7 +795,7 @@ result<std::vector<OtherParam>> IcalParser::verparam() {
         save_input_pos ptran(*is);
         std::vector<OtherParam> ret;
         while(is_match(token(";"))) {
-                if (auto v = other_param(); is_match(v)) ret.push_back(*v);
+                if (auto v = other_param(); is_match(v)) ret.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         ptran.commit();
@@ -1089,12 +823,12 @@ result<CalScale> IcalParser::calscale() {
         CalScale ret;
         if (!is_match(token("CALSCALE"))) return no_match;
 
-        if (auto v = calparam(); is_match(v)) ret.params = *v;
+        if (auto v = calparam(); is_match(v)) ret.params = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");
 
-        if (auto v = calvalue(); is_match(v)) ret.value = *v;
+        if (auto v = calvalue(); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -1109,7 +843,7 @@ result<vector<OtherParam>> IcalParser::calparam() {
         save_input_pos ptran(*is);
         vector<OtherParam> ret;
         while (is_match(token(";"))) {
-                if (auto v = other_param(); is_match(v)) ret.push_back(*v);
+                if (auto v = other_param(); is_match(v)) ret.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         ptran.commit();
@@ -1120,7 +854,7 @@ result<vector<OtherParam>> IcalParser::calparam() {
 result<string> IcalParser::calvalue() {
         CALLSTACK;
         if (auto v = token("GREGORIAN"); is_match(v))
-                return *v;
+                return *std::move(v);
         return no_match;
 }
 
@@ -1132,12 +866,12 @@ result<Method> IcalParser::method() {
 
         if (!is_match(token("METHOD"))) return no_match;
 
-        if (auto v = metparam(); is_match(v)) ret.params = *v;
+        if (auto v = metparam(); is_match(v)) ret.params = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");
 
-        if (auto v = metvalue(); is_match(v)) ret.value = *v;
+        if (auto v = metvalue(); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -1151,7 +885,7 @@ result<std::vector<OtherParam>> IcalParser::metparam() {
         save_input_pos ptran(*is);
         vector<OtherParam> ret;
         while (is_match(token(";"))) {
-                if (auto v = other_param(); is_match(v)) ret.push_back(*v);
+                if (auto v = other_param(); is_match(v)) ret.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         ptran.commit();
@@ -1161,7 +895,7 @@ result<std::vector<OtherParam>> IcalParser::metparam() {
 //       metvalue   = iana-token
 result<string> IcalParser::metvalue() {
         CALLSTACK;
-        if (auto v = iana_token(); is_match(v)) return *v;
+        if (auto v = iana_token(); is_match(v)) return *std::move(v);
         else return no_match;
 }
 
@@ -1170,17 +904,17 @@ result<XProp> IcalParser::x_prop() {
         CALLSTACK;
         save_input_pos ptran(*is);
         XProp ret;
-        if (auto v = x_name(); is_match(v)) ret.name = *v;
+        if (auto v = x_name(); is_match(v)) ret.name = intern(*v);
         else return no_match;
 
         while (is_match(token(";"))) {
                 if (auto v = icalparameter(); is_match(v))
-                        ret.params.push_back(*v);
+                        ret.params.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         if (!is_match(token(":"))) return SYNTAX_ERROR("");
 
-        if (auto v = value(); is_match(v)) ret.value = *v;
+        if (auto v = value(); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -1206,30 +940,21 @@ result<string> IcalParser::x_name() {
         }
 
         // [vendorid "-"]
-        if (auto v = vendorid(); is_match(v)) {
-                ret += *v;
-
-                if (auto v = token("-"); is_match(v)) ret += *v;
-                else SYNTAX_ERROR("");
+        {
+                save_input_pos vtran(*is);
+                if (auto v = vendorid(); is_match(v)) {
+                        if (auto h = token("-"); is_match(h)) {
+                                ret += *v + *h;
+                                vtran.commit();
+                        }
+                }
         }
 
         // 1*(ALPHA / DIGIT / "-")
-        if (auto v = alnum(); is_match(v)) {
-                ret += *v;
-        } else if (auto v = token("-"); is_match(v)) {
-                ret += *v;
-        } else {
+        const auto v = lexeme(cc_iana);
+        if (v.empty())
                 return SYNTAX_ERROR("");
-        }
-        while (true) {
-                if (auto v = alnum(); is_match(v)) {
-                        ret += *v;
-                } else if (auto v = token("-"); is_match(v)) {
-                        ret += *v;
-                } else {
-                        break;
-                }
-        }
+        ret += v;
 
         ptran.commit();
         return ret;
@@ -1241,18 +966,22 @@ result<IanaProp> IcalParser::iana_prop() {
         save_input_pos ptran(*is);
         IanaProp ret;
 
-        if (auto v = iana_token(); is_match(v)) ret.ianaToken = *v;
-        else no_match;
+        if (auto v = iana_token(); is_match(v)) ret.ianaToken = *std::move(v);
+        else return no_match;
+        // Component delimiters are not properties.
+        if (equal_ignore_case(ret.ianaToken, "BEGIN") ||
+            equal_ignore_case(ret.ianaToken, "END"))
+                return no_match;
 
         while (is_match(token(";"))) {
                 if (auto v = icalparameter(); is_match(v))
-                        ret.params.push_back(*v);
+                        ret.params.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");
 
-        if (auto v = value(); is_match(v)) ret.value = *v;
+        if (auto v = value(); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -1267,7 +996,7 @@ result<std::vector<OtherParam>> IcalParser::pidparam() {
         save_input_pos ptran(*is);
         vector<OtherParam> ret;
         while (is_match(token(";"))) {
-                if (auto v = other_param(); is_match(v)) ret.push_back(*v);
+                if (auto v = other_param(); is_match(v)) ret.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         ptran.commit();
@@ -1319,119 +1048,16 @@ result<string> IcalParser::tsafe_char() {
         CALLSTACK;
         {
                 save_input_pos ptran(*is);
-                // WSP
-                if (auto c = read_wsp(*is)) {
-                        ptran.commit();
-                        return *c;
-                }
                 const auto i = is.get();
-                switch (i) {
-                        // %x21
-                case '!':
-
-                        // %x23-2B
-                case '#':
-                case '$':
-                case '%':
-                case '&':
-                case '\'':
-                case '(':
-                case ')':
-                case '*':
-                case '+':
-
-                        // %x2D-39
-                case '-':
-                case '.':
-                case '/':
-                case '0':
-                case '1':
-                case '2':
-                case '3':
-                case '4':
-                case '5':
-                case '6':
-                case '7':
-                case '8':
-                case '9':
-
-                        // %x3C-5B
-                case '<':
-                case '=':
-                case '>':
-                case '?':
-                case '@':
-                case 'A':
-                case 'B':
-                case 'C':
-                case 'D':
-                case 'E':
-                case 'F':
-                case 'G':
-                case 'H':
-                case 'I':
-                case 'J':
-                case 'K':
-                case 'L':
-                case 'M':
-                case 'N':
-                case 'O':
-                case 'P':
-                case 'Q':
-                case 'R':
-                case 'S':
-                case 'T':
-                case 'U':
-                case 'V':
-                case 'W':
-                case 'X':
-                case 'Y':
-                case 'Z':
-                case '[':
-
-                        // %x5D-7E
-                case ']':
-                case '^':
-                case '_':
-                case '`':
-                case 'a':
-                case 'b':
-                case 'c':
-                case 'd':
-                case 'e':
-                case 'f':
-                case 'g':
-                case 'h':
-                case 'i':
-                case 'j':
-                case 'k':
-                case 'l':
-                case 'm':
-                case 'n':
-                case 'o':
-                case 'p':
-                case 'q':
-                case 'r':
-                case 's':
-                case 't':
-                case 'u':
-                case 'v':
-                case 'w':
-                case 'x':
-                case 'y':
-                case 'z':
-                case '{':
-                case '|':
-                case '}':
-                case '~':
+                if (is_in(i, cc_tsafe)) {
                         ptran.commit();
-                        return string() + (char) i;
+                        return string(1, char(i));
                 }
         }
 
         if (auto v = non_us_ascii(); is_match(v))
-                return *v;
-        return no_match; // error
+                return *std::move(v);
+        return no_match;
 }
 
 
@@ -1440,10 +1066,10 @@ result<string> IcalParser::tsafe_char() {
 //
 result<string> IcalParser::text_char() {
         CALLSTACK;
-        if (auto v = tsafe_char(); is_match(v)) return *v;
-        if (auto v = token(":"); is_match(v)) return *v;
-        if (auto v = dquote(); is_match(v)) return *v;
-        if (auto v = escaped_char(); is_match(v)) return *v;
+        if (auto v = tsafe_char(); is_match(v)) return *std::move(v);
+        if (auto v = token(":"); is_match(v)) return *std::move(v);
+        if (auto v = dquote(); is_match(v)) return *std::move(v);
+        if (auto v = escaped_char(); is_match(v)) return *std::move(v);
         return no_match;
 }
 
@@ -1451,8 +1077,24 @@ result<string> IcalParser::text() {
         CALLSTACK;
         save_input_pos ptran(*is);
         string ret;
-        for (auto c = text_char(); is_match(c); c = text_char()) {
-                ret += *c;
+        auto &sb = *is->rdbuf();
+        while (true) {
+                is.absorb_folds();
+                if (append_utf8_run(sb, cc_tsafe, ret))
+                        continue;
+                // ESCAPED-CHAR is kept as it is, see Text.
+                const auto c = sb.sgetc();
+                if (c == ':' || c == '"') {
+                        ret += char(c);
+                        sb.sbumpc();
+                } else if (c == '\\') {
+                        if (auto v = escaped_char(); is_match(v)) ret += *v;
+                        else break;
+                } else if (auto v = text_char(); is_match(v)) {
+                        ret += *v;
+                } else {
+                        break;
+                }
         }
         ptran.commit();
         return ret;
@@ -1486,23 +1128,15 @@ result<string> IcalParser::float_() {
         else if (auto v = token("-"); is_match(v)) ret += *v;
 
         // 1*DIGIT
-        if (auto v = digit(); is_match(v)) ret += *v;
+        if (auto v = lexeme(cc_digit); !v.empty()) ret += v;
         else return no_match;
 
-        for (auto v = digit(); is_match(v); v = digit()) {
-                ret += *v;
-        }
-
         // ["." 1*DIGIT]
         if (auto v = token("."); is_match(v)) {
                 ret += *v;
 
-                if (auto v = digit(); is_match(v)) ret += *v;
+                if (auto v = lexeme(cc_digit); !v.empty()) ret += v;
                 else return no_match;
-
-                for (auto v = digit(); is_match(v); v = digit()) {
-                        ret += *v;
-                }
         }
 
         ptran.commit();
@@ -1520,12 +1154,9 @@ result<int> IcalParser::integer() {
         else if (auto v = token("-"); is_match(v)) raw += *v;
 
         // 1*DIGIT
-        if (auto v = digit(); is_match(v)) raw += *v;
+        if (auto v = lexeme(cc_digit); !v.empty()) raw += v;
         else return no_match;
 
-        for (auto v = digit(); is_match(v); v = digit()) {
-                raw += *v;
-        }
         const auto ret = std::stoi(raw);
         ptran.commit();
         return ret;
@@ -1537,11 +1168,11 @@ result<string> IcalParser::actionvalue() {
         save_input_pos ptran(*is);
         string ret;
 
-        if (auto v = token("AUDIO"); is_match(v)) ret = *v;
-        else if (auto v = token("DISPLAY"); is_match(v)) ret = *v;
-        else if (auto v = token("EMAIL"); is_match(v)) ret = *v;
-        else if (auto v = iana_token(); is_match(v)) ret = *v;
-        else if (auto v = x_name(); is_match(v)) ret = *v;
+        if (auto v = token("AUDIO"); is_match(v)) ret = *std::move(v);
+        else if (auto v = token("DISPLAY"); is_match(v)) ret = *std::move(v);
+        else if (auto v = token("EMAIL"); is_match(v)) ret = *std::move(v);
+        else if (auto v = iana_token(); is_match(v)) ret = *std::move(v);
+        else if (auto v = x_name(); is_match(v)) ret = *std::move(v);
         else return no_match;
 
         ptran.commit();
@@ -1554,7 +1185,7 @@ result<ActionParam> IcalParser::actionparam() {
         ActionParam ret;
         while (is_match(token(";"))) {
                 if (auto v = other_param(); is_match(v))
-                        ret.params.push_back(*v);
+                        ret.params.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         ptran.commit();
@@ -1567,12 +1198,12 @@ result<Action> IcalParser::action() {
         Action ret;
         if (!is_match(token("ACTION"))) return no_match;
 
-        if (auto v = actionparam(); is_match(v)) ret.params = *v;
+        if (auto v = actionparam(); is_match(v)) ret.params = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");;
 
-        if (auto v = actionvalue(); is_match(v)) ret.value = *v;
+        if (auto v = actionvalue(); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -1611,8 +1242,8 @@ result<TrigAbs> IcalParser::trigabs() {
                         }
                 }
 
-                if (auto v = other_param(); is_match(v)) {
-                        ret.params.push_back(*v);
+                if (auto v = memo<&IcalParser::other_param>(); is_match(v)) {
+                        ret.params.push_back(*std::move(v));
                 } else {
                         return SYNTAX_ERROR("");
                 }
@@ -1620,7 +1251,7 @@ result<TrigAbs> IcalParser::trigabs() {
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");;
 
-        if (auto v = date_time(); is_match(v)) ret.dateTime = *v;
+        if (auto v = date_time(); is_match(v)) ret.dateTime = *std::move(v);
         else return SYNTAX_ERROR("");
 
         ptran.commit();
@@ -1660,9 +1291,9 @@ result<TrigRel> IcalParser::trigrel() {
                 }
 
                 if (auto v = trigrelparam(); is_match(v)) {
-                        ret.trigRelParam = *v;
-                } else if (auto v = other_param(); is_match(v)) {
-                        ret.params.push_back(*v);
+                        ret.trigRelParam = *std::move(v);
+                } else if (auto v = memo<&IcalParser::other_param>(); is_match(v)) {
+                        ret.params.push_back(*std::move(v));
                 } else {
                         return SYNTAX_ERROR("");
                 }
@@ -1670,7 +1301,7 @@ result<TrigRel> IcalParser::trigrel() {
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");;
 
-        if (auto v = dur_value(); is_match(v)) ret.durValue = *v;
+        if (auto v = dur_value(); is_match(v)) ret.durValue = *std::move(v);
         else return SYNTAX_ERROR("");
 
         ptran.commit();
@@ -1684,8 +1315,8 @@ result<Trigger> IcalParser::trigger() {
 
         if (!is_match(token("TRIGGER"))) return no_match;
 
-        if (auto v = trigrel(); is_match(v)) ret = *v;
-        else if (auto v = trigabs(); is_match(v)) ret = *v;
+        if (auto v = trigrel(); is_match(v)) ret = *std::move(v);
+        else if (auto v = trigabs(); is_match(v)) ret = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -1701,7 +1332,7 @@ result<RepParam> IcalParser::repparam() {
         RepParam ret;
         while (is_match(token(";"))) {
                 if (auto v = other_param(); is_match(v))
-                        ret.params.push_back(*v);
+                        ret.params.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         ptran.commit();
@@ -1716,12 +1347,12 @@ result<Repeat> IcalParser::repeat() {
 
         if (!is_match(token("REPEAT"))) return no_match;
 
-        if (auto v = repparam(); is_match(v)) ret.params = *v;
+        if (auto v = repparam(); is_match(v)) ret.params = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");;
 
-        if (auto v = integer(); is_match(v)) ret.value = *v;
+        if (auto v = integer(); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR(""); // error
@@ -1761,24 +1392,24 @@ result<AudioProp> IcalParser::audioprop() {
 
         bool req_act = false, req_trig = false;
         while(true) {
-                if (auto v = action(); is_match(v)) {
+                if (auto v = memo<&IcalParser::action>(); is_match(v)) {
                         req_act = true;
-                        ret.action = *v;
+                        ret.action = *std::move(v);
                 }
-                else if (auto v = trigger(); is_match(v)) {
+                else if (auto v = memo<&IcalParser::trigger>(); is_match(v)) {
                         req_trig = true;
-                        ret.trigger = *v;
+                        ret.trigger = *std::move(v);
                 }
-                else if (auto v = duration(); is_match(v))
-                        ret.duration = *v;
-                else if (auto v = repeat(); is_match(v))
-                        ret.repeat = *v;
-                else if (auto v = attach(); is_match(v))
-                        ret.attach = *v;
-                else if (auto v = x_prop(); is_match(v))
-                        ret.xProps.push_back(*v);
-                else if (auto v = iana_prop(); is_match(v))
-                        ret.ianaProps.push_back(*v);
+                else if (auto v = memo<&IcalParser::duration>(); is_match(v))
+                        ret.duration = *std::move(v);
+                else if (auto v = memo<&IcalParser::repeat>(); is_match(v))
+                        ret.repeat = *std::move(v);
+                else if (auto v = memo<&IcalParser::attach>(); is_match(v))
+                        ret.attach = *std::move(v);
+                else if (auto v = memo<&IcalParser::x_prop>(); is_match(v))
+                        ret.xProps.push_back(*std::move(v));
+                else if (auto v = memo<&IcalParser::iana_prop>(); is_match(v))
+                        ret.ianaProps.push_back(*std::move(v));
                 else break;
         }
         // std::cerr << "audioprop:" << std::endl;
@@ -1816,28 +1447,28 @@ result<DispProp> IcalParser::dispprop() {
 
         bool req_act = false, req_desc = false, req_trig = false;
         while(true) {
-                if (auto v = action(); is_match(v)) {
+                if (auto v = memo<&IcalParser::action>(); is_match(v)) {
                         req_act = true;
-                        ret.action = *v;
+                        ret.action = *std::move(v);
                 }
-                else if (auto v = description(); is_match(v)) {
+                else if (auto v = memo<&IcalParser::description>(); is_match(v)) {
                         req_desc = true;
-                        ret.description = *v;
+                        ret.description = *std::move(v);
                 }
-                else if (auto v = trigger(); is_match(v)) {
+                else if (auto v = memo<&IcalParser::trigger>(); is_match(v)) {
                         req_trig = true;
-                        ret.trigger = *v;
+                        ret.trigger = *std::move(v);
                 }
 
-                else if (auto v = duration(); is_match(v))
-                        ret.duration = *v;
-                else if (auto v = repeat(); is_match(v))
-                        ret.repeat = *v;
+                else if (auto v = memo<&IcalParser::duration>(); is_match(v))
+                        ret.duration = *std::move(v);
+                else if (auto v = memo<&IcalParser::repeat>(); is_match(v))
+                        ret.repeat = *std::move(v);
 
-                else if (auto v = x_prop(); is_match(v))
-                        ret.xProps.push_back(*v);
-                else if (auto v = iana_prop(); is_match(v))
-                        ret.ianaProps.push_back(*v);
+                else if (auto v = memo<&IcalParser::x_prop>(); is_match(v))
+                        ret.xProps.push_back(*std::move(v));
+                else if (auto v = memo<&IcalParser::iana_prop>(); is_match(v))
+                        ret.ianaProps.push_back(*std::move(v));
 
                 else break;
         }
@@ -1888,37 +1519,37 @@ result<EmailProp> IcalParser::emailprop() {
              req_trig = false,
              req_summ = false;
         while(true) {
-                if (auto v = action(); is_match(v)) {
+                if (auto v = memo<&IcalParser::action>(); is_match(v)) {
                         req_act = true;
-                        ret.action = *v;
+                        ret.action = *std::move(v);
                 }
-                else if (auto v = description(); is_match(v)) {
+                else if (auto v = memo<&IcalParser::description>(); is_match(v)) {
                         req_desc = true;
-                        ret.description = *v;
+                        ret.description = *std::move(v);
                 }
-                else if (auto v = trigger(); is_match(v)) {
+                else if (auto v = memo<&IcalParser::trigger>(); is_match(v)) {
                         req_trig = true;
-                        ret.trigger = *v;
+                        ret.trigger = *std::move(v);
                 }
-                else if (auto v = summary(); is_match(v)) {
+                else if (auto v = memo<&IcalParser::summary>(); is_match(v)) {
                         req_summ = true;
-                        ret.summary = *v;
+                        ret.summary = *std::move(v);
                 }
 
-                else if (auto v = attendee(); is_match(v))
-                        ret.attendee = *v;
+                else if (auto v = memo<&IcalParser::attendee>(); is_match(v))
+                        ret.attendee = *std::move(v);
 
-                else if (auto v = duration(); is_match(v))
-                        ret.duration = *v;
-                else if (auto v = repeat(); is_match(v))
-                        ret.repeat = *v;
+                else if (auto v = memo<&IcalParser::duration>(); is_match(v))
+                        ret.duration = *std::move(v);
+                else if (auto v = memo<&IcalParser::repeat>(); is_match(v))
+                        ret.repeat = *std::move(v);
 
-                else if (auto v = attach(); is_match(v))
-                        ret.attach.push_back(*v);
-                else if (auto v = x_prop(); is_match(v))
-                        ret.xProps.push_back(*v);
-                else if (auto v = iana_prop(); is_match(v))
-                        ret.ianaProps.push_back(*v);
+                else if (auto v = memo<&IcalParser::attach>(); is_match(v))
+                        ret.attach.push_back(*std::move(v));
+                else if (auto v = memo<&IcalParser::x_prop>(); is_match(v))
+                        ret.xProps.push_back(*std::move(v));
+                else if (auto v = memo<&IcalParser::iana_prop>(); is_match(v))
+                        ret.ianaProps.push_back(*std::move(v));
 
                 else break;
         }
@@ -1952,9 +1583,9 @@ result<Alarm> IcalParser::alarmc() {
         // because the required fields overlap, so we check for most
         // specialized first.
 
-        if (auto v = emailprop(); is_match(v)) ret = *v;
-        else if (auto v = dispprop(); is_match(v)) ret = *v;
-        else if (auto v = audioprop(); is_match(v)) ret = *v;
+        if (auto v = emailprop(); is_match(v)) ret = *std::move(v);
+        else if (auto v = dispprop(); is_match(v)) ret = *std::move(v);
+        else if (auto v = audioprop(); is_match(v)) ret = *std::move(v);
         else return SYNTAX_ERROR("Must have audioprop, dispprop or emailprop");
 
         if (!is_match(key_value_newline("END", "VALARM")))
@@ -1989,13 +1620,13 @@ result<Date> IcalParser::date_value() {
         save_input_pos ptran(*is);
         Date ret;
 
-        if (auto v = date_fullyear(); is_match(v)) ret.year = *v;
+        if (auto v = date_fullyear(); is_match(v)) ret.year = *std::move(v);
         else return no_match;
 
-        if (auto v = date_month(); is_match(v)) ret.month = *v;
+        if (auto v = date_month(); is_match(v)) ret.month = *std::move(v);
         else return no_match;
 
-        if (auto v = date_mday(); is_match(v)) ret.day = *v;
+        if (auto v = date_mday(); is_match(v)) ret.day = *std::move(v);
         else return no_match;
 
         ptran.commit();
@@ -2013,7 +1644,7 @@ result<TimeHour> IcalParser::time_hour() {
         CALLSTACK;
         save_input_pos ptran(*is);
         TimeHour ret;
-        if (auto v = digits(2); is_match(v)) ret.value = *v;
+        if (auto v = digits(2); is_match(v)) ret.value = *std::move(v);
         else return no_match;
         ptran.commit();
         return ret;
@@ -2024,7 +1655,7 @@ result<TimeMinute> IcalParser::time_minute() {
         CALLSTACK;
         save_input_pos ptran(*is);
         TimeMinute ret;
-        if (auto v = digits(2); is_match(v)) ret.value = *v;
+        if (auto v = digits(2); is_match(v)) ret.value = *std::move(v);
         else return no_match;
         ptran.commit();
         return ret;
@@ -2036,7 +1667,7 @@ result<TimeSecond> IcalParser::time_second() {
         CALLSTACK;
         save_input_pos ptran(*is);
         TimeSecond ret;
-        if (auto v = digits(2); is_match(v)) ret.value = *v;
+        if (auto v = digits(2); is_match(v)) ret.value = *std::move(v);
         else return no_match;
         ptran.commit();
         return ret;
@@ -2054,16 +1685,16 @@ result<Time> IcalParser::time() {
         save_input_pos ptran(*is);
         Time ret;
 
-        if (auto v = time_hour(); is_match(v)) ret.hour = *v;
+        if (auto v = time_hour(); is_match(v)) ret.hour = *std::move(v);
         else return no_match;
 
-        if (auto v = time_minute(); is_match(v)) ret.minute = *v;
+        if (auto v = time_minute(); is_match(v)) ret.minute = *std::move(v);
         else return no_match;
 
-        if (auto v = time_second(); is_match(v)) ret.second = *v;
+        if (auto v = time_second(); is_match(v)) ret.second = *std::move(v);
         else return no_match;
 
-        if (auto v = time_utc(); is_match(v)) ret.utc = *v;
+        if (auto v = time_utc(); is_match(v)) ret.utc = *std::move(v);
 
         ptran.commit();
         return ret;
@@ -2076,12 +1707,12 @@ result<DateTime> IcalParser::date_time() {
         save_input_pos ptran(*is);
         DateTime ret;
 
-        if (auto v = date(); is_match(v)) ret.date = *v;
+        if (auto v = memo<&IcalParser::date>(); is_match(v)) ret.date = *std::move(v);
         else return no_match;
 
         if (!is_match(token("T"))) return no_match;
 
-        if (auto v = time(); is_match(v)) ret.time = *v;
+        if (auto v = time(); is_match(v)) ret.time = *std::move(v);
         else return no_match;
 
         ptran.commit();
@@ -2094,7 +1725,7 @@ result<DurWeek> IcalParser::dur_week() {
         save_input_pos ptran(*is);
         DurWeek ret;
 
-        if (auto v = digits(1, -1); is_match(v)) ret.value = *v;
+        if (auto v = digits(1, -1); is_match(v)) ret.value = *std::move(v);
         else return no_match;
 
         if (!is_match(token("W"))) return no_match;
@@ -2109,7 +1740,7 @@ result<DurSecond> IcalParser::dur_second() {
         save_input_pos ptran(*is);
         DurSecond ret;
 
-        if (auto v = digits(1, -1); is_match(v)) ret.second = *v;
+        if (auto v = digits(1, -1); is_match(v)) ret.second = *std::move(v);
         else return no_match;
 
         if (!is_match(token("S"))) return no_match;
@@ -2124,12 +1755,12 @@ result<DurMinute> IcalParser::dur_minute() {
         save_input_pos ptran(*is);
         DurMinute ret;
 
-        if (auto v = digits(1, -1); is_match(v)) ret.minute = *v;
+        if (auto v = digits(1, -1); is_match(v)) ret.minute = *std::move(v);
         else return no_match;
 
         if (!is_match(token("M"))) return no_match;
 
-        if (auto v = dur_second(); is_match(v)) ret.second = *v;
+        if (auto v = dur_second(); is_match(v)) ret.second = *std::move(v);
 
         ptran.commit();
         return ret;
@@ -2141,12 +1772,12 @@ result<DurHour> IcalParser::dur_hour() {
         save_input_pos ptran(*is);
         DurHour ret;
 
-        if (auto v = digits(1, -1); is_match(v)) ret.hour = *v;
+        if (auto v = digits(1, -1); is_match(v)) ret.hour = *std::move(v);
         else return no_match;
 
         if (!is_match(token("H"))) return no_match;
 
-        if (auto v = dur_minute(); is_match(v)) ret.minute = *v;
+        if (auto v = dur_minute(); is_match(v)) ret.minute = *std::move(v);
 
         ptran.commit();
         return ret;
@@ -2176,13 +1807,13 @@ result<DurTime> IcalParser::dur_time() {
         if (!is_match(token("T"))) return no_match;
 
         if (auto v = dur_hour(); is_match(v)) {
-                ret = *v;
+                ret = *std::move(v);
         }
         else if (auto v = dur_minute(); is_match(v)) {
-                ret = *v;
+                ret = *std::move(v);
         }
         else if (auto v = dur_second(); is_match(v)) {
-                ret = *v;
+                ret = *std::move(v);
         }
         else {
                 return no_match;
@@ -2197,10 +1828,10 @@ result<DurDate> IcalParser::dur_date() {
         save_input_pos ptran(*is);
         DurDate ret;
 
-        if (auto v = dur_day(); is_match(v)) ret.day = *v;
+        if (auto v = dur_day(); is_match(v)) ret.day = *std::move(v);
         else return no_match;
 
-        if (auto v = dur_time(); is_match(v)) ret.time = *v;
+        if (auto v = dur_time(); is_match(v)) ret.time = *std::move(v);
 
         ptran.commit();
         return ret;
@@ -2218,13 +1849,13 @@ result<DurValue> IcalParser::dur_value() {
         if (!is_match(token("P"))) return no_match; // error
 
         if (auto v = dur_date(); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         }
         else if (auto v = dur_time(); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         }
         else if (auto v = dur_week(); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         }
         else return SYNTAX_ERROR("");
 
@@ -2282,8 +1913,8 @@ bool IcalParser::period() {
 //     other-param   = (iana-param / x-param)
 result<OtherParam> IcalParser::other_param() {
         CALLSTACK;
-        if (auto v = iana_param(); is_match(v)) return OtherParam{*v};
-        if (auto v = x_param(); is_match(v)) return OtherParam{*v};
+        if (auto v = iana_param(); is_match(v)) return OtherParam{*std::move(v)};
+        if (auto v = x_param(); is_match(v)) return OtherParam{*std::move(v)};
         return result<OtherParam>();
 }
 
@@ -2294,7 +1925,7 @@ result<DtStampParams> IcalParser::stmparam() {
         DtStampParams ret;
         while (is_match(token(";"))) {
                 if (auto v = other_param(); is_match(v))
-                        ret.params.push_back(*v);
+                        ret.params.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         ptran.commit();
@@ -2309,12 +1940,12 @@ result<DtStamp> IcalParser::dtstamp() {
 
         if (!is_match(token("DTSTAMP"))) return no_match;
 
-        if (auto v = stmparam(); is_match(v)) ret.params = *v;
+        if (auto v = stmparam(); is_match(v)) ret.params = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");
 
-        if (auto v = date_time(); is_match(v)) ret.date_time = *v;
+        if (auto v = date_time(); is_match(v)) ret.date_time = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -2328,7 +1959,7 @@ result<vector<OtherParam>> IcalParser::uidparam() {
         save_input_pos ptran(*is);
         vector<OtherParam> ret;
         while (is_match(token(";"))) {
-                if (auto v = other_param(); is_match(v)) ret.push_back(*v);
+                if (auto v = other_param(); is_match(v)) ret.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         ptran.commit();
@@ -2342,12 +1973,12 @@ result<Uid> IcalParser::uid() {
 
         if (!is_match(token("UID"))) return no_match;
 
-        if (auto v = uidparam(); is_match(v)) ret.params = *v;
+        if (auto v = uidparam(); is_match(v)) ret.params = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");
 
-        if (auto v = text(); is_match(v)) ret.value = *v;
+        if (auto v = text(); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline()))  return SYNTAX_ERROR("");
@@ -2358,8 +1989,8 @@ result<Uid> IcalParser::uid() {
 //       dtstval    = date-time / date
 result<DtStartVal> IcalParser::dtstval() {
         CALLSTACK;
-        if (auto v = date_time(); is_match(v)) return DtStartVal{*v};
-        if (auto v = date(); is_match(v)) return DtStartVal{*v};
+        if (auto v = memo<&IcalParser::date_time>(); is_match(v)) return DtStartVal{*std::move(v)};
+        if (auto v = memo<&IcalParser::date>(); is_match(v)) return DtStartVal{*std::move(v)};
         return result<DtStartVal>();
 }
 //       ;Value MUST match value type
@@ -2388,16 +2019,16 @@ result<DtStartParams> IcalParser::dtstparam() {
                                 return SYNTAX_ERROR("");
 
                         if (auto v = token("DATE-TIME"); is_match(v)) {
-                                ret.value = *v;
+                                ret.value = *std::move(v);
                         } else if (auto v = token("DATE"); is_match(v)) {
-                                ret.value = *v;
+                                ret.value = *std::move(v);
                         } else {
                                 return SYNTAX_ERROR("");
                         }
                 } else if (auto v = tzidparam(); is_match(v)) {
-                        ret.tz_id = *v;
+                        ret.tz_id = *std::move(v);
                 } else if (auto v = other_param(); is_match(v)) {
-                        ret.params.push_back(*v);
+                        ret.params.push_back(*std::move(v));
                 } else {
                         return SYNTAX_ERROR("");
                 }
@@ -2414,12 +2045,12 @@ result<DtStart> IcalParser::dtstart() {
 
         if (!is_match(token("DTSTART"))) return no_match;
 
-        if (auto v = dtstparam(); is_match(v)) ret.params = *v;
+        if (auto v = dtstparam(); is_match(v)) ret.params = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");;
 
-        if (auto v = dtstval(); is_match(v)) ret.value = *v;
+        if (auto v = dtstval(); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -2448,7 +2079,7 @@ result<ClassParams> IcalParser::classparam() {
         ClassParams ret;
         while (is_match(token(";"))) {
                 if (auto v = other_param(); is_match(v))
-                        ret.params.push_back(*v);
+                        ret.params.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         ptran.commit();
@@ -2463,12 +2094,12 @@ result<Class> IcalParser::class_() {
 
         if (!is_match(token("CLASS"))) return no_match;
 
-        if (auto v = classparam(); is_match(v)) ret.params = *v;
+        if (auto v = classparam(); is_match(v)) ret.params = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");;
 
-        if (auto v = classvalue(); is_match(v)) ret.value = *v;
+        if (auto v = classvalue(); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -2483,7 +2114,7 @@ result<CreaParam> IcalParser::creaparam() {
         CreaParam ret;
         while (is_match(token(";"))) {
                 if (auto v = other_param(); is_match(v))
-                        ret.params.push_back(*v);
+                        ret.params.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         ptran.commit();
@@ -2497,12 +2128,12 @@ result<Created> IcalParser::created() {
 
         if (!is_match(token("CREATED"))) return no_match;
 
-        if (auto v = creaparam(); is_match(v)) ret.params = *v;
+        if (auto v = creaparam(); is_match(v)) ret.params = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");;
 
-        if (auto v = date_time(); is_match(v)) ret.dateTime = *v;
+        if (auto v = date_time(); is_match(v)) ret.dateTime = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR(""); // error
@@ -2530,11 +2161,11 @@ result<DescParams> IcalParser::descparam() {
         DescParams ret;
         while(is_match(token(";"))) {
                 if (auto v = altrepparam(); is_match(v)) {
-                        ret.alt_rep = *v;
+                        ret.alt_rep = *std::move(v);
                 } else if (auto v = languageparam(); is_match(v)) {
-                        ret.language = *v;
+                        ret.language = *std::move(v);
                 } else if (auto v = other_param(); is_match(v)) {
-                        ret.params.push_back(*v);
+                        ret.params.push_back(*std::move(v));
                 } else {
                         return SYNTAX_ERROR("");
                 }
@@ -2550,12 +2181,12 @@ result<Description> IcalParser::description() {
 
         if (!is_match(token("DESCRIPTION"))) return no_match;
 
-        if (auto v = descparam(); is_match(v)) ret.params = *v;
+        if (auto v = descparam(); is_match(v)) ret.params = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");;
 
-        if (auto v = text(); is_match(v)) ret.value = *v;
+        if (auto v = text(); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -2572,7 +2203,7 @@ result<GeoValue> IcalParser::geovalue() {
         GeoValue ret;
 
         if (auto v = float_(); is_match(v)) {
-                ret.latitude = *v;
+                ret.latitude = *std::move(v);
         } else {
                 return no_match;
         }
@@ -2581,7 +2212,7 @@ result<GeoValue> IcalParser::geovalue() {
                 return no_match;
 
         if (auto v = float_(); is_match(v)) {
-                ret.longitude = *v;
+                ret.longitude = *std::move(v);
         } else {
                 return no_match;
         }
@@ -2596,7 +2227,7 @@ result<GeoParams> IcalParser::geoparam() {
         GeoParams ret;
         while (is_match(token(";"))) {
                 if (auto v = other_param(); is_match(v))
-                        ret.params.push_back(*v);
+                        ret.params.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         ptran.commit();
@@ -2610,12 +2241,12 @@ result<Geo> IcalParser::geo() {
 
         if (!is_match(token("GEO"))) return no_match;
 
-        if (auto v = geoparam(); is_match(v)) ret.params = *v;
+        if (auto v = geoparam(); is_match(v)) ret.params = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");;
 
-        if (auto v = geovalue(); is_match(v)) ret.value = *v;
+        if (auto v = geovalue(); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -2630,7 +2261,7 @@ result<LstParams> IcalParser::lstparam() {
         LstParams ret;
         while (is_match(token(";"))) {
                 if (auto v = other_param(); is_match(v))
-                        ret.params.push_back(*v);
+                        ret.params.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         ptran.commit();
@@ -2644,12 +2275,12 @@ result<LastMod> IcalParser::last_mod() {
 
         if (!is_match(token("LAST-MODIFIED"))) return no_match;
 
-        if (auto v = lstparam(); is_match(v)) ret.params = *v;
+        if (auto v = lstparam(); is_match(v)) ret.params = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");
 
-        if (auto v = date_time(); is_match(v)) ret.dateTime = *v;
+        if (auto v = date_time(); is_match(v)) ret.dateTime = *std::move(v);
         return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -2678,11 +2309,11 @@ result<LocParams> IcalParser::locparam() {
         LocParams ret;
         while(is_match(token(";"))) {
                 if (auto v = altrepparam(); is_match(v)) {
-                        ret.alt_rep = *v;
+                        ret.alt_rep = *std::move(v);
                 } else if (auto v = languageparam(); is_match(v)) {
-                        ret.language = *v;
+                        ret.language = *std::move(v);
                 } else if (auto v = other_param(); is_match(v)) {
-                        ret.params.push_back(*v);
+                        ret.params.push_back(*std::move(v));
                 } else {
                         return SYNTAX_ERROR("");
                 }
@@ -2698,12 +2329,12 @@ result<Location> IcalParser::location() {
         if (!is_match(token("LOCATION")))
                 return no_match;
 
-        if (auto v = locparam(); is_match(v)) ret.params = *v;
+        if (auto v = locparam(); is_match(v)) ret.params = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");;
 
-        if (auto v = text(); is_match(v)) ret.value = *v;
+        if (auto v = text(); is_match(v)) ret.value = intern(*v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -2734,15 +2365,15 @@ result<OrgParams> IcalParser::orgparam() {
         OrgParams ret;
         while(is_match(token(";"))) {
                 if (auto v = cnparam(); is_match(v)) {
-                        ret.cn = *v;
+                        ret.cn = *std::move(v);
                 } else if (auto v = dirparam(); is_match(v)) {
-                        ret.dir = *v;
+                        ret.dir = *std::move(v);
                 } else if (auto v = sentbyparam(); is_match(v)) {
-                        ret.sentBy = *v;
+                        ret.sentBy = *std::move(v);
                 } else if (auto v = languageparam(); is_match(v)) {
-                        ret.language = *v;
+                        ret.language = *std::move(v);
                 } else if (auto v = other_param(); is_match(v)) {
-                        ret.params.push_back(*v);
+                        ret.params.push_back(*std::move(v));
                 } else {
                         return SYNTAX_ERROR("");
                 }
@@ -2765,7 +2396,7 @@ result<Organizer> IcalParser::organizer() {
                 return no_match;
 
         if (auto v = orgparam(); is_match(v)) {
-                ret.params = *v;
+                ret.params = *std::move(v);
         } else {
                 return SYNTAX_ERROR("");
         }
@@ -2774,7 +2405,7 @@ result<Organizer> IcalParser::organizer() {
                 return SYNTAX_ERROR("");
 
         if (auto v = cal_address(); is_match(v)) {
-                ret.address = *v;
+                ret.address = *std::move(v);
         } else {
                 return SYNTAX_ERROR("");
         }
@@ -2803,7 +2434,7 @@ bool IcalParser::prioparam() {
         save_input_pos ptran(*is);
         PrioParam ret;
         while (is_match(token(";"))) {
-                if (auto v = other_param(); is_match(v)) ret.push_back(*v);
+                if (auto v = other_param(); is_match(v)) ret.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         ptran.commit();
@@ -2834,7 +2465,7 @@ result<SeqParams> IcalParser::seqparam() {
         SeqParams ret;
         while (is_match(token(";"))) {
                 if (auto v = other_param(); is_match(v))
-                        ret.params.push_back(*v);
+                        ret.params.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         ptran.commit();
@@ -2849,12 +2480,12 @@ result<Seq> IcalParser::seq() {
 
         if (!is_match(token("SEQUENCE"))) return no_match;
 
-        if (auto v = seqparam(); is_match(v)) ret.params = *v;
+        if (auto v = seqparam(); is_match(v)) ret.params = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");;
 
-        if (auto v = integer(); is_match(v)) ret.value = *v;
+        if (auto v = integer(); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -2873,9 +2504,9 @@ result<StatvalueEvent> IcalParser::statvalue_event() {
         save_input_pos ptran(*is);
         StatvalueEvent ret;
 
-        if (auto v = token("TENTATIVE"); is_match(v)) ret.value = *v;
-        else if (auto v = token("CONFIRMED"); is_match(v)) ret.value = *v;
-        else if (auto v = token("CANCELLED"); is_match(v)) ret.value = *v;
+        if (auto v = token("TENTATIVE"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("CONFIRMED"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("CANCELLED"); is_match(v)) ret.value = *std::move(v);
         else return no_match;
 
         ptran.commit();
@@ -2892,10 +2523,10 @@ result<StatvalueTodo> IcalParser::statvalue_todo() {
         save_input_pos ptran(*is);
         StatvalueTodo ret;
 
-        if (auto v = token("NEEDS-ACTION"); is_match(v)) ret.value = *v;
-        else if (auto v = token("COMPLETED"); is_match(v)) ret.value = *v;
-        else if (auto v = token("IN-PROCESS"); is_match(v)) ret.value = *v;
-        else if (auto v = token("CANCELLED"); is_match(v)) ret.value = *v;
+        if (auto v = token("NEEDS-ACTION"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("COMPLETED"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("IN-PROCESS"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("CANCELLED"); is_match(v)) ret.value = *std::move(v);
         else return no_match;
 
         ptran.commit();
@@ -2911,9 +2542,9 @@ result<StatvalueJour> IcalParser::statvalue_jour() {
         save_input_pos ptran(*is);
         StatvalueJour ret;
 
-        if (auto v = token("DRAFT"); is_match(v)) ret.value = *v;
-        else if (auto v = token("FINAL"); is_match(v)) ret.value = *v;
-        else if (auto v = token("CANCELLED"); is_match(v)) ret.value = *v;
+        if (auto v = token("DRAFT"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("FINAL"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("CANCELLED"); is_match(v)) ret.value = *std::move(v);
         else return no_match;
 
         ptran.commit();
@@ -2928,9 +2559,9 @@ result<Statvalue> IcalParser::statvalue() {
         save_input_pos ptran(*is);
         Statvalue ret;
 
-        if (auto v = statvalue_event(); is_match(v)) ret = *v;
-        else if (auto v = statvalue_todo(); is_match(v)) ret = *v;
-        else if (auto v = statvalue_jour(); is_match(v)) ret = *v;
+        if (auto v = statvalue_event(); is_match(v)) ret = *std::move(v);
+        else if (auto v = statvalue_todo(); is_match(v)) ret = *std::move(v);
+        else if (auto v = statvalue_jour(); is_match(v)) ret = *std::move(v);
         else return no_match;
 
         ptran.commit();
@@ -2944,7 +2575,7 @@ result<StatParams> IcalParser::statparam() {
         StatParams ret;
         while (is_match(token(";"))) {
                 if (auto v = other_param(); is_match(v))
-                        ret.params.push_back(*v);
+                        ret.params.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         ptran.commit();
@@ -2959,12 +2590,12 @@ result<Status> IcalParser::status() {
 
         if (!is_match(token("STATUS"))) return no_match;
 
-        if (auto v = statparam(); is_match(v)) ret.params = *v;
+        if (auto v = statparam(); is_match(v)) ret.params = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");
 
-        if (auto v = statvalue(); is_match(v)) ret.value = *v;
+        if (auto v = statvalue(); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -2993,11 +2624,11 @@ result<SummParams> IcalParser::summparam() {
         SummParams ret;
         while(is_match(token(";"))) {
                 if (auto v = altrepparam(); is_match(v)) {
-                        ret.alt_rep = *v;
+                        ret.alt_rep = *std::move(v);
                 } else if (auto v = languageparam(); is_match(v)) {
-                        ret.language = *v;
+                        ret.language = *std::move(v);
                 } else if (auto v = other_param(); is_match(v)) {
-                        ret.params.push_back(*v);
+                        ret.params.push_back(*std::move(v));
                 } else {
                         return SYNTAX_ERROR("");
                 }
@@ -3014,12 +2645,12 @@ result<Summary> IcalParser::summary() {
 
         if (!is_match(token("SUMMARY")))  return no_match;
 
-        if (auto v = summparam(); is_match(v)) ret.params = *v;
+        if (auto v = summparam(); is_match(v)) ret.params = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");;
 
-        if (auto v = text(); is_match(v)) ret.value = *v;
+        if (auto v = text(); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -3029,15 +2660,17 @@ result<Summary> IcalParser::summary() {
 }
 
 //       transparam = *(";" other-param)
-bool IcalParser::transparam() {
+result<TranspParams> IcalParser::transparam() {
         CALLSTACK;
         save_input_pos ptran(*is);
+        TranspParams ret;
         while (is_match(token(";"))) {
-                if (!is_match(other_param()))
-                        return false;
+                if (auto v = other_param(); is_match(v))
+                        ret.params.push_back(*std::move(v));
+                else return SYNTAX_ERROR("");
         }
         ptran.commit();
-        return true;
+        return ret;
 }
 
 //       transvalue = "OPAQUE"
@@ -3045,43 +2678,67 @@ bool IcalParser::transparam() {
 //                   / "TRANSPARENT"
 //                   ;Transparent on busy time searches.
 //       ;Default value is OPAQUE
-bool IcalParser::transvalue() {
+result<string> IcalParser::transvalue() {
         CALLSTACK;
         save_input_pos ptran(*is);
-        const auto success =
-                is_match(token("OPAQUE")) ||
-                is_match(token("TRANSPARENT"));
-        if (!success)
-                return false;
+        string ret;
+
+        if (auto v = token("OPAQUE"); is_match(v)) ret = *std::move(v);
+        else if (auto v = token("TRANSPARENT"); is_match(v)) ret = *std::move(v);
+        else return no_match;
+
         ptran.commit();
-        return true;
+        return ret;
 }
 
 //       transp     = "TRANSP" transparam ":" transvalue CRLF
 result<Transp> IcalParser::transp() {
         CALLSTACK;
         save_input_pos ptran(*is);
-        if (!is_match(token("TRANSP")))
-                return no_match;
-        const auto success =
-                transparam() &&
-                is_match(token(":")) &&
-                transvalue() &&
-                is_match(newline());
-        if (!success)
-                return SYNTAX_ERROR("");
+        Transp ret;
+
+        if (!is_match(token("TRANSP"))) return no_match;
+
+        if (auto v = transparam(); is_match(v)) ret.params = *std::move(v);
+        else return SYNTAX_ERROR("");
+
+        if (!is_match(token(":"))) return SYNTAX_ERROR("");
+
+        if (auto v = transvalue(); is_match(v)) ret.value = *std::move(v);
+        else return SYNTAX_ERROR("");
+
+        if (!is_match(newline())) return SYNTAX_ERROR("");
+
         ptran.commit();
-        NOT_IMPLEMENTED;
+        return ret;
 }
 //      uri = <As defined in Section 3 of [RFC3986]>
 result<Uri> IcalParser::uri() {
         CALLSTACK;
         save_input_pos ptran(*is);
-        const auto uri = rfc3986::read_URI(*is);
-        if (!uri)
+        const auto start = is.tellg();
+
+        // The recognizer works on contiguous bytes, so it gets an unfolded
+        // copy of the candidate characters.
+        string text;
+        while (true) {
+                const auto c = is.get();
+                if (c == EOF || !is_uri_char(c))
+                        break;
+                text += char(c);
+        }
+        const auto spans = rfc3986::scan_URI(text);
+        if (!spans)
                 return no_match;
+
+        // Consume what scan_URI() recognized, folds included.
+        is->clear();
+        is->seekg(start);
+        for (std::size_t i = 0; i != spans->length; ++i)
+                is.get();
+
         ptran.commit();
-        return *uri;
+        return rfc3986::to_uri(text, *spans);
 }
 //       urlparam   = *(";" other-param)
 bool IcalParser::urlparam() {
@@ -3189,7 +2846,7 @@ result<SetPosDay> IcalParser::setposday() {
         save_input_pos ptran(*is);
         SetPosDay ret;
 
-        if (auto v = yeardaynum(); is_match(v)) ret = *v;
+        if (auto v = yeardaynum(); is_match(v)) ret = *std::move(v);
         else return no_match;
 
         ptran.commit();
@@ -3202,11 +2859,11 @@ result<BySpList> IcalParser::bysplist() {
         save_input_pos ptran(*is);
         BySpList ret;
 
-        if (auto v = setposday(); is_match(v)) ret.push_back(*v);
+        if (auto v = setposday(); is_match(v)) ret.push_back(*std::move(v));
         else return no_match;
 
         while (is_match(token(","))) {
-                if (auto v = setposday(); is_match(v)) ret.push_back(*v);
+                if (auto v = setposday(); is_match(v)) ret.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
 
@@ -3222,7 +2879,7 @@ result<MonthNum> IcalParser::monthnum() {
         save_input_pos ptran(*is);
         MonthNum ret;
 
-        if (auto v = digits(1,2); is_match(v)) ret = *v;
+        if (auto v = digits(1,2); is_match(v)) ret = *std::move(v);
         else return no_match;
 
         ptran.commit();
@@ -3235,11 +2892,11 @@ result<ByMoList> IcalParser::bymolist() {
         save_input_pos ptran(*is);
         ByMoList ret;
 
-        if (auto v = monthnum(); is_match(v)) ret.push_back(*v);
+        if (auto v = monthnum(); is_match(v)) ret.push_back(*std::move(v));
         else return no_match;
 
         while (is_match(token(","))) {
-                if (auto v = monthnum(); is_match(v)) ret.push_back(*v);
+                if (auto v = monthnum(); is_match(v)) ret.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
 
@@ -3261,11 +2918,11 @@ result<ByWkNoList> IcalParser::bywknolist() {
         save_input_pos ptran(*is);
         ByWkNoList ret;
 
-        if (auto v = weeknum(); is_match(v)) ret.push_back(*v);
+        if (auto v = weeknum(); is_match(v)) ret.push_back(*std::move(v));
         else return no_match;
 
         while (is_match(token(","))) {
-                if (auto v = weeknum(); is_match(v)) ret.push_back(*v);
+                if (auto v = weeknum(); is_match(v)) ret.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
 
@@ -3281,7 +2938,7 @@ result<OrdYrDay> IcalParser::ordyrday() {
         save_input_pos ptran(*is);
         OrdYrDay ret;
 
-        if (auto v = digits(1,3); is_match(v)) ret = *v;
+        if (auto v = digits(1,3); is_match(v)) ret = *std::move(v);
         else return no_match;
 
         ptran.commit();
@@ -3298,7 +2955,7 @@ result<YearDayNum> IcalParser::yeardaynum() {
         else if (auto v = minus()) ret.sign = -1;
         else ret.sign = +1;
 
-        if (auto v = ordyrday(); is_match(v)) ret.day = *v;
+        if (auto v = ordyrday(); is_match(v)) ret.day = *std::move(v);
         else return no_match;
 
         ptran.commit();
@@ -3311,11 +2968,11 @@ result<ByYrDayList> IcalParser::byyrdaylist() {
         save_input_pos ptran(*is);
         ByYrDayList ret;
 
-        if (auto v = yeardaynum(); is_match(v)) ret.push_back(*v);
+        if (auto v = yeardaynum(); is_match(v)) ret.push_back(*std::move(v));
         else return no_match;
 
         while (is_match(token(","))) {
-                if (auto v = yeardaynum(); is_match(v)) ret.push_back(*v);
+                if (auto v = yeardaynum(); is_match(v)) ret.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
 
@@ -3331,7 +2988,7 @@ result<OrdMoDay> IcalParser::ordmoday() {
         save_input_pos ptran(*is);
         OrdMoDay ret;
 
-        if (auto v = digits(1,2); is_match(v)) ret = *v;
+        if (auto v = digits(1,2); is_match(v)) ret = *std::move(v);
         return no_match;
 
         ptran.commit();
@@ -3348,7 +3005,7 @@ result<MonthDayNum> IcalParser::monthdaynum() {
         else if (auto v = minus()) ret.sign = -1;
         else ret.sign = +1;
 
-        if (auto v = ordmoday(); is_match(v)) ret.day = *v;
+        if (auto v = ordmoday(); is_match(v)) ret.day = *std::move(v);
         else return no_match;
 
         ptran.commit();
@@ -3361,11 +3018,11 @@ result<ByMoDayList> IcalParser::bymodaylist() {
         save_input_pos ptran(*is);
         ByMoDayList ret;
 
-        if (auto v = monthdaynum(); is_match(v)) ret.push_back(*v);
+        if (auto v = monthdaynum(); is_match(v)) ret.push_back(*std::move(v));
         else return no_match;
 
         while (is_match(token(","))) {
-                if (auto v = monthdaynum(); is_match(v)) ret.push_back(*v);
+                if (auto v = monthdaynum(); is_match(v)) ret.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
 
@@ -3399,7 +3056,7 @@ result<OrdWk> IcalParser::ordwk() {
         CALLSTACK;
         save_input_pos ptran(*is);
         OrdWk ret;
-        if (auto v = digits(1,2); is_match(v)) ret = *v;
+        if (auto v = digits(1,2); is_match(v)) ret = *std::move(v);
         else return no_match;
         ptran.commit();
         return ret;
@@ -3434,17 +3091,17 @@ result<WeekDayNum> IcalParser::weekdaynum() {
                 if (auto v = ordwk(); is_match(v)) {
                         ret.week = SignedOrdWk();
                         ret.week->sign = sign;
-                        ret.week->ordWk = *v;
+                        ret.week->ordWk = *std::move(v);
                 } else {
                         return no_match;
                 }
         } else if (auto v = ordwk(); is_match(v)) {
                 ret.week = SignedOrdWk();
                 ret.week->sign = +1;
-                ret.week->ordWk = *v;
+                ret.week->ordWk = *std::move(v);
         }
 
-        if (auto v = weekday(); is_match(v)) ret.weekDay = *v;
+        if (auto v = weekday(); is_match(v)) ret.weekDay = *std::move(v);
         else return no_match;
 
         ptran.commit();
@@ -3457,11 +3114,11 @@ result<ByWDayList> IcalParser::bywdaylist() {
         save_input_pos ptran(*is);
         ByWDayList ret;
 
-        if (auto v = weekdaynum(); is_match(v)) ret.push_back(*v);
+        if (auto v = weekdaynum(); is_match(v)) ret.push_back(*std::move(v));
         else return no_match;
 
         while (is_match(token(","))) {
-                if (auto v = weekdaynum(); is_match(v)) ret.push_back(*v);
+                if (auto v = weekdaynum(); is_match(v)) ret.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
 
@@ -3475,7 +3132,7 @@ result<Seconds> IcalParser::seconds() {
         save_input_pos ptran(*is);
         Seconds ret;
 
-        if (auto v = digits(1,2); is_match(v)) ret = *v;
+        if (auto v = digits(1,2); is_match(v)) ret = *std::move(v);
         else return no_match;
 
         ptran.commit();
@@ -3488,7 +3145,7 @@ result<Hour> IcalParser::hour() {
         save_input_pos ptran(*is);
         Hour ret;
 
-        if (auto v = digits(1,2); is_match(v)) ret = *v;
+        if (auto v = digits(1,2); is_match(v)) ret = *std::move(v);
         else return no_match;
 
         ptran.commit();
@@ -3501,7 +3158,7 @@ result<Minutes> IcalParser::minutes() {
         save_input_pos ptran(*is);
         Hour ret;
 
-        if (auto v = digits(1,2); is_match(v)) ret = *v;
+        if (auto v = digits(1,2); is_match(v)) ret = *std::move(v);
         else return no_match;
 
         ptran.commit();
@@ -3514,11 +3171,11 @@ result<ByHrList> IcalParser::byhrlist() {
         save_input_pos ptran(*is);
         ByHrList ret;
 
-        if (auto v = hour(); is_match(v)) ret.push_back(*v);
+        if (auto v = hour(); is_match(v)) ret.push_back(*std::move(v));
         else return no_match;
 
         while (is_match(token(","))) {
-                if (auto v = hour(); is_match(v)) ret.push_back(*v);
+                if (auto v = hour(); is_match(v)) ret.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
 
@@ -3532,11 +3189,11 @@ result<ByMinList> IcalParser::byminlist() {
         save_input_pos ptran(*is);
         ByMinList ret;
 
-        if (auto v = minutes(); is_match(v)) ret.push_back(*v);
+        if (auto v = minutes(); is_match(v)) ret.push_back(*std::move(v));
         else return no_match;
 
         while (is_match(token(","))) {
-                if (auto v = minutes(); is_match(v)) ret.push_back(*v);
+                if (auto v = minutes(); is_match(v)) ret.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
 
@@ -3550,11 +3207,11 @@ result<BySecList> IcalParser::byseclist() {
         save_input_pos ptran(*is);
         BySecList ret;
 
-        if (auto v = seconds(); is_match(v)) ret.push_back(*v);
+        if (auto v = seconds(); is_match(v)) ret.push_back(*std::move(v));
         else return no_match;
 
         while (is_match(token(","))) {
-                if (auto v = seconds(); is_match(v)) ret.push_back(*v);
+                if (auto v = seconds(); is_match(v)) ret.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
 
@@ -3568,8 +3225,9 @@ result<EndDate> IcalParser::enddate() {
         save_input_pos ptran(*is);
         EndDate ret;
 
-        if (auto v = date(); is_match(v)) ret = *v;
-        else if (auto v = date_time(); is_match(v)) ret = *v;
+        // date is a prefix of date-time, so the longer one goes first.
+        if (auto v = memo<&IcalParser::date_time>(); is_match(v)) ret = *std::move(v);
+        else if (auto v = memo<&IcalParser::date>(); is_match(v)) ret = *std::move(v);
         else return no_match;
 
         ptran.commit();
@@ -3632,59 +3290,59 @@ result<Recur> IcalParser::recur() {
         do {
                 if (is_match(token("FREQ"))) {
                         if (!is_match(token("="))) return SYNTAX_ERROR("");
-                        if (auto v = freq(); is_match(v)) ret.freq = *v;
+                        if (auto v = freq(); is_match(v)) ret.freq = *std::move(v);
                         else return SYNTAX_ERROR("");
                 } else if (is_match(token("UNTIL"))) {
                         if (!is_match(token("="))) return SYNTAX_ERROR("");
-                        if (auto v = enddate(); is_match(v)) ret.duration = *v;
+                        if (auto v = enddate(); is_match(v)) ret.duration = *std::move(v);
                         else return SYNTAX_ERROR("");
                 } else if (is_match(token("COUNT"))) {
                         if (!is_match(token("="))) return SYNTAX_ERROR("");
-                        if (auto v = digits(1,-1); is_match(v)) ret.duration = *v;
+                        if (auto v = digits(1,-1); is_match(v)) ret.duration = *std::move(v);
                         else return SYNTAX_ERROR("");
                 } else if (is_match(token("INTERVAL"))) {
                         if (!is_match(token("="))) return SYNTAX_ERROR("");
-                        if (auto v = digits(1,-1); is_match(v)) ret.interval = *v;
+                        if (auto v = digits(1,-1); is_match(v)) ret.interval = *std::move(v);
                         else return SYNTAX_ERROR("");
                 } else if (is_match(token("BYSECOND"))) {
                         if (!is_match(token("="))) return SYNTAX_ERROR("");
-                        if (auto v = byseclist(); is_match(v)) ret.bySecond = *v;
+                        if (auto v = byseclist(); is_match(v)) ret.bySecond = *std::move(v);
                         else return SYNTAX_ERROR("");
                 } else if (is_match(token("BYMINUTE"))) {
                         if (!is_match(token("="))) return SYNTAX_ERROR("");
-                        if (auto v = byminlist(); is_match(v)) ret.byMinute = *v;
+                        if (auto v = byminlist(); is_match(v)) ret.byMinute = *std::move(v);
                         else return SYNTAX_ERROR("");
                 } else if (is_match(token("BYHOUR"))) {
                         if (!is_match(token("="))) return SYNTAX_ERROR("");
-                        if (auto v = byhrlist(); is_match(v)) ret.byHour = *v;
+                        if (auto v = byhrlist(); is_match(v)) ret.byHour = *std::move(v);
                         else return SYNTAX_ERROR("");
                 } else if (is_match(token("BYDAY"))) {
                         if (!is_match(token("="))) return SYNTAX_ERROR("");
-                        if (auto v = bywdaylist(); is_match(v)) ret.byDay = *v;
+                        if (auto v = bywdaylist(); is_match(v)) ret.byDay = *std::move(v);
                         else return SYNTAX_ERROR("");
                 } else if (is_match(token("BYMONTHDAY"))) {
                         if (!is_match(token("="))) return SYNTAX_ERROR("");
-                        if (auto v = bymodaylist(); is_match(v)) ret.byMonthDay = *v;
+                        if (auto v = bymodaylist(); is_match(v)) ret.byMonthDay = *std::move(v);
                         else return SYNTAX_ERROR("");
                 } else if (is_match(token("BYYEARDAY"))) {
                         if (!is_match(token("="))) return SYNTAX_ERROR("");
-                        if (auto v = byyrdaylist(); is_match(v)) ret.byYearDay = *v;
+                        if (auto v = byyrdaylist(); is_match(v)) ret.byYearDay = *std::move(v);
                         else return SYNTAX_ERROR("");
                 } else if (is_match(token("BYWEEKNO"))) {
                         if (!is_match(token("="))) return SYNTAX_ERROR("");
-                        if (auto v = bywknolist(); is_match(v)) ret.byweekNo = *v;
+                        if (auto v = bywknolist(); is_match(v)) ret.byweekNo = *std::move(v);
                         else return SYNTAX_ERROR("");
                 } else if (is_match(token("BYMONTH"))) {
                         if (!is_match(token("="))) return SYNTAX_ERROR("");
-                        if (auto v = bymolist(); is_match(v)) ret.byMonth = *v;
+                        if (auto v = bymolist(); is_match(v)) ret.byMonth = *std::move(v);
                         else return SYNTAX_ERROR("");
                 } else if (is_match(token("BYSETPOS"))) {
                         if (!is_match(token("="))) return SYNTAX_ERROR("");
-                        if (auto v = bysplist(); is_match(v)) ret.bySetpos = *v;
+                        if (auto v = bysplist(); is_match(v)) ret.bySetpos = *std::move(v);
                         else return SYNTAX_ERROR("");
                 } else if (is_match(token("WKST"))) {
                         if (!is_match(token("="))) return SYNTAX_ERROR("");
-                        if (auto v = weekday(); is_match(v)) ret.wkst = *v;
+                        if (auto v = weekday(); is_match(v)) ret.wkst = *std::move(v);
                         else return SYNTAX_ERROR("");
                 } else {
                         return SYNTAX_ERROR("");
@@ -3718,7 +3376,7 @@ result<RRulParam> IcalParser::rrulparam() {
         RRulParam ret;
         while (is_match(token(";"))) {
                 if (auto v = other_param(); is_match(v))
-                        ret.otherParams.push_back(*v);
+                        ret.otherParams.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         ptran.commit();
@@ -3733,12 +3391,12 @@ result<RRule> IcalParser::rrule() {
 
         if (!is_match(token("RRULE"))) return no_match;
 
-        if (auto v = rrulparam(); is_match(v)) ret.param = *v;
+        if (auto v = rrulparam(); is_match(v)) ret.param = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");
 
-        if (auto v = recur(); is_match(v)) ret.recur = *v;
+        if (auto v = recur(); is_match(v)) ret.recur = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -3751,8 +3409,8 @@ result<RRule> IcalParser::rrule() {
 //       ;Value MUST match value type
 result<DtEndVal> IcalParser::dtendval() {
         CALLSTACK;
-        if (auto v = date_time(); is_match(v)) return DtEndVal{*v};
-        if (auto v = date(); is_match(v)) return DtEndVal{*v};
+        if (auto v = memo<&IcalParser::date_time>(); is_match(v)) return DtEndVal{*std::move(v)};
+        if (auto v = memo<&IcalParser::date>(); is_match(v)) return DtEndVal{*std::move(v)};
         return result<DtStartVal>();
 }
 
@@ -3781,16 +3439,16 @@ result<DtEndParams> IcalParser::dtendparam() {
                                 return SYNTAX_ERROR("");
 
                         if (auto v = token("DATE-TIME"); is_match(v)) {
-                                ret.value = *v;
+                                ret.value = *std::move(v);
                         } else if (auto v = token("DATE"); is_match(v)) {
-                                ret.value = *v;
+                                ret.value = *std::move(v);
                         } else {
                                 return SYNTAX_ERROR("");
                         }
                 } else if (auto v = tzidparam(); is_match(v)) {
-                        ret.tz_id = *v;
+                        ret.tz_id = *std::move(v);
                 } else if (auto v = other_param(); is_match(v)) {
-                        ret.params.push_back(*v);
+                        ret.params.push_back(*std::move(v));
                 } else {
                         return no_match;
                 }
@@ -3807,12 +3465,12 @@ result<DtEnd> IcalParser::dtend() {
 
         if (!is_match(token("DTEND"))) return no_match;
 
-        if (auto v = dtendparam(); is_match(v)) ret.params = *v;
+        if (auto v = dtendparam(); is_match(v)) ret.params = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");;
 
-        if (auto v = dtendval(); is_match(v)) ret.value = *v;
+        if (auto v = dtendval(); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -3995,9 +3653,9 @@ result<CatParams> IcalParser::catparam() {
         CatParams ret;
         while (is_match(token(";"))) {
                 if (auto v = languageparam(); is_match(v)) {
-                        ret.language = *v;
+                        ret.language = *std::move(v);
                 } else if (auto v = other_param(); is_match(v)) {
-                        ret.params.push_back(*v);
+                        ret.params.push_back(*std::move(v));
                 } else {
                         return no_match;
                 }
@@ -4014,16 +3672,17 @@ result<Categories> IcalParser::categories () {
 
         if (!is_match(token("CATEGORIES"))) return no_match;
 
-        if (auto v = catparam(); is_match(v)) ret.params = *v;
+        if (auto v = catparam(); is_match(v)) ret.params = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");;
 
-        if (auto v = text(); is_match(v)) ret.values.push_back(*v);
+        if (auto v = text(); is_match(v)) ret.values.push_back(intern(*v));
         else return SYNTAX_ERROR("");
 
         while (is_match(token(","))) {
-                if (auto v = text(); is_match(v)) ret.values.push_back(*v);
+                if (auto v = text(); is_match(v))
+                        ret.values.push_back(intern(*v));
                 else return SYNTAX_ERROR("");
         }
 
@@ -4271,15 +3930,15 @@ result<RelTypeParam> IcalParser::reltypeparam() {
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
         if (auto v = token("PARENT"); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else if (auto v = token("CHILD"); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else if (auto v = token("SIBLING"); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else if (auto v = iana_token(); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else if (auto v = x_name(); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else {
                 return SYNTAX_ERROR("");
         }
@@ -4531,43 +4190,43 @@ result<EventProp> IcalParser::eventprop_single() {
         CALLSTACK;
         save_input_pos ptran(*is);
         EventProp ret;
-        if (auto v = dtstamp(); is_match(v)) ret = *v;
-        else if (auto v = uid(); is_match(v)) ret = *v;
-
-        else if (auto v = dtstart(); is_match(v)) ret = *v;
-
-        else if (auto v = class_(); is_match(v)) ret = *v;
-        else if (auto v = created(); is_match(v)) ret = *v;
-        else if (auto v = description(); is_match(v)) ret = *v;
-        else if (auto v = geo(); is_match(v)) ret = *v;
-        else if (auto v = last_mod(); is_match(v)) ret = *v;
-        else if (auto v = location(); is_match(v)) ret = *v;
-        else if (auto v = organizer(); is_match(v)) ret = *v;
-        else if (auto v = priority(); is_match(v)) ret = *v;
-        else if (auto v = seq(); is_match(v)) ret = *v;
-        else if (auto v = status(); is_match(v)) ret = *v;
-        else if (auto v = summary(); is_match(v)) ret = *v;
-        else if (auto v = transp(); is_match(v)) ret = *v;
-        else if (auto v = url(); is_match(v)) ret = *v;
-        else if (auto v = recurid(); is_match(v)) ret = *v;
-
-        else if (auto v = rrule(); is_match(v)) ret = *v;
-
-        else if (auto v = dtend(); is_match(v)) ret = *v;
-        else if (auto v = duration(); is_match(v)) ret = *v;
-
-        else if (auto v = attach(); is_match(v)) ret = *v;
-        else if (auto v = attendee(); is_match(v)) ret = *v;
-        else if (auto v = categories (); is_match(v)) ret = *v;
-        else if (auto v = comment(); is_match(v)) ret = *v;
-        else if (auto v = contact(); is_match(v)) ret = *v;
-        else if (auto v = exdate(); is_match(v)) ret = *v;
-        else if (auto v = rstatus(); is_match(v)) ret = *v;
-        else if (auto v = related(); is_match(v)) ret = *v;
-        else if (auto v = resources(); is_match(v)) ret = *v;
-        else if (auto v = rdate(); is_match(v)) ret = *v;
-        else if (auto v = x_prop(); is_match(v)) ret = *v;
-        else if (auto v = iana_prop(); is_match(v)) ret = *v;
+        if (auto v = dtstamp(); is_match(v)) ret = *std::move(v);
+        else if (auto v = uid(); is_match(v)) ret = *std::move(v);
+
+        else if (auto v = dtstart(); is_match(v)) ret = *std::move(v);
+
+        else if (auto v = class_(); is_match(v)) ret = *std::move(v);
+        else if (auto v = created(); is_match(v)) ret = *std::move(v);
+        else if (auto v = description(); is_match(v)) ret = *std::move(v);
+        else if (auto v = geo(); is_match(v)) ret = *std::move(v);
+        else if (auto v = last_mod(); is_match(v)) ret = *std::move(v);
+        else if (auto v = location(); is_match(v)) ret = *std::move(v);
+        else if (auto v = organizer(); is_match(v)) ret = *std::move(v);
+        else if (auto v = priority(); is_match(v)) ret = *std::move(v);
+        else if (auto v = seq(); is_match(v)) ret = *std::move(v);
+        else if (auto v = status(); is_match(v)) ret = *std::move(v);
+        else if (auto v = summary(); is_match(v)) ret = *std::move(v);
+        else if (auto v = transp(); is_match(v)) ret = *std::move(v);
+        else if (auto v = url(); is_match(v)) ret = *std::move(v);
+        else if (auto v = recurid(); is_match(v)) ret = *std::move(v);
+
+        else if (auto v = rrule(); is_match(v)) ret = *std::move(v);
+
+        else if (auto v = dtend(); is_match(v)) ret = *std::move(v);
+        else if (auto v = duration(); is_match(v)) ret = *std::move(v);
+
+        else if (auto v = attach(); is_match(v)) ret = *std::move(v);
+        else if (auto v = attendee(); is_match(v)) ret = *std::move(v);
+        else if (auto v = categories (); is_match(v)) ret = *std::move(v);
+        else if (auto v = comment(); is_match(v)) ret = *std::move(v);
+        else if (auto v = contact(); is_match(v)) ret = *std::move(v);
+        else if (auto v = exdate(); is_match(v)) ret = *std::move(v);
+        else if (auto v = rstatus(); is_match(v)) ret = *std::move(v);
+        else if (auto v = related(); is_match(v)) ret = *std::move(v);
+        else if (auto v = resources(); is_match(v)) ret = *std::move(v);
+        else if (auto v = rdate(); is_match(v)) ret = *std::move(v);
+        else if (auto v = x_prop(); is_match(v)) ret = *std::move(v);
+        else if (auto v = iana_prop(); is_match(v)) ret = *std::move(v);
 
         else return no_match;
 
@@ -4579,7 +4238,7 @@ result<vector<EventProp>> IcalParser::eventprop() {
         save_input_pos ptran(*is);
         vector<EventProp> ret;
         for (auto v = eventprop_single(); is_match(v); v = eventprop_single()) {
-                ret.push_back(*v);
+                ret.push_back(*std::move(v));
         }
 
         ptran.commit();
@@ -4592,21 +4251,23 @@ result<vector<EventProp>> IcalParser::eventprop() {
 result<EventComp> IcalParser::eventc() {
         CALLSTACK;
         save_input_pos ptran(*is);
+        const auto begin = is.tellg();
         EventComp ret;
 
         if (!is_match(key_value_newline("BEGIN", "VEVENT")))
                 return no_match;
 
-        if (auto v = eventprop(); is_match(v)) ret.properties = *v;
+        if (auto v = eventprop(); is_match(v)) ret.properties = *std::move(v);
         else return SYNTAX_ERROR("");
 
         for (auto v = alarmc(); is_match(v); v = alarmc()) {
-                ret.alarms.push_back(*v);
+                ret.alarms.push_back(*std::move(v));
         }
 
         if (!is_match(key_value_newline("END", "VEVENT")))
                 return SYNTAX_ERROR("");
 
+        ret.contentHash = source_hash(begin, is.tellg());
         ptran.commit();
         return ret;
 }
@@ -4720,7 +4381,7 @@ bool IcalParser::jourprop() {
 result<JournalComp> IcalParser::journalc() {
         CALLSTACK;
         save_input_pos ptran(*is);
-        if (is_match(key_value_newline("BEGIN", "VJOURNAL")))
+        if (!is_match(key_value_newline("BEGIN", "VJOURNAL")))
                 return no_match;
         const auto success =
                 jourprop() &&
@@ -4784,7 +4445,7 @@ result<TzIdPropParam> IcalParser::tzidpropparam() {
         TzIdPropParam ret;
         while (is_match(token(";"))) {
                 if (auto v = other_param(); is_match(v))
-                        ret.params.push_back(*v);
+                        ret.params.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         ptran.commit();
@@ -4799,14 +4460,14 @@ result<TzId> IcalParser::tzid() {
 
         if (!is_match(token("TZID"))) return no_match;
 
-        if (auto v = tzidpropparam(); is_match(v)) ret.propParams = *v;
+        if (auto v = tzidpropparam(); is_match(v)) ret.propParams = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");; // error
 
-        if (auto v = tzidprefix(); is_match(v)) ret.prefix = *v;
+        if (auto v = tzidprefix(); is_match(v)) ret.prefix = *std::move(v);
 
-        if (auto v = text(); is_match(v)) ret.text = *v;
+        if (auto v = text(); is_match(v)) ret.text = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -4822,7 +4483,7 @@ result<TzUrlParam> IcalParser::tzurlparam() {
         TzUrlParam ret;
         while (is_match(token(";"))) {
                 if (auto v = other_param(); is_match(v))
-                        ret.params.push_back(*v);
+                        ret.params.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         ptran.commit();
@@ -4837,12 +4498,12 @@ result<TzUrl> IcalParser::tzurl() {
 
         if (!is_match(token("TZURL"))) return no_match;
 
-        if (auto v = tzurlparam(); is_match(v)) ret.params = *v;
+        if (auto v = tzurlparam(); is_match(v)) ret.params = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");; // error
 
-        if (auto v = uri(); is_match(v)) ret.uri = *v;
+        if (auto v = uri(); is_match(v)) ret.uri = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -4858,7 +4519,7 @@ result<FrmParam> IcalParser::frmparam() {
         FrmParam ret;
         while (is_match(token(";"))) {
                 if (auto v = other_param(); is_match(v))
-                        ret.otherParams.push_back(*v);
+                        ret.otherParams.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         ptran.commit();
@@ -4871,7 +4532,7 @@ result<ToParam> IcalParser::toparam() {
         save_input_pos ptran(*is);
         ToParam ret;
         while (is_match(token(";"))) {
-                if (auto v = other_param(); is_match(v)) ret.otherParams.push_back(*v);
+                if (auto v = other_param(); is_match(v)) ret.otherParams.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         }
         ptran.commit();
@@ -4888,13 +4549,13 @@ result<TimeNumZone> IcalParser::time_numzone() {
         else if (is_match(token("-"))) ret.sign = -1;
         else return no_match;
 
-        if (auto v = time_hour(); is_match(v)) ret.hour = *v;
+        if (auto v = time_hour(); is_match(v)) ret.hour = *std::move(v);
         else return no_match;
 
-        if (auto v = time_minute(); is_match(v)) ret.minute = *v;
+        if (auto v = time_minute(); is_match(v)) ret.minute = *std::move(v);
         else return no_match;
 
-        if (auto v = time_second(); is_match(v)) ret.second = *v;
+        if (auto v = time_second(); is_match(v)) ret.second = *std::move(v);
 
         ptran.commit();
         return ret;
@@ -4906,7 +4567,7 @@ result<UtcOffset> IcalParser::utc_offset() {
         save_input_pos ptran(*is);
         UtcOffset ret;
 
-        if (auto v = time_numzone(); is_match(v)) ret.numZone = *v;
+        if (auto v = time_numzone(); is_match(v)) ret.numZone = *std::move(v);
         else return no_match;
 
         ptran.commit();
@@ -4921,12 +4582,12 @@ result<TzOffsetTo> IcalParser::tzoffsetto() {
 
         if (!is_match(token("TZOFFSETTO"))) return no_match;
 
-        if (auto v = toparam(); is_match(v)) ret.param = *v;
+        if (auto v = toparam(); is_match(v)) ret.param = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");; // error
 
-        if (auto v = utc_offset(); is_match(v)) ret.utcOffset = *v;
+        if (auto v = utc_offset(); is_match(v)) ret.utcOffset = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR(""); // error
@@ -4943,12 +4604,12 @@ result<TzOffsetFrom> IcalParser::tzoffsetfrom() {
 
         if (!is_match(token("TZOFFSETFROM"))) return no_match;
 
-        if (auto v = frmparam(); is_match(v)) ret.param = *v;
+        if (auto v = frmparam(); is_match(v)) ret.param = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");; // error
 
-        if (auto v = utc_offset(); is_match(v)) ret.utcOffset = *v;
+        if (auto v = utc_offset(); is_match(v)) ret.utcOffset = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR(""); // error
@@ -4977,9 +4638,9 @@ result<TzNParam> IcalParser::tznparam() {
 
         while (true) {
                 if (auto v = languageparam(); is_match(v))
-                        ret.languageParam = *v;
+                        ret.languageParam = *std::move(v);
                 else if (auto v = other_param(); is_match(v))
-                        ret.otherParams.push_back(*v);
+                        ret.otherParams.push_back(*std::move(v));
                 else break;
         }
 
@@ -4995,12 +4656,12 @@ result<TzName> IcalParser::tzname() {
 
         if (!is_match(token("TZNAME"))) return no_match;
 
-        if (auto v = tznparam(); is_match(v)) ret.param = *v;
+        if (auto v = tznparam(); is_match(v)) ret.param = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(token(":"))) return SYNTAX_ERROR("");
 
-        if (auto v = text(); is_match(v)) ret.text = *v;
+        if (auto v = text(); is_match(v)) ret.text = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(newline())) return SYNTAX_ERROR("");
@@ -5034,23 +4695,23 @@ result<TzProp> IcalParser::tzprop() {
 
         while (true) {
                 if (auto v = dtstart(); is_match(v))
-                        ret.dtStart = *v;
+                        ret.dtStart = *std::move(v);
                 else if (auto v = tzoffsetto(); is_match(v))
-                        ret.offsetTo = *v;
+                        ret.offsetTo = *std::move(v);
                 else if (auto v = tzoffsetfrom(); is_match(v))
-                        ret.offsetFrom = *v;
+                        ret.offsetFrom = *std::move(v);
                 else if (auto v = rrule(); is_match(v))
-                        ret.rRule = *v;
+                        ret.rRule = *std::move(v);
                 else if (auto v = comment(); is_match(v))
-                        ret.comments.push_back(*v);
+                        ret.comments.push_back(*std::move(v));
                 else if (auto v = rdate(); is_match(v))
-                        ret.rDates.push_back(*v);
+                        ret.rDates.push_back(*std::move(v));
                 else if (auto v = tzname(); is_match(v))
-                        ret.tzNames.push_back(*v);
+                        ret.tzNames.push_back(*std::move(v));
                 else if (auto v = x_prop(); is_match(v))
-                        ret.xProps.push_back(*v);
+                        ret.xProps.push_back(*std::move(v));
                 else if (auto v = iana_prop(); is_match(v))
-                        ret.ianaProps.push_back(*v);
+                        ret.ianaProps.push_back(*std::move(v));
                 else break;
         }
 
@@ -5069,7 +4730,7 @@ result<DaylightC> IcalParser::daylightc() {
         if (!is_match(key_value_newline("BEGIN", "DAYLIGHT")))
                 return no_match;
 
-        if (auto v = tzprop(); is_match(v)) ret.tzProp = *v;
+        if (auto v = tzprop(); is_match(v)) ret.tzProp = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(key_value_newline("END", "DAYLIGHT")))
@@ -5090,7 +4751,7 @@ result<StandardC> IcalParser::standardc() {
         if (!is_match(key_value_newline("BEGIN", "STANDARD")))
                 return no_match;
 
-        if (auto v = tzprop(); is_match(v)) ret.tzProp = *v;
+        if (auto v = tzprop(); is_match(v)) ret.tzProp = *std::move(v);
         else return SYNTAX_ERROR("");
 
         if (!is_match(key_value_newline("END", "STANDARD")))
@@ -5128,6 +4789,7 @@ result<StandardC> IcalParser::standardc() {
 result<TimezoneComp> IcalParser::timezonec() {
         CALLSTACK;
         save_input_pos ptran(*is);
+        const auto begin = is.tellg();
         TimezoneComp ret;
 
         if (!is_match(key_value_newline("BEGIN", "VTIMEZONE")))
@@ -5135,19 +4797,19 @@ result<TimezoneComp> IcalParser::timezonec() {
 
         while (true) {
                 if (auto v = tzid(); is_match(v))
-                        ret.tzId = *v;
+                        ret.tzId = *std::move(v);
                 else if (auto v = last_mod(); is_match(v))
-                        ret.lastMod = *v;
+                        ret.lastMod = *std::move(v);
                 else if (auto v = tzurl(); is_match(v))
-                        ret.tzUrl = *v;
+                        ret.tzUrl = *std::move(v);
                 else if (auto v = standardc(); is_match(v))
-                        ret.observance = *v;
+                        ret.observance = *std::move(v);
                 else if (auto v = daylightc(); is_match(v))
-                        ret.observance = *v;
+                        ret.observance = *std::move(v);
                 else if (auto v = x_prop(); is_match(v))
-                        ret.xProps.push_back(*v);
+                        ret.xProps.push_back(*std::move(v));
                 else if (auto v = iana_prop(); is_match(v))
-                        ret.ianaProps.push_back(*v);
+                        ret.ianaProps.push_back(*std::move(v));
                 else break;
         }
 
@@ -5155,6 +4817,7 @@ result<TimezoneComp> IcalParser::timezonec() {
                 return SYNTAX_ERROR("");
         }
 
+        ret.contentHash = source_hash(begin, is.tellg());
         ptran.commit();
         return ret;
 }
@@ -5227,17 +4890,27 @@ result<XComp> IcalParser::x_comp() {
 //       component  = 1*(eventc / todoc / journalc / freebusyc /
 //                    timezonec / iana-comp / x-comp)
 //
+// A component which began but then failed is reported as such, rather than
+// offered to the remaining alternatives.
 result<Component> IcalParser::component_single() {
         CALLSTACK;
         save_input_pos ptran(*is);
         Component ret;
-        if (auto v = eventc(); is_match(v)) ret = *v;
-        else if (auto v = todoc(); is_match(v)) ret = *v;
-        else if (auto v = journalc(); is_match(v)) ret = *v;
-        else if (auto v = freebusyc(); is_match(v)) ret = *v;
-        else if (auto v = timezonec(); is_match(v)) ret = *v;
-        else if (auto v = iana_comp(); is_match(v)) ret = *v;
-        else if (auto v = x_comp(); is_match(v)) ret = *v;
+        clear_memo();
+        if (auto v = eventc(); is_match(v)) ret = *std::move(v);
+        else if (is_error(v)) return get<ParsingError>(v);
+        else if (auto v = todoc(); is_match(v)) ret = *std::move(v);
+        else if (is_error(v)) return get<ParsingError>(v);
+        else if (auto v = journalc(); is_match(v)) ret = *std::move(v);
+        else if (is_error(v)) return get<ParsingError>(v);
+        else if (auto v = freebusyc(); is_match(v)) ret = *std::move(v);
+        else if (is_error(v)) return get<ParsingError>(v);
+        else if (auto v = timezonec(); is_match(v)) ret = *std::move(v);
+        else if (is_error(v)) return get<ParsingError>(v);
+        else if (auto v = iana_comp(); is_match(v)) ret = *std::move(v);
+        else if (is_error(v)) return get<ParsingError>(v);
+        else if (auto v = x_comp(); is_match(v)) ret = *std::move(v);
+        else if (is_error(v)) return get<ParsingError>(v);
         else return no_match;
         ptran.commit();
         return ret;
@@ -5246,15 +4919,108 @@ result<vector<Component>> IcalParser::component() {
         CALLSTACK;
         save_input_pos ptran(*is);
         vector<Component> ret;
-        for (auto v = component_single(); is_match(v); v = component_single()) {
-                ret.push_back(*v);
+        const auto skippedBefore = skippedComponents_;
+        while (true) {
+                const auto begin = parser_pos(is.tellg());
+                result<Component> v;
+                try {
+                        v = component_single();
+                } catch (syntax_error &e) {
+                        if (!options_.lenient) throw;
+                        v = ParsingError{SourceCodePos{}, parser_pos(e.pos),
+                                         e.what()};
+                } catch (not_implemented &e) {
+                        if (!options_.lenient) throw;
+                        v = ParsingError{SourceCodePos{}, parser_pos(e.pos),
+                                         e.what()};
+                }
+
+                if (is_match(v)) {
+                        ret.push_back(*std::move(v));
+                } else if (!is_error(v)) {
+                        break;
+                } else if (!options_.lenient ||
+                           !skip_component(begin, get<ParsingError>(v))) {
+                        return get<ParsingError>(v);
+                }
         }
-        if (ret.empty())
+        if (ret.empty() && skippedComponents_ == skippedBefore)
                 return no_match;
         ptran.commit();
         return ret;
 }
 
+// Skips from a BEGIN line to its matching END line. Stops early, before the
+// line, at the BEGIN of another top-level component or an unmatched END,
+// so that a component without END only takes its own lines along.
+bool IcalParser::skip_component(
+        ParserPos const &begin,
+        ParsingError const &error
+) {
+        CALLSTACK;
+        save_input_pos ptran(*is);
+        is->clear();
+
+        // Reads one physical line; returns "NAME:VALUE" upper-cased.
+        const auto read_line = [this](bool &eof) {
+                string ret;
+                while (true) {
+                        const auto c = is->get();
+                        if (c == std::char_traits<char>::eof()) {
+                                eof = ret.empty();
+                                is->clear();
+                                break;
+                        }
+                        if (c == '\n')
+                                break;
+                        if (c != '\r')
+                                ret += static_cast<char>(std::toupper(c));
+                }
+                return ret;
+        };
+        const auto top_level = [](string const &name) {
+                return name == "VEVENT" || name == "VTODO" ||
+                       name == "VJOURNAL" || name == "VFREEBUSY" ||
+                       name == "VTIMEZONE";
+        };
+
+        bool eof = false;
+        const auto first = read_line(eof);
+        if (eof || first.compare(0, 6, "BEGIN:") != 0)
+                return false;
+        const auto name = first.substr(6);
+
+        int depth = 0;
+        while (true) {
+                const auto pos = is.tellg();
+                const auto line = read_line(eof);
+                if (eof)
+                        break;
+                if (line.compare(0, 6, "BEGIN:") == 0) {
+                        if (top_level(line.substr(6))) {
+                                is->seekg(pos);
+                                break;
+                        }
+                        ++depth;
+                } else if (line.compare(0, 4, "END:") == 0) {
+                        if (depth > 0) {
+                                --depth;
+                        } else if (line.substr(4) == name) {
+                                break;
+                        } else {
+                                is->seekg(pos);
+                                break;
+                        }
+                }
+        }
+
+        ++skippedComponents_;
+        if (diagnostics_.size() < options_.maxDiagnostics)
+                diagnostics_.push_back(Diagnostic{begin, name, error});
+        ptran.commit();
+        return true;
+}
+
 // altrepparam = "ALTREP" "=" DQUOTE uri DQUOTE
 result<AltRepParam> IcalParser::altrepparam() {
         CALLSTACK;
@@ -5264,7 +5030,7 @@ result<AltRepParam> IcalParser::altrepparam() {
         if (!is_match(token("ALTREP"))) return no_match;
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
-        if (auto v = quoted_string(); is_match(v)) ret.value = *v;
+        if (auto v = quoted_string(); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         ptran.commit();
@@ -5280,7 +5046,7 @@ result<CnParam> IcalParser::cnparam() {
         if (!is_match(token("CN"))) return no_match;
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
-        if (auto v = param_value(); is_match(v)) ret.value = *v;
+        if (auto v = param_value(); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         ptran.commit();
@@ -5305,13 +5071,13 @@ result<CuTypeParam> IcalParser::cutypeparam() {
         if (!is_match(token("CUTYPE"))) return no_match;
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
-        if (auto v = token("INDIVIDUAL"); is_match(v)) ret.value = *v;
-        else if (auto v = token("GROUP"); is_match(v)) ret.value = *v;
-        else if (auto v = token("RESOURCE"); is_match(v)) ret.value = *v;
-        else if (auto v = token("ROOM"); is_match(v)) ret.value = *v;
-        else if (auto v = token("UNKNOWN"); is_match(v)) ret.value = *v;
-        else if (auto v = x_name(); is_match(v)) ret.value = *v;
-        else if (auto v = iana_token(); is_match(v)) ret.value = *v;
+        if (auto v = token("INDIVIDUAL"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("GROUP"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("RESOURCE"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("ROOM"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("UNKNOWN"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = x_name(); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = iana_token(); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         ptran.commit();
@@ -5329,13 +5095,13 @@ result<DelFromParam> IcalParser::delfromparam() {
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
         if (auto v = quoted_string(); is_match(v)) {
-                ret.values.push_back(*v);
+                ret.values.push_back(*std::move(v));
         } else {
                 return SYNTAX_ERROR("");
         }
         while (is_match(token(","))) {
                 if (auto v = quoted_string(); is_match(v)) {
-                        ret.values.push_back(*v);
+                        ret.values.push_back(*std::move(v));
                 } else {
                         return SYNTAX_ERROR("");
                 }
@@ -5355,13 +5121,13 @@ result<DelToParam> IcalParser::deltoparam() {
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
         if (auto v = quoted_string(); is_match(v)) {
-                ret.values.push_back(*v);
+                ret.values.push_back(*std::move(v));
         } else {
                 return SYNTAX_ERROR("");
         }
         while (is_match(token(","))) {
                 if (auto v = quoted_string(); is_match(v)) {
-                        ret.values.push_back(*v);
+                        ret.values.push_back(*std::move(v));
                 } else {
                         return SYNTAX_ERROR("");
                 }
@@ -5380,7 +5146,7 @@ result<DirParam> IcalParser::dirparam() {
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
         if (auto v = quoted_string(); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else {
                 return SYNTAX_ERROR("");
         }
@@ -5401,9 +5167,9 @@ result<EncodingParam> IcalParser::encodingparam() {
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
         if (auto v = token("8BIT"); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else if (auto v = token("BASE64"); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else {
                 return SYNTAX_ERROR("");
         }
@@ -5423,9 +5189,9 @@ result<FmtTypeParam> IcalParser::fmttypeparam() {
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
         if (auto v = read_type_name(*is)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else if (auto v = read_subtype_name(*is)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else {
                 return SYNTAX_ERROR("");
         }
@@ -5451,17 +5217,17 @@ result<FbTypeParam> IcalParser::fbtypeparam() {
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
         if (auto v = token("FREE"); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else if (auto v = token("BUSY"); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else if (auto v = token("BUSY-UNAVAILABLE"); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else if (auto v = token("BUSY-TENTATIVE"); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else if (auto v = x_name(); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else if (auto v = iana_token(); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else {
                 return SYNTAX_ERROR("");
         }
@@ -5481,7 +5247,7 @@ result<LanguageParam> IcalParser::languageparam() {
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
         if (auto v = read_language_tag(*is)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else {
                 return SYNTAX_ERROR("");
         }
@@ -5500,13 +5266,13 @@ result<MemberParam> IcalParser::memberparam() {
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
         if (auto v = cal_address(); is_match(v)) {
-                ret.values.push_back(*v);
+                ret.values.push_back(*std::move(v));
         } else {
                 return SYNTAX_ERROR("");
         }
         while (is_match(token(","))) {
                 if (auto v = cal_address(); is_match(v)) {
-                        ret.values.push_back(*v);
+                        ret.values.push_back(*std::move(v));
                 } else {
                         return SYNTAX_ERROR("");
                 }
@@ -5580,11 +5346,11 @@ result<PartStatParam> IcalParser::partstatparam() {
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
         if (auto v = partstat_event(); is_match(v)) {
-                ret = *v;
+                ret = *std::move(v);
         } else if (auto v = partstat_todo(); is_match(v)) {
-                ret = *v;
+                ret = *std::move(v);
         } else if (auto v = partstat_jour(); is_match(v)) {
-                ret = *v;
+                ret = *std::move(v);
         } else {
                 return SYNTAX_ERROR("");
         }
@@ -5604,7 +5370,7 @@ result<RangeParam> IcalParser::rangeparam() {
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
         if (auto v = token("THISANDFUTURE"); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else {
                 return SYNTAX_ERROR("");
         }
@@ -5625,9 +5391,9 @@ result<TrigRelParam> IcalParser::trigrelparam() {
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
         if (auto v = token("START"); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else if (auto v = token("END"); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else {
                 return SYNTAX_ERROR("");
         }
@@ -5657,17 +5423,17 @@ result<RoleParam> IcalParser::roleparam() {
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
         if (auto v = token("CHAIR"); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else if (auto v = token("REQ-PARTICIPANT"); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else if (auto v = token("OPT-PARTICIPANT"); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else if (auto v = token("NON-PARTICIPANT"); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else if (auto v = x_name(); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else if (auto v = iana_token(); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else {
                 return SYNTAX_ERROR("");
         }
@@ -5686,9 +5452,9 @@ result<RsvpParam> IcalParser::rsvpparam() {
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
         if (auto v = token("TRUE"); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else if (auto v = token("FALSE"); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else {
                 return SYNTAX_ERROR("");
         }
@@ -5707,7 +5473,7 @@ result<SentByParam> IcalParser::sentbyparam() {
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
         if (auto v = quoted_string(); is_match(v)) {
-                ret.value = *v;
+                ret.value = *std::move(v);
         } else {
                 return SYNTAX_ERROR("");
         }
@@ -5722,7 +5488,7 @@ result<TzIdPrefix> IcalParser::tzidprefix() {
         save_input_pos ptran(*is);
         TzIdPrefix ret;
 
-        if (auto v = token("/"); is_match(v)) ret.value = *v;
+        if (auto v = token("/"); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         ptran.commit();
@@ -5739,11 +5505,11 @@ result<TzIdParam> IcalParser::tzidparam() {
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
         if (auto v = tzidprefix(); is_match(v)) {
-                ret.prefix = *v;
+                ret.prefix = *std::move(v);
         }
 
         if (auto v = paramtext(); is_match(v)) {
-                ret.paramtext = *v;
+                ret.paramtext = intern(*v);
         } else {
                 return SYNTAX_ERROR("");
         }
@@ -5775,22 +5541,22 @@ result<ValueType> IcalParser::valuetype() {
         save_input_pos ptran(*is);
         ValueType ret;
 
-        if (auto v = token("BINARY"); is_match(v)) ret.value = *v;
-        else if (auto v = token("BOOLEAN"); is_match(v)) ret.value = *v;
-        else if (auto v = token("CAL-ADDRESS"); is_match(v)) ret.value = *v;
-        else if (auto v = token("DATE"); is_match(v)) ret.value = *v;
-        else if (auto v = token("DATE-TIME"); is_match(v)) ret.value = *v;
-        else if (auto v = token("DURATION"); is_match(v)) ret.value = *v;
-        else if (auto v = token("FLOAT"); is_match(v)) ret.value = *v;
-        else if (auto v = token("INTEGER"); is_match(v)) ret.value = *v;
-        else if (auto v = token("PERIOD"); is_match(v)) ret.value = *v;
-        else if (auto v = token("RECUR"); is_match(v)) ret.value = *v;
-        else if (auto v = token("TEXT"); is_match(v)) ret.value = *v;
-        else if (auto v = token("TIME"); is_match(v)) ret.value = *v;
-        else if (auto v = token("URI"); is_match(v)) ret.value = *v;
-        else if (auto v = token("UTC-OFFSET"); is_match(v)) ret.value = *v;
-        else if (auto v = x_name(); is_match(v)) ret.value = *v;
-        else if (auto v = iana_token(); is_match(v)) ret.value = *v;
+        if (auto v = token("BINARY"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("BOOLEAN"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("CAL-ADDRESS"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("DATE"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("DATE-TIME"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("DURATION"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("FLOAT"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("INTEGER"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("PERIOD"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("RECUR"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("TEXT"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("TIME"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("URI"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = token("UTC-OFFSET"); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = x_name(); is_match(v)) ret.value = *std::move(v);
+        else if (auto v = iana_token(); is_match(v)) ret.value = *std::move(v);
         else return no_match;
 
         ptran.commit();
@@ -5806,7 +5572,7 @@ result<ValueTypeParam> IcalParser::valuetypeparam() {
         if (!is_match(token("VALUE"))) return no_match;
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
-        if (auto v = valuetype(); is_match(v)) ret.value = *v;
+        if (auto v = valuetype(); is_match(v)) ret.value = *std::move(v);
         else return SYNTAX_ERROR("");
 
         ptran.commit();
@@ -5820,14 +5586,14 @@ result<IanaParam> IcalParser::iana_param() {
         save_input_pos ptran(*is);
         IanaParam ret;
 
-        if (auto v = iana_token(); is_match(v)) ret.token = *v;
+        if (auto v = iana_token(); is_match(v)) ret.token = *std::move(v);
         else return no_match;
 
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
         do {
                 if (auto v = param_value(); is_match(v))
-                        ret.values.push_back(*v);
+                        ret.values.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         } while (is_match(token(",")));
 
@@ -5842,14 +5608,14 @@ result<XParam> IcalParser::x_param() {
         save_input_pos ptran(*is);
         XParam ret;
 
-        if (auto v = x_name(); is_match(v)) ret.name = *v;
+        if (auto v = x_name(); is_match(v)) ret.name = intern(*v);
         else return no_match;
 
         if (!is_match(token("="))) return SYNTAX_ERROR("");
 
         do {
                 if (auto v = param_value(); is_match(v))
-                        ret.values.push_back(*v);
+                        ret.values.push_back(*std::move(v));
                 else return SYNTAX_ERROR("");
         } while (is_match(token(",")));
 
@@ -5882,7 +5648,7 @@ result<XParam> IcalParser::x_param() {
 ICalParameter IcalParser::expect_icalparameter() {
         CALLSTACK;
         if (auto v = icalparameter(); is_match(v))
-                return *v;
+                return *std::move(v);
         throw syntax_error(is.tellg());
 }
 result<ICalParameter> IcalParser::icalparameter() {
@@ -5890,27 +5656,27 @@ result<ICalParameter> IcalParser::icalparameter() {
         save_input_pos ptran(*is);
         ICalParameter ret;
 
-        if (auto v = altrepparam(); is_match(v)) ret = *v;
-        else if (auto v = cnparam(); is_match(v)) ret = *v;
-        else if (auto v = cutypeparam(); is_match(v)) ret = *v;
-        else if (auto v = delfromparam(); is_match(v)) ret = *v;
-        else if (auto v = deltoparam(); is_match(v)) ret = *v;
-        else if (auto v = dirparam(); is_match(v)) ret = *v;
-        else if (auto v = encodingparam(); is_match(v)) ret = *v;
-        else if (auto v = fmttypeparam(); is_match(v)) ret = *v;
-        else if (auto v = fbtypeparam(); is_match(v)) ret = *v;
-        else if (auto v = languageparam(); is_match(v)) ret = *v;
-        else if (auto v = memberparam(); is_match(v)) ret = *v;
-        else if (auto v = partstatparam(); is_match(v)) ret = *v;
-        else if (auto v = rangeparam(); is_match(v)) ret = *v;
-        else if (auto v = trigrelparam(); is_match(v)) ret = *v;
-        else if (auto v = reltypeparam(); is_match(v)) ret = *v;
-        else if (auto v = roleparam(); is_match(v)) ret = *v;
-        else if (auto v = rsvpparam(); is_match(v)) ret = *v;
-        else if (auto v = sentbyparam(); is_match(v)) ret = *v;
-        else if (auto v = tzidparam(); is_match(v)) ret = *v;
-        else if (auto v = valuetypeparam(); is_match(v)) ret = *v;
-        else if (auto v = other_param(); is_match(v)) ret = *v;
+        if (auto v = altrepparam(); is_match(v)) ret = *std::move(v);
+        else if (auto v = cnparam(); is_match(v)) ret = *std::move(v);
+        else if (auto v = cutypeparam(); is_match(v)) ret = *std::move(v);
+        else if (auto v = delfromparam(); is_match(v)) ret = *std::move(v);
+        else if (auto v = deltoparam(); is_match(v)) ret = *std::move(v);
+        else if (auto v = dirparam(); is_match(v)) ret = *std::move(v);
+        else if (auto v = encodingparam(); is_match(v)) ret = *std::move(v);
+        else if (auto v = fmttypeparam(); is_match(v)) ret = *std::move(v);
+        else if (auto v = fbtypeparam(); is_match(v)) ret = *std::move(v);
+        else if (auto v = languageparam(); is_match(v)) ret = *std::move(v);
+        else if (auto v = memberparam(); is_match(v)) ret = *std::move(v);
+        else if (auto v = partstatparam(); is_match(v)) ret = *std::move(v);
+        else if (auto v = rangeparam(); is_match(v)) ret = *std::move(v);
+        else if (auto v = trigrelparam(); is_match(v)) ret = *std::move(v);
+        else if (auto v = reltypeparam(); is_match(v)) ret = *std::move(v);
+        else if (auto v = roleparam(); is_match(v)) ret = *std::move(v);
+        else if (auto v = rsvpparam(); is_match(v)) ret = *std::move(v);
+        else if (auto v = sentbyparam(); is_match(v)) ret = *std::move(v);
+        else if (auto v = tzidparam(); is_match(v)) ret = *std::move(v);
+        else if (auto v = valuetypeparam(); is_match(v)) ret = *std::move(v);
+        else if (auto v = other_param(); is_match(v)) ret = *std::move(v);
         else return no_match;
 
         ptran.commit();
@@ -0,0 +1,170 @@
+#include "batch.hh"
+#include "mapped_file.hh"
+#include "parser_exceptions.hh"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+std::vector<std::string> find_ics_files(std::vector<std::string> const &roots) {
+        std::vector<std::pair<std::uintmax_t, std::string>> found;
+        const auto add = [&](fs::directory_entry const &e) {
+                std::error_code ec;
+                const auto size = e.file_size(ec);
+                found.emplace_back(ec ? 0 : size, e.path().string());
+        };
+        for (auto const &root : roots) {
+                std::error_code ec;
+                const fs::directory_entry entry(root, ec);
+                if (ec)
+                        continue;
+                if (entry.is_regular_file(ec)) {
+                        add(entry);
+                        continue;
+                }
+                for (fs::recursive_directory_iterator it(
+                             root, fs::directory_options::skip_permission_denied,
+                             ec), end;
+                     !ec && it != end; it.increment(ec)) {
+                        if (it->is_regular_file(ec) &&
+                            it->path().extension() == ".ics")
+                                add(*it);
+                }
+        }
+        std::sort(found.begin(), found.end(), [](auto const &a, auto const &b) {
+                return a.first != b.first ? a.first > b.first
+                                          : a.second < b.second;
+        });
+        std::vector<std::string> ret;
+        ret.reserve(found.size());
+        for (auto &f : found)
+                ret.push_back(std::move(f.second));
+        return ret;
+}
+
+namespace {
+FileResult parse_file(std::string const &path, ParserOptions options) {
+        FileResult ret;
+        ret.path = path;
+        StringPool strings;
+        options.strings = &strings;
+        try {
+                const MappedFile file(path);
+                ret.bytes = file.size();
+                imemstream is(file.data(), file.size());
+                IcalParser parser(is, options);
+                try {
+                        auto ical = parser.icalobject();
+                        if (is_match(ical)) {
+                                auto const &cal = get<Calendar>(ical);
+                                ret.ok = true;
+                                ret.components = cal.components.size();
+                                for (auto const &c : cal.components)
+                                        ret.events += holds_alternative<
+                                                EventComp>(c);
+                        } else if (is_error(ical)) {
+                                auto const &e = get<ParsingError>(ical);
+                                ret.error = "syntax error";
+                                if (!e.msg.empty())
+                                        ret.error += ": " + e.msg;
+                                ret.errorPos = e.parserPos;
+                        } else {
+                                ret.error = "not an iCalendar object";
+                        }
+                } catch (syntax_error &e) {
+                        ret.error = std::string("syntax error: ") + e.what();
+                        ret.errorPos = parser.parser_pos(e.pos);
+                } catch (not_implemented &e) {
+                        ret.error = std::string("not implemented: ") +
+                                    e.what();
+                        ret.errorPos = parser.parser_pos(e.pos);
+                }
+                ret.skippedComponents = parser.skipped_components();
+        } catch (std::exception &e) {
+                ret.error = e.what();
+        }
+        return ret;
+}
+
+// All work is known up front, so a queue is a plain deque behind a mutex.
+struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::size_t> items;
+
+        bool pop_back(std::size_t &item) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (items.empty())
+                        return false;
+                item = items.back();
+                items.pop_back();
+                return true;
+        }
+        bool steal(std::size_t &item) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (items.empty())
+                        return false;
+                item = items.front();
+                items.pop_front();
+                return true;
+        }
+};
+}
+
+BatchSummary parse_batch(std::vector<std::string> const &files,
+                         BatchOptions const &options,
+                         std::function<void(FileResult const &)> const &report
+) {
+        auto threads = options.threads ? options.threads
+                                       : std::thread::hardware_concurrency();
+        threads = std::max(1u, std::min<unsigned>(
+                threads, std::max<std::size_t>(files.size(), 1)));
+
+        // Dealt out round-robin, so every queue gets large and small files,
+        // with the largest at the back: a worker goes through its own from
+        // the largest down, and thieves take the smallest.
+        std::vector<std::unique_ptr<WorkQueue>> queues;
+        for (unsigned i = 0; i != threads; ++i)
+                queues.push_back(std::make_unique<WorkQueue>());
+        for (auto i = files.size(); i-- != 0;)
+                queues[i % threads]->items.push_back(i);
+
+        BatchSummary ret;
+        std::mutex reportMutex;
+        const auto start = std::chrono::steady_clock::now();
+
+        const auto work = [&](unsigned self) {
+                std::size_t item;
+                while (true) {
+                        bool found = queues[self]->pop_back(item);
+                        for (unsigned i = 1; !found && i != threads; ++i)
+                                found = queues[(self + i) % threads]->steal(item);
+                        if (!found)
+                                return;
+
+                        const auto r = parse_file(files[item], options.parser);
+                        std::lock_guard<std::mutex> lock(reportMutex);
+                        ++ret.files;
+                        ret.failed += !r.ok;
+                        ret.bytes += r.bytes;
+                        ret.events += r.events;
+                        if (report)
+                                report(r);
+                }
+        };
+        std::vector<std::thread> pool;
+        for (unsigned i = 1; i < threads; ++i)
+                pool.emplace_back(work, i);
+        work(0);
+        for (auto &t : pool)
+                t.join();
+
+        ret.seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+        return ret;
+}
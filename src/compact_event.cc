@@ -0,0 +1,63 @@
+#include "compact_event.hh"
+
+CompactEvent::CompactEvent(EventComp event) :
+        having_content_hash(event),
+        alarms(std::move(event.alarms))
+{
+        for (auto &p : event.properties)
+                add(std::move(p));
+}
+
+CompactEvent::CompactEvent(CompactEvent const &other) :
+        having_content_hash(other),
+        alarms(other.alarms),
+        present_(other.present_),
+        inline_(other.inline_),
+        boxed_(other.boxed_ ? std::make_unique<Boxed>(*other.boxed_)
+                            : nullptr),
+        others_(other.others_)
+{
+}
+
+CompactEvent& CompactEvent::operator=(CompactEvent const &other) {
+        if (this != &other)
+                *this = CompactEvent(other);
+        return *this;
+}
+
+void CompactEvent::add(EventProp p) {
+        std::visit([this, &p](auto &v) {
+                using T = std::decay_t<decltype(v)>;
+                if constexpr (has_slot<T>()) {
+                        if (!has<T>()) {
+                                set(std::move(v));
+                                return;
+                        }
+                }
+                others_.push_back(std::move(p));
+        }, static_cast<EventProp::variant &>(p));
+}
+
+std::size_t CompactEvent::property_count() const {
+        std::size_t ret = others_.size();
+        for (auto bits = present_; bits; bits &= bits - 1)
+                ++ret;
+        return ret;
+}
+
+EventComp CompactEvent::to_event() const {
+        EventComp ret;
+        static_cast<having_content_hash &>(ret) = *this;
+        ret.properties.reserve(property_count());
+        const auto slots = [this, &ret](auto const &...v) {
+                ((has<std::decay_t<decltype(v)>>()
+                  ? ret.properties.emplace_back(v), void() : void()), ...);
+        };
+        std::apply(slots, inline_);
+        if (boxed_)
+                std::apply(slots, *boxed_);
+        ret.properties.insert(ret.properties.end(),
+                              others_.begin(), others_.end());
+        ret.alarms = alarms;
+        return ret;
+}
@@ -0,0 +1,181 @@
+#include "content_hash.hh"
+#include <algorithm>
+
+namespace {
+
+inline std::uint64_t rotl64(std::uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+}
+
+inline std::uint64_t fmix64(std::uint64_t k) {
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ULL;
+        k ^= k >> 33;
+        return k;
+}
+
+// Little endian load, independent of the host byte order.
+inline std::uint64_t load64(unsigned char const *p) {
+        std::uint64_t ret = 0;
+        for (int i = 7; i >= 0; --i)
+                ret = (ret << 8) | p[i];
+        return ret;
+}
+
+inline void store64(unsigned char *p, std::uint64_t v) {
+        for (int i = 0; i != 8; ++i) {
+                p[i] = static_cast<unsigned char>(v);
+                v >>= 8;
+        }
+}
+
+bool starts_with_nocase(std::string_view v, std::string_view prefix) {
+        if (v.size() < prefix.size())
+                return false;
+        for (std::size_t i = 0; i != prefix.size(); ++i) {
+                auto c = v[i];
+                if (c >= 'a' && c <= 'z')
+                        c = c - 'a' + 'A';
+                if (c != prefix[i])
+                        return false;
+        }
+        return true;
+}
+
+// Order independent combination of a set of hashes.
+ContentHash fold(std::vector<ContentHash> &v) {
+        std::sort(v.begin(), v.end());
+        std::vector<unsigned char> bytes(v.size() * 16);
+        for (std::size_t i = 0; i != v.size(); ++i) {
+                store64(&bytes[i * 16], v[i].lo);
+                store64(&bytes[i * 16 + 8], v[i].hi);
+        }
+        return hash128(bytes.data(), bytes.size(), v.size());
+}
+
+}
+
+std::string to_string(ContentHash const &v) {
+        static const char digits[] = "0123456789abcdef";
+        std::string ret(32, '0');
+        for (int i = 0; i != 16; ++i) {
+                ret[15 - i] = digits[(v.hi >> (i * 4)) & 0xf];
+                ret[31 - i] = digits[(v.lo >> (i * 4)) & 0xf];
+        }
+        return ret;
+}
+
+//   MurmurHash3_x64_128, by Austin Appleby (public domain).
+ContentHash hash128(void const *data, std::size_t len, std::uint64_t seed) {
+        const auto bytes = static_cast<unsigned char const*>(data);
+        const auto nblocks = len / 16;
+
+        std::uint64_t h1 = seed, h2 = seed;
+        const std::uint64_t c1 = 0x87c37b91114253d5ULL;
+        const std::uint64_t c2 = 0x4cf5ad432745937fULL;
+
+        for (std::size_t i = 0; i != nblocks; ++i) {
+                auto k1 = load64(bytes + i * 16);
+                auto k2 = load64(bytes + i * 16 + 8);
+
+                k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+                h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+                k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+                h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+        }
+
+        const auto tail = bytes + nblocks * 16;
+        std::uint64_t k1 = 0, k2 = 0;
+        switch (len & 15) {
+        case 15: k2 ^= std::uint64_t(tail[14]) << 48;
+        case 14: k2 ^= std::uint64_t(tail[13]) << 40;
+        case 13: k2 ^= std::uint64_t(tail[12]) << 32;
+        case 12: k2 ^= std::uint64_t(tail[11]) << 24;
+        case 11: k2 ^= std::uint64_t(tail[10]) << 16;
+        case 10: k2 ^= std::uint64_t(tail[ 9]) << 8;
+        case  9: k2 ^= std::uint64_t(tail[ 8]);
+                 k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+        case  8: k1 ^= std::uint64_t(tail[ 7]) << 56;
+        case  7: k1 ^= std::uint64_t(tail[ 6]) << 48;
+        case  6: k1 ^= std::uint64_t(tail[ 5]) << 40;
+        case  5: k1 ^= std::uint64_t(tail[ 4]) << 32;
+        case  4: k1 ^= std::uint64_t(tail[ 3]) << 24;
+        case  3: k1 ^= std::uint64_t(tail[ 2]) << 16;
+        case  2: k1 ^= std::uint64_t(tail[ 1]) << 8;
+        case  1: k1 ^= std::uint64_t(tail[ 0]);
+                 k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+        };
+
+        h1 ^= len; h2 ^= len;
+        h1 += h2; h2 += h1;
+        h1 = fmix64(h1); h2 = fmix64(h2);
+        h1 += h2; h2 += h1;
+
+        return {h1, h2};
+}
+
+// -- ComponentHasher. ---------------------------------------------------------
+void ComponentHasher::add_line(std::string_view line) {
+        if (line.empty())
+                return;
+        if (levels_.empty())
+                levels_.emplace_back(); // root
+
+        if (starts_with_nocase(line, "BEGIN:")) {
+                levels_.emplace_back();
+                levels_.back().push_back(hash128(line));
+        } else if (starts_with_nocase(line, "END:") && levels_.size() > 1) {
+                levels_.back().push_back(hash128(line));
+                const auto h = fold(levels_.back());
+                levels_.pop_back();
+                levels_.back().push_back(h);
+        } else {
+                levels_.back().push_back(hash128(line));
+        }
+}
+
+ContentHash ComponentHasher::finish() {
+        if (levels_.empty())
+                return hash128(nullptr, 0);
+        // Close what has been left open.
+        while (levels_.size() > 1) {
+                const auto h = fold(levels_.back());
+                levels_.pop_back();
+                levels_.back().push_back(h);
+        }
+        auto &root = levels_.front();
+        const auto ret = root.size() == 1 ? root.front() : fold(root);
+        levels_.clear();
+        return ret;
+}
+
+ContentHash hash_component_text(std::string_view text) {
+        ComponentHasher hasher;
+        std::string line;
+        std::size_t i = 0;
+        const auto n = text.size();
+        while (i < n) {
+                const auto c = text[i];
+                if (c != '\r' && c != '\n') {
+                        line += c;
+                        ++i;
+                        continue;
+                }
+                // Line break: CRLF, LF or CR.
+                ++i;
+                if (c == '\r' && i < n && text[i] == '\n')
+                        ++i;
+                // Fold: the break and one following SP / HTAB vanish.
+                if (i < n && (text[i] == ' ' || text[i] == '\t')) {
+                        ++i;
+                        continue;
+                }
+                hasher.add_line(line);
+                line.clear();
+        }
+        hasher.add_line(line);
+        return hasher.finish();
+}
@@ -0,0 +1,210 @@
+#include "event_store.hh"
+#include "char_class.hh"
+
+namespace {
+
+// -- Conversions. -------------------------------------------------------------
+int to_int(string const &v) {
+        int ret = 0;
+        for (auto c : v) {
+                if (c < '0' || c > '9')
+                        break;
+                ret = ret * 10 + (c - '0');
+        }
+        return ret;
+}
+
+// Days since 1970-01-01 in the proleptic Gregorian calendar.
+std::int64_t days_from_civil(std::int64_t y, unsigned m, unsigned d) {
+        y -= m <= 2;
+        const auto era = (y >= 0 ? y : y - 399) / 400;
+        const auto yoe = static_cast<unsigned>(y - era * 400);
+        const auto doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+        const auto doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+std::int64_t epoch(Date const &v) {
+        return days_from_civil(to_int(v.year),
+                               static_cast<unsigned>(to_int(v.month)),
+                               static_cast<unsigned>(to_int(v.day))) * 86400;
+}
+
+std::int64_t epoch(DateTime const &v) {
+        return epoch(v.date) + to_int(v.time.hour.value) * 3600 +
+               to_int(v.time.minute.value) * 60 +
+               to_int(v.time.second.value);
+}
+
+struct When {
+        std::int64_t time;
+        bool allDay;
+        bool local;
+};
+
+template <typename Params>
+When when(xvariant<DateTime, Date> const &v, Params const &params) {
+        if (auto d = get_if<Date>(&v))
+                return {epoch(*d), true, true};
+        auto const &dt = get<DateTime>(v);
+        return {epoch(dt), false,
+                !dt.time.utc || !params.tz_id.paramtext.empty()};
+}
+
+// Recur::duration holds an empty Date when there is neither UNTIL nor COUNT.
+optional<std::int64_t> until(EndDate const &v) {
+        optional<std::int64_t> ret;
+        if (auto d = get_if<Date>(&v)) {
+                if (!d->year.empty())
+                        ret = epoch(*d);
+        } else {
+                ret = epoch(get<DateTime>(v));
+        }
+        return ret;
+}
+
+EventStatus event_status(string const &v) {
+        if (equal_ignore_case(v, "TENTATIVE")) return EventStatus::Tentative;
+        if (equal_ignore_case(v, "CONFIRMED")) return EventStatus::Confirmed;
+        if (equal_ignore_case(v, "CANCELLED")) return EventStatus::Cancelled;
+        return EventStatus::None;
+}
+
+string unescaped(Text const &v) {
+        return v.has_escapes() ? unescape_text(v.raw()) : v.raw();
+}
+}
+
+EventStore::EventStore() {
+        intern("");
+}
+
+void EventStore::add(Calendar const &cal) {
+        for (auto const &c : cal.components)
+                if (auto e = get_if<EventComp>(&c))
+                        add(*e);
+}
+
+void EventStore::add(EventComp const &event) {
+        const auto row = static_cast<std::uint32_t>(size());
+        std::int64_t start = no_time, end = no_time;
+        auto status = EventStatus::None;
+        std::uint8_t flags = 0;
+        std::int32_t sequence = 0;
+        StringId uid = no_string, summary = no_string, location = no_string;
+        auto rrule = no_rrule;
+
+        for (auto const &p : event.properties) {
+                if (auto v = get_if<DtStart>(&p)) {
+                        const auto w = when(v->value, v->params);
+                        start = w.time;
+                        if (w.allDay) flags |= event_all_day;
+                        if (w.local) flags |= event_start_local;
+                } else if (auto v = get_if<DtEnd>(&p)) {
+                        const auto w = when(v->value, v->params);
+                        end = w.time;
+                        if (w.local) flags |= event_end_local;
+                } else if (auto v = get_if<Status>(&p)) {
+                        visit([&](having_string_value const &s) {
+                                status = event_status(s.value);
+                        }, v->value);
+                } else if (auto v = get_if<Transp>(&p)) {
+                        if (equal_ignore_case(v->value, "TRANSPARENT"))
+                                flags |= event_transparent;
+                } else if (auto v = get_if<Seq>(&p)) {
+                        sequence = v->value;
+                } else if (auto v = get_if<Uid>(&p)) {
+                        uid = intern(v->value);
+                } else if (auto v = get_if<Summary>(&p)) {
+                        summary = intern(unescaped(v->value));
+                } else if (auto v = get_if<Location>(&p)) {
+                        location = intern(unescape_text(v->value.view()));
+                } else if (auto v = get_if<RRule>(&p)) {
+                        RRulePlan plan;
+                        const auto &r = v->recur;
+                        plan.freq = r.freq;
+                        if (r.interval)
+                                plan.interval = to_int(*r.interval);
+                        if (auto u = get_if<EndDate>(&r.duration))
+                                plan.until = until(*u).value_or(plan.until);
+                        else if (auto c = get_if<string>(&r.duration))
+                                plan.count = to_int(*c);
+                        rrule = static_cast<std::uint32_t>(rrules_.size());
+                        rrules_.push_back(plan);
+                }
+        }
+
+        dtStart_.push_back(start);
+        dtEnd_.push_back(end);
+        status_.push_back(status);
+        flags_.push_back(flags);
+        sequence_.push_back(sequence);
+        uid_.push_back(uid);
+        summary_.push_back(summary);
+        location_.push_back(location);
+        rrule_.push_back(rrule);
+        if (rrule != no_rrule)
+                recurring_.push_back(row);
+}
+
+void EventStore::reserve(std::size_t events) {
+        dtStart_.reserve(events);
+        dtEnd_.reserve(events);
+        status_.reserve(events);
+        flags_.reserve(events);
+        sequence_.reserve(events);
+        uid_.reserve(events);
+        summary_.reserve(events);
+        location_.reserve(events);
+        rrule_.reserve(events);
+}
+
+EventStore::StringId EventStore::intern(std::string_view v) {
+        auto it = stringIds_.find(string(v));
+        if (it != stringIds_.end())
+                return it->second;
+        const auto id = static_cast<StringId>(strings_.size());
+        strings_.emplace_back(v);
+        stringIds_.emplace(strings_.back(), id);
+        return id;
+}
+
+// -- Scans. -------------------------------------------------------------------
+// One pass over the columns writes a 0/1 byte per row. It has no branches
+// and no calls, so that it vectorizes; a second pass turns the bytes into
+// row numbers.
+void EventStore::match(EventQuery const &q, std::uint8_t *hits) const {
+        const auto n = size();
+        const auto *start = dtStart_.data();
+        const auto *status =
+                reinterpret_cast<std::uint8_t const *>(status_.data());
+        const auto *flags = flags_.data();
+        const auto from = q.startFrom, to = q.startTo;
+        const unsigned statuses = q.statuses;
+        const unsigned without = q.withoutFlags;
+        for (std::size_t i = 0; i != n; ++i) {
+                hits[i] = static_cast<std::uint8_t>(
+                        (start[i] >= from) & (start[i] < to) &
+                        (statuses >> status[i]) &
+                        ((flags[i] & without) == 0));
+        }
+}
+
+std::vector<std::uint32_t> EventStore::select(EventQuery const &q) const {
+        std::vector<std::uint8_t> hits(size());
+        match(q, hits.data());
+        std::vector<std::uint32_t> ret;
+        for (std::size_t i = 0; i != hits.size(); ++i)
+                if (hits[i])
+                        ret.push_back(static_cast<std::uint32_t>(i));
+        return ret;
+}
+
+std::size_t EventStore::count(EventQuery const &q) const {
+        std::vector<std::uint8_t> hits(size());
+        match(q, hits.data());
+        std::size_t ret = 0;
+        for (auto h : hits)
+                ret += h;
+        return ret;
+}
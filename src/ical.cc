@@ -1,2 +1,65 @@
 #include "ical.hh"
+#include <cstring>
 
+// -- TEXT. --------------------------------------------------------------------
+Text::Text(string raw) :
+        raw_(std::move(raw)),
+        hasEscapes_(std::memchr(raw_.data(), '\\', raw_.size()) != nullptr)
+{
+}
+
+string const& Text::decoded() const {
+        if (!hasEscapes_)
+                return raw_;
+        if (!decoded_)
+                decoded_ = unescape_text(raw_);
+        return *decoded_;
+}
+
+string unescape_text(std::string_view raw) {
+        string ret;
+        ret.reserve(raw.size());
+        auto const *p = raw.data();
+        auto const *end = p + raw.size();
+        while (p != end) {
+                // memchr() scans a vector register at a time, and the run
+                // up to the backslash is copied as a whole.
+                auto const *bs = static_cast<char const *>(
+                        std::memchr(p, '\\', end - p));
+                if (bs == nullptr) {
+                        ret.append(p, end);
+                        break;
+                }
+                ret.append(p, bs);
+                if (bs + 1 == end) {
+                        ret += '\\';
+                        break;
+                }
+                switch (bs[1]) {
+                case 'N':
+                case 'n':
+                        ret += '\n';
+                        break;
+                default:
+                        ret += bs[1];
+                        break;
+                }
+                p = bs + 2;
+        }
+        return ret;
+}
+
+string escape_text(std::string_view text) {
+        string ret;
+        ret.reserve(text.size());
+        for (auto c : text) {
+                switch (c) {
+                case '\\': ret += "\\\\"; break;
+                case ';':  ret += "\\;"; break;
+                case ',':  ret += "\\,"; break;
+                case '\n': ret += "\\n"; break;
+                default:   ret += c; break;
+                }
+        }
+        return ret;
+}
@@ -2,6 +2,10 @@
 #include <iostream>
 
 
+std::ostream& operator<<(std::ostream& os, Text const &v) {
+        return os << v.raw();
+}
+
 std::ostream& operator<<(std::ostream& os, ProdId const& v) {
         return os << "<ProdId: " << v.value << ">";
 }
@@ -194,7 +198,7 @@ std::ostream& operator<<(std::ostream& os, Summary const &v) {
 }
 
 std::ostream& operator<<(std::ostream& os, Transp const &v) {
-        return os << "<Transp>";
+        return os << "Transp:" << v.value;
 }
 
 std::ostream& operator<<(std::ostream& os, Url const &v) {
@@ -0,0 +1,1595 @@
+#include "jcal.hh"
+#include "char_class.hh"
+#include "content_hash.hh"
+#include "parser_exceptions.hh"
+#include "parser_helpers.hh"
+#include "value_format.hh"
+#include <cstring>
+
+// -- JSON strings. ------------------------------------------------------------
+namespace {
+bool needs_json_escape(char c) {
+        return static_cast<unsigned char>(c) < 0x20 || c == '"' || c == '\\';
+}
+
+void append_json_escape(OutputBuffer &out, char c) {
+        switch (c) {
+        case '"':  out << "\\\""; return;
+        case '\\': out << "\\\\"; return;
+        case '\b': out << "\\b"; return;
+        case '\f': out << "\\f"; return;
+        case '\n': out << "\\n"; return;
+        case '\r': out << "\\r"; return;
+        case '\t': out << "\\t"; return;
+        }
+        static constexpr char hex[] = "0123456789abcdef";
+        const auto u = static_cast<unsigned char>(c);
+        const char esc[] = {'\\', 'u', '0', '0', hex[u >> 4], hex[u & 15]};
+        out.append(std::string_view(esc, sizeof esc));
+}
+}
+
+// UTF-8 passes through: the parser validated it, and JSON takes it as is.
+void append_json_string(OutputBuffer &out, std::string_view v) {
+        out.put('"');
+        auto p = v.data();
+        const auto end = p + v.size();
+        while (p != end) {
+                auto run = p;
+                for (; end - run >= 8; run += 8) {
+                        const auto x = swar::load(run);
+                        if (swar::has_below(x, 0x20) ||
+                            swar::has_byte(x, '"') || swar::has_byte(x, '\\'))
+                                break;
+                }
+                while (run != end && !needs_json_escape(*run))
+                        ++run;
+                out.append(std::string_view(p, run - p));
+                if (run == end)
+                        break;
+                append_json_escape(out, *run);
+                p = run + 1;
+        }
+        out.put('"');
+}
+
+namespace {
+
+// -- JcalWriter. --------------------------------------------------------------
+// Commas are placed by needComma_: set after each complete value, and reset
+// by each opening bracket.
+class JcalWriter {
+public:
+        explicit JcalWriter(OutputBuffer &out) : out_(out) {}
+
+        void calendar(Calendar const &cal) {
+                open('[');
+                str("vcalendar");
+                open('[');
+                calprops(cal.properties);
+                close(']');
+                open('[');
+                for (auto const &c : cal.components)
+                        component(c);
+                close(']');
+                close(']');
+        }
+
+        void component(Component const &v) {
+                visit([this](auto const &c) { add(c); }, v);
+        }
+
+private:
+        // -- JSON. ------------------------------------------------------------
+        void sep() {
+                if (needComma_)
+                        out_.put(',');
+        }
+        void open(char c) {
+                sep();
+                out_.put(c);
+                needComma_ = false;
+        }
+        void close(char c) {
+                out_.put(c);
+                needComma_ = true;
+        }
+        void str(std::string_view v) {
+                sep();
+                append_json_string(out_, v);
+                needComma_ = true;
+        }
+        void key(std::string_view v) {
+                str(v);
+                out_.put(':');
+                needComma_ = false;
+        }
+        // From the digits of the grammar, e.g. "+07", to a JSON number.
+        void number(std::string_view v) {
+                sep();
+                if (!v.empty() && (v[0] == '+' || v[0] == '-')) {
+                        if (v[0] == '-')
+                                out_.put('-');
+                        v.remove_prefix(1);
+                }
+                while (v.size() > 1 && v[0] == '0' && v[1] != '.')
+                        v.remove_prefix(1);
+                out_ << (v.empty() ? std::string_view("0") : v);
+                needComma_ = true;
+        }
+        void number(int v) {
+                number(std::to_string(v));
+        }
+        // TEXT as in the file, to be decoded.
+        void text(std::string_view raw) {
+                if (std::memchr(raw.data(), '\\', raw.size()))
+                        str(unescape_text(raw));
+                else
+                        str(raw);
+        }
+        void text(string const &raw) {
+                text(std::string_view(raw));
+        }
+        void text(Text const &v) {
+                if (v.has_escapes())
+                        str(unescape_text(v.raw()));
+                else
+                        str(v.raw());
+        }
+        template <typename T>
+        void formatted(T const &v) {
+                scratch_.clear();
+                append_value(scratch_, v);
+                str(scratch_);
+        }
+
+        // -- Properties and parameters. ---------------------------------------
+        void begin(std::string_view name) {
+                open('[');
+                str(name);
+                open('{');
+        }
+        void type(std::string_view type) {
+                close('}');
+                str(type);
+        }
+        void end() {
+                close(']');
+        }
+
+        void param(std::string_view name, std::string_view value) {
+                key(name);
+                str(value);
+        }
+        void param(std::string_view name, vector<string> const &values) {
+                key(name);
+                if (values.size() == 1) {
+                        str(values.front());
+                        return;
+                }
+                open('[');
+                for (auto const &v : values)
+                        str(v);
+                close(']');
+        }
+        void params(vector<OtherParam> const &v) {
+                for (auto const &p : v)
+                        param(p);
+        }
+        void param(OtherParam const &v) {
+                if (auto p = get_if<XParam>(&v))
+                        param(lower_case(p->name.view()), p->values);
+                else
+                        param(lower_case(get<IanaParam>(v).token),
+                              get<IanaParam>(v).values);
+        }
+        void param(TzIdParam const &v) {
+                if (v.paramtext.empty())
+                        return;
+                scratch_ = v.prefix ? v.prefix->value : string();
+                scratch_ += v.paramtext.str();
+                param("tzid", scratch_);
+        }
+        void param(ICalParameter const &v) {
+                visit([this](auto const &p) { any_param(p); }, v);
+        }
+        void any_param(AltRepParam const &v)   { param("altrep", v.value); }
+        void any_param(CnParam const &v)       { param("cn", v.value); }
+        void any_param(CuTypeParam const &v)   { param("cutype", v.value); }
+        void any_param(DelFromParam const &v)  {
+                param("delegated-from", v.values);
+        }
+        void any_param(DelToParam const &v)    {
+                param("delegated-to", v.values);
+        }
+        void any_param(DirParam const &v)      { param("dir", v.value); }
+        void any_param(EncodingParam const &v) { param("encoding", v.value); }
+        void any_param(FmtTypeParam const &v)  { param("fmttype", v.value); }
+        void any_param(FbTypeParam const &v)   { param("fbtype", v.value); }
+        void any_param(LanguageParam const &v) { param("language", v.value); }
+        void any_param(MemberParam const &v)   {
+                vector<string> uris;
+                for (auto const &u : v.values)
+                        uris.push_back(to_string(u));
+                param("member", uris);
+        }
+        void any_param(PartStatParam const &v) {
+                visit([this](having_string_value const &p) {
+                        param("partstat", p.value);
+                }, v);
+        }
+        void any_param(RangeParam const &v)    { param("range", v.value); }
+        void any_param(TrigRelParam const &v)  { param("related", v.value); }
+        void any_param(RelTypeParam const &v)  { param("reltype", v.value); }
+        void any_param(RoleParam const &v)     { param("role", v.value); }
+        void any_param(RsvpParam const &v)     { param("rsvp", v.value); }
+        void any_param(SentByParam const &v)   { param("sent-by", v.value); }
+        void any_param(TzIdParam const &v)     { param(v); }
+        // The type of the value, see value_type().
+        void any_param(ValueTypeParam const &) {}
+        void any_param(OtherParam const &v)    { param(v); }
+
+        // Typed by a VALUE parameter, else "unknown" (RFC 7265, 5).
+        void other_value(vector<ICalParameter> const &params,
+                         string const &value) {
+                string t = "unknown";
+                for (auto const &p : params)
+                        if (auto v = get_if<ValueTypeParam>(&p))
+                                t = lower_case(v->value.value);
+                type(t);
+                if (t == "text")
+                        text(value);
+                else
+                        str(value);
+        }
+
+        // A property with other-params only and a single value.
+        template <typename Value>
+        void simple(std::string_view name, vector<OtherParam> const &ps,
+                    std::string_view type, Value const &value) {
+                begin(name);
+                params(ps);
+                this->type(type);
+                single(value);
+                end();
+        }
+        void single(Text const &v)     { text(v); }
+        void single(string const &v)   { text(v); }
+        void single(int v)             { number(v); }
+        void single(Date const &v)     { formatted(v); }
+        void single(DateTime const &v) { formatted(v); }
+
+        // -- Calendar properties. ---------------------------------------------
+        void calprops(CalProps const &v) {
+                simple("prodid", v.prodId.params, "text", v.prodId.value);
+                simple("version", v.version.params, "text", v.version.value);
+                if (v.calScale)
+                        simple("calscale", v.calScale->params, "text",
+                               v.calScale->value);
+                if (v.method)
+                        simple("method", v.method->params, "text",
+                               v.method->value);
+        }
+
+        // -- Components. ------------------------------------------------------
+        void add(EventComp const &v) {
+                open('[');
+                str("vevent");
+                open('[');
+                for (auto const &p : v.properties)
+                        visit([this](auto const &x) { add(x); }, p);
+                close(']');
+                open('[');
+                for (auto const &a : v.alarms)
+                        visit([this](auto const &x) { alarm(x); }, a);
+                close(']');
+                close(']');
+        }
+
+        void add(TimezoneComp const &v) {
+                open('[');
+                str("vtimezone");
+                open('[');
+                begin("tzid");
+                params(v.tzId.propParams.params);
+                type("text");
+                scratch_ = v.tzId.prefix.value + v.tzId.text;
+                text(scratch_);
+                end();
+                if (v.lastMod)
+                        add(*v.lastMod);
+                if (v.tzUrl) {
+                        begin("tzurl");
+                        params(v.tzUrl->params.params);
+                        type("uri");
+                        str(to_string(v.tzUrl->uri));
+                        end();
+                }
+                for (auto const &x : v.xProps)
+                        add(x);
+                for (auto const &x : v.ianaProps)
+                        add(x);
+                close(']');
+                open('[');
+                if (auto p = get_if<StandardC>(&v.observance))
+                        observance("standard", p->tzProp);
+                if (auto p = get_if<DaylightC>(&v.observance))
+                        observance("daylight", p->tzProp);
+                close(']');
+                close(']');
+        }
+
+        // Not modelled by the AST yet.
+        template <typename T>
+        void add(T const &) {}
+
+        void observance(std::string_view name, TzProp const &v) {
+                open('[');
+                str(name);
+                open('[');
+                add(v.dtStart);
+                offset("tzoffsetto", v.offsetTo.param.otherParams,
+                       v.offsetTo.utcOffset);
+                offset("tzoffsetfrom", v.offsetFrom.param.otherParams,
+                       v.offsetFrom.utcOffset);
+                if (v.rRule)
+                        add(*v.rRule);
+                for (auto const &n : v.tzNames) {
+                        begin("tzname");
+                        if (!n.param.languageParam.value.empty())
+                                param("language", n.param.languageParam.value);
+                        params(n.param.otherParams);
+                        type("text");
+                        text(n.text);
+                        end();
+                }
+                for (auto const &x : v.xProps)
+                        add(x);
+                for (auto const &x : v.ianaProps)
+                        add(x);
+                close(']');
+                open('[');
+                close(']');
+                close(']');
+        }
+
+        void offset(std::string_view name, vector<OtherParam> const &ps,
+                    UtcOffset const &v) {
+                begin(name);
+                params(ps);
+                type("utc-offset");
+                formatted(v);
+                end();
+        }
+
+        template <typename Alarm>
+        void alarm(Alarm const &v) {
+                open('[');
+                str("valarm");
+                open('[');
+                alarm_props(v);
+                if (v.repeat)
+                        simple("repeat", v.repeat->params.params, "integer",
+                               v.repeat->value);
+                for (auto const &x : v.xProps)
+                        add(x);
+                for (auto const &x : v.ianaProps)
+                        add(x);
+                close(']');
+                open('[');
+                close(']');
+                close(']');
+        }
+        void alarm_props(AudioProp const &v) {
+                add(v.action);
+                add(v.trigger);
+        }
+        void alarm_props(DispProp const &v) {
+                add(v.action);
+                add(v.description);
+                add(v.trigger);
+        }
+        void alarm_props(EmailProp const &v) {
+                add(v.action);
+                add(v.description);
+                add(v.trigger);
+                add(v.summary);
+        }
+
+        // -- Properties. ------------------------------------------------------
+        void add(DtStamp const &v) {
+                simple("dtstamp", v.params.params, "date-time", v.date_time);
+        }
+        void add(Uid const &v) {
+                simple("uid", v.params, "text", v.value);
+        }
+        template <typename DtProp>
+        void date_prop(std::string_view name, DtProp const &v) {
+                begin(name);
+                param(v.params.tz_id);
+                params(v.params.params);
+                if (auto d = get_if<Date>(&v.value)) {
+                        type("date");
+                        formatted(*d);
+                } else {
+                        type("date-time");
+                        formatted(get<DateTime>(v.value));
+                }
+                end();
+        }
+        void add(DtStart const &v) { date_prop("dtstart", v); }
+        void add(DtEnd const &v)   { date_prop("dtend", v); }
+        void add(Class const &v) {
+                simple("class", v.params.params, "text", v.value);
+        }
+        void add(Created const &v) {
+                simple("created", v.params.params, "date-time", v.dateTime);
+        }
+        template <typename TextProp>
+        void text_prop(std::string_view name, TextProp const &v) {
+                begin(name);
+                if (v.params.alt_rep)
+                        param("altrep", v.params.alt_rep->value);
+                if (v.params.language)
+                        param("language", v.params.language->value);
+                params(v.params.params);
+                type("text");
+                text(v.value);
+                end();
+        }
+        void add(Description const &v) { text_prop("description", v); }
+        void add(Summary const &v)     { text_prop("summary", v); }
+        void add(Geo const &v) {
+                begin("geo");
+                params(v.params.params);
+                type("float");
+                open('[');
+                number(v.value.latitude);
+                number(v.value.longitude);
+                close(']');
+                end();
+        }
+        void add(LastMod const &v) {
+                simple("last-modified", v.params.params, "date-time",
+                       v.dateTime);
+        }
+        void add(Location const &v) {
+                begin("location");
+                if (v.params.alt_rep)
+                        param("altrep", v.params.alt_rep->value);
+                if (v.params.language)
+                        param("language", v.params.language->value);
+                params(v.params.params);
+                type("text");
+                text(v.value.view());
+                end();
+        }
+        void add(Organizer const &v) {
+                begin("organizer");
+                const auto &p = v.params;
+                if (p.cn) param("cn", p.cn->value);
+                if (p.dir) param("dir", p.dir->value);
+                if (p.sentBy) param("sent-by", p.sentBy->value);
+                if (p.language) param("language", p.language->value);
+                params(p.params);
+                type("cal-address");
+                str(to_string(v.address));
+                end();
+        }
+        void add(Seq const &v) {
+                simple("sequence", v.params.params, "integer", v.value);
+        }
+        void add(Status const &v) {
+                visit([&](having_string_value const &s) {
+                        simple("status", v.params.params, "text", s.value);
+                }, v.value);
+        }
+        void add(Transp const &v) {
+                simple("transp", v.params.params, "text", v.value);
+        }
+        void add(RRule const &v) {
+                begin("rrule");
+                params(v.param.otherParams);
+                type("recur");
+                recur(v.recur);
+                end();
+        }
+        void add(Categories const &v) {
+                begin("categories");
+                if (v.params.language)
+                        param("language", v.params.language->value);
+                params(v.params.params);
+                type("text");
+                for (auto const &c : v.values)
+                        text(c.view());
+                end();
+        }
+        void add(XProp const &v) {
+                begin(lower_case(v.name.view()));
+                for (auto const &p : v.params)
+                        param(p);
+                other_value(v.params, v.value);
+                end();
+        }
+        void add(IanaProp const &v) {
+                begin(lower_case(v.ianaToken));
+                for (auto const &p : v.params)
+                        param(p);
+                other_value(v.params, v.value);
+                end();
+        }
+        void add(Action const &v) {
+                simple("action", v.params.params, "text", v.value);
+        }
+        void add(Trigger const &v) {
+                begin("trigger");
+                if (auto r = get_if<TrigRel>(&v)) {
+                        if (!r->trigRelParam.value.empty())
+                                param("related", r->trigRelParam.value);
+                        params(r->params);
+                        type("duration");
+                        formatted(r->durValue);
+                } else {
+                        auto const &a = get<TrigAbs>(v);
+                        params(a.params);
+                        type("date-time");
+                        formatted(a.dateTime);
+                }
+                end();
+        }
+
+        // RFC 7265, 3.6.10: one value as it is, several as an array.
+        template <typename T, typename Fun>
+        void recur_part(std::string_view name, optional<vector<T>> const &v,
+                        Fun const &fun) {
+                if (!v || v->empty())
+                        return;
+                key(name);
+                if (v->size() > 1)
+                        open('[');
+                for (auto const &x : *v)
+                        fun(x);
+                if (v->size() > 1)
+                        close(']');
+        }
+        void recur(Recur const &v) {
+                open('{');
+                key("freq");
+                str(to_string(v.freq));
+                if (auto until = get_if<EndDate>(&v.duration)) {
+                        // Default constructed without UNTIL and COUNT.
+                        if (!date_of(*until).year.empty()) {
+                                key("until");
+                                visit([this](auto const &d) { formatted(d); },
+                                      *until);
+                        }
+                } else if (auto count = get_if<string>(&v.duration)) {
+                        if (!count->empty()) {
+                                key("count");
+                                number(*count);
+                        }
+                }
+                if (v.interval) {
+                        key("interval");
+                        number(*v.interval);
+                }
+                const auto num = [this](string const &x) { number(x); };
+                const auto signedNum = [this](auto const &x) {
+                        scratch_ = x.sign < 0 ? "-" : "";
+                        scratch_ += x.day;
+                        number(scratch_);
+                };
+                recur_part("bysecond", v.bySecond, num);
+                recur_part("byminute", v.byMinute, num);
+                recur_part("byhour", v.byHour, num);
+                recur_part("byday", v.byDay, [this](WeekDayNum const &x) {
+                        str(to_string(x));
+                });
+                recur_part("bymonthday", v.byMonthDay, signedNum);
+                recur_part("byyearday", v.byYearDay, signedNum);
+                recur_part("bymonth", v.byMonth, num);
+                recur_part("bysetpos", v.bySetpos, signedNum);
+                if (v.wkst) {
+                        key("wkst");
+                        str(to_string(*v.wkst));
+                }
+                close('}');
+        }
+
+        OutputBuffer &out_;
+        bool needComma_ = false;
+        string scratch_;
+};
+}
+
+void write_jcal(OutputBuffer &out, Calendar const &cal) {
+        JcalWriter(out).calendar(cal);
+}
+
+void write_jcal(OutputBuffer &out, Component const &c) {
+        JcalWriter(out).component(c);
+}
+
+std::string to_jcal(Calendar const &cal) {
+        OutputBuffer out;
+        write_jcal(out, cal);
+        return out.take();
+}
+
+// -- JSON tokens. -------------------------------------------------------------
+namespace {
+class JsonLexer {
+public:
+        enum Kind {
+                BeginArray, EndArray, BeginObject, EndObject, Comma, Colon,
+                String, Number, Literal, End
+        };
+        struct Token {
+                Kind kind = End;
+                std::string_view text;  // of String, Number and Literal
+                std::size_t offset = 0;
+        };
+
+        explicit JsonLexer(std::string_view in) : in_(in) {}
+
+        Token const& peek() {
+                if (!peeked_) {
+                        token_ = lex();
+                        peeked_ = true;
+                }
+                return token_;
+        }
+        Token next() {
+                peek();
+                peeked_ = false;
+                return token_;
+        }
+        std::size_t offset() const {
+                return peeked_ ? token_.offset : pos_;
+        }
+
+private:
+        [[noreturn]] void fail(std::size_t offset, char const *msg) const {
+                throw syntax_error(std::streampos(offset), msg);
+        }
+
+        Token lex() {
+                while (pos_ != in_.size() &&
+                       (in_[pos_] == ' ' || in_[pos_] == '\t' ||
+                        in_[pos_] == '\n' || in_[pos_] == '\r'))
+                        ++pos_;
+                Token ret;
+                ret.offset = pos_;
+                if (pos_ == in_.size())
+                        return ret;
+                switch (in_[pos_]) {
+                case '[': ret.kind = BeginArray; break;
+                case ']': ret.kind = EndArray; break;
+                case '{': ret.kind = BeginObject; break;
+                case '}': ret.kind = EndObject; break;
+                case ',': ret.kind = Comma; break;
+                case ':': ret.kind = Colon; break;
+                case '"':
+                        ret.kind = String;
+                        ret.text = string_token();
+                        return ret;
+                default:
+                        return scalar(ret);
+                }
+                ++pos_;
+                return ret;
+        }
+
+        Token& scalar(Token &ret) {
+                const auto begin = pos_;
+                const auto c = in_[pos_];
+                if (c == '-' || (c >= '0' && c <= '9')) {
+                        ret.kind = Number;
+                        while (pos_ != in_.size() &&
+                               std::strchr("+-.eE0123456789", in_[pos_]) &&
+                               in_[pos_] != '\0')
+                                ++pos_;
+                } else {
+                        ret.kind = Literal;
+                        while (pos_ != in_.size() && is_in(in_[pos_], cc_alpha))
+                                ++pos_;
+                        const auto v = in_.substr(begin, pos_ - begin);
+                        if (v != "true" && v != "false" && v != "null")
+                                fail(begin, "unexpected character");
+                }
+                ret.text = in_.substr(begin, pos_ - begin);
+                return ret;
+        }
+
+        // A view into the input if the string has no escapes, else into
+        // buffer_, which the next string reuses.
+        std::string_view string_token() {
+                const auto begin = ++pos_;
+                auto p = in_.data() + pos_;
+                const auto end = in_.data() + in_.size();
+                for (; end - p >= 8; p += 8) {
+                        const auto x = swar::load(p);
+                        if (swar::has_below(x, 0x20) ||
+                            swar::has_byte(x, '"') || swar::has_byte(x, '\\'))
+                                break;
+                }
+                while (p != end && *p != '"' && *p != '\\' &&
+                       static_cast<unsigned char>(*p) >= 0x20)
+                        ++p;
+                pos_ = p - in_.data();
+                if (p != end && *p == '"') {
+                        ++pos_;
+                        return in_.substr(begin, pos_ - 1 - begin);
+                }
+                buffer_.assign(in_.data() + begin, p);
+                return escaped_string();
+        }
+
+        std::string_view escaped_string() {
+                while (true) {
+                        if (pos_ == in_.size())
+                                fail(pos_, "unterminated string");
+                        const auto c = in_[pos_++];
+                        if (c == '"')
+                                return buffer_;
+                        if (static_cast<unsigned char>(c) < 0x20)
+                                fail(pos_ - 1, "control character in string");
+                        if (c != '\\') {
+                                buffer_ += c;
+                                continue;
+                        }
+                        if (pos_ == in_.size())
+                                fail(pos_, "unterminated string");
+                        switch (in_[pos_++]) {
+                        case '"':  buffer_ += '"'; break;
+                        case '\\': buffer_ += '\\'; break;
+                        case '/':  buffer_ += '/'; break;
+                        case 'b':  buffer_ += '\b'; break;
+                        case 'f':  buffer_ += '\f'; break;
+                        case 'n':  buffer_ += '\n'; break;
+                        case 'r':  buffer_ += '\r'; break;
+                        case 't':  buffer_ += '\t'; break;
+                        case 'u':  append_utf8(code_point()); break;
+                        default:   fail(pos_ - 1, "invalid escape");
+                        }
+                }
+        }
+
+        // After "\u"; combines surrogate pairs.
+        std::uint32_t code_point() {
+                auto cp = hex4();
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                        if (in_.substr(pos_, 2) != "\\u")
+                                fail(pos_, "unpaired surrogate");
+                        pos_ += 2;
+                        const auto lo = hex4();
+                        if (lo < 0xDC00 || lo > 0xDFFF)
+                                fail(pos_ - 4, "unpaired surrogate");
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                        fail(pos_ - 4, "unpaired surrogate");
+                }
+                return cp;
+        }
+
+        std::uint32_t hex4() {
+                std::uint32_t ret = 0;
+                for (int i = 0; i != 4; ++i, ++pos_) {
+                        if (pos_ == in_.size() || !is_in(in_[pos_], cc_hexdig))
+                                fail(pos_, "invalid \\u escape");
+                        const auto c = in_[pos_];
+                        ret = ret * 16 + (c <= '9' ? c - '0'
+                                                   : (c | 0x20) - 'a' + 10);
+                }
+                return ret;
+        }
+
+        void append_utf8(std::uint32_t cp) {
+                if (cp < 0x80) {
+                        buffer_ += char(cp);
+                } else if (cp < 0x800) {
+                        buffer_ += char(0xC0 | (cp >> 6));
+                        buffer_ += char(0x80 | (cp & 0x3F));
+                } else if (cp < 0x10000) {
+                        buffer_ += char(0xE0 | (cp >> 12));
+                        buffer_ += char(0x80 | ((cp >> 6) & 0x3F));
+                        buffer_ += char(0x80 | (cp & 0x3F));
+                } else {
+                        buffer_ += char(0xF0 | (cp >> 18));
+                        buffer_ += char(0x80 | ((cp >> 12) & 0x3F));
+                        buffer_ += char(0x80 | ((cp >> 6) & 0x3F));
+                        buffer_ += char(0x80 | (cp & 0x3F));
+                }
+        }
+
+        std::string_view in_;
+        std::size_t pos_ = 0;
+        Token token_;
+        bool peeked_ = false;
+        string buffer_;
+};
+
+// -- JcalReader. --------------------------------------------------------------
+// One property as it is in the JSON, before it becomes an AST node.
+struct JParam {
+        string name;            // lower case
+        vector<string> values;
+};
+struct JProp {
+        string name;            // lower case
+        vector<JParam> params;
+        string type;
+        vector<string> values; // structured values are flattened; a recur
+                                // value is one string in RFC 5545 syntax
+        std::size_t offset = 0;
+};
+
+string upper(std::string_view v) {
+        string ret(v);
+        for (auto &c : ret)
+                if (c >= 'a' && c <= 'z')
+                        c = char(c - 'a' + 'A');
+        return ret;
+}
+
+// "2019-03-15T01:00:00Z" to "20190315T010000Z", "+02:00" to "+0200".
+string without(std::string_view v, char const *chars) {
+        string ret;
+        ret.reserve(v.size());
+        for (auto c : v)
+                if (!std::strchr(chars, c))
+                        ret += c;
+        return ret;
+}
+
+class JcalReader {
+public:
+        JcalReader(std::string_view json, ParserOptions const &options) :
+                json_(json),
+                lex_(json),
+                options_(options),
+                strings_(options.strings ? *options.strings
+                                         : StringPool::global())
+        {}
+
+        result<Calendar> calendar() {
+                if (lex_.peek().kind != JsonLexer::BeginArray)
+                        return no_match;
+                lex_.next();
+                const auto name = lex_.peek();
+                if (name.kind != JsonLexer::String ||
+                    !equal_ignore_case(name.text, "vcalendar"))
+                        return no_match;
+                lex_.next();
+
+                Calendar ret;
+                expect(JsonLexer::Comma, "','");
+                array([&] {
+                        property(prop_);
+                        calprop(ret.properties, prop_);
+                });
+                expect(JsonLexer::Comma, "','");
+                array([&] {
+                        if (auto c = component())
+                                ret.components.push_back(std::move(*c));
+                });
+                expect(JsonLexer::EndArray, "']'");
+                expect(JsonLexer::End, "end of input");
+                return ret;
+        }
+
+private:
+        // -- Structure. -------------------------------------------------------
+        [[noreturn]] void fail(std::size_t offset, string const &msg) const {
+                throw syntax_error(std::streampos(offset), msg);
+        }
+
+        JsonLexer::Token expect(JsonLexer::Kind kind, char const *what) {
+                const auto t = lex_.next();
+                if (t.kind != kind)
+                        fail(t.offset, string("expected ") + what);
+                return t;
+        }
+
+        std::string_view string_value() {
+                return expect(JsonLexer::String, "a string").text;
+        }
+
+        // Calls `element` for each element of an array.
+        template <typename Fun>
+        void array(Fun const &element) {
+                expect(JsonLexer::BeginArray, "'['");
+                if (lex_.peek().kind == JsonLexer::EndArray) {
+                        lex_.next();
+                        return;
+                }
+                while (true) {
+                        element();
+                        const auto t = lex_.next();
+                        if (t.kind == JsonLexer::EndArray)
+                                return;
+                        if (t.kind != JsonLexer::Comma)
+                                fail(t.offset, "expected ',' or ']'");
+                }
+        }
+
+        // Calls `member` with each key of an object, before its value.
+        template <typename Fun>
+        void object(Fun const &member) {
+                expect(JsonLexer::BeginObject, "'{'");
+                if (lex_.peek().kind == JsonLexer::EndObject) {
+                        lex_.next();
+                        return;
+                }
+                while (true) {
+                        const auto key = lower_case(string_value());
+                        expect(JsonLexer::Colon, "':'");
+                        member(key);
+                        const auto t = lex_.next();
+                        if (t.kind == JsonLexer::EndObject)
+                                return;
+                        if (t.kind != JsonLexer::Comma)
+                                fail(t.offset, "expected ',' or '}'");
+                }
+        }
+
+        void skip_value() {
+                switch (lex_.peek().kind) {
+                case JsonLexer::BeginArray:
+                        array([this] { skip_value(); });
+                        return;
+                case JsonLexer::BeginObject:
+                        object([this](string const &) { skip_value(); });
+                        return;
+                case JsonLexer::String:
+                case JsonLexer::Number:
+                case JsonLexer::Literal:
+                        lex_.next();
+                        return;
+                default:
+                        fail(lex_.peek().offset, "expected a value");
+                }
+        }
+
+        // A string, number or literal, as text.
+        void scalar(vector<string> &out) {
+                const auto t = lex_.next();
+                if (t.kind != JsonLexer::String &&
+                    t.kind != JsonLexer::Number &&
+                    t.kind != JsonLexer::Literal)
+                        fail(t.offset, "expected a value");
+                out.emplace_back(t.text);
+        }
+
+        // -- Properties. ------------------------------------------------------
+        // ["name", {params}, "type", value...]
+        void property(JProp &p) {
+                p.offset = lex_.offset();
+                expect(JsonLexer::BeginArray, "'['");
+                p.name = lower_case(string_value());
+                expect(JsonLexer::Comma, "','");
+                p.params.clear();
+                object([&](string const &key) {
+                        p.params.push_back({key, {}});
+                        auto &values = p.params.back().values;
+                        if (lex_.peek().kind == JsonLexer::BeginArray)
+                                array([&] { scalar(values); });
+                        else
+                                scalar(values);
+                });
+                expect(JsonLexer::Comma, "','");
+                p.type = lower_case(string_value());
+                p.values.clear();
+                while (lex_.peek().kind == JsonLexer::Comma) {
+                        lex_.next();
+                        value(p);
+                }
+                expect(JsonLexer::EndArray, "']'");
+        }
+
+        void value(JProp &p) {
+                switch (lex_.peek().kind) {
+                case JsonLexer::BeginArray:
+                        array([&] { scalar(p.values); });
+                        return;
+                case JsonLexer::BeginObject:
+                        p.values.push_back(recur_text());
+                        return;
+                default:
+                        scalar(p.values);
+                }
+        }
+
+        // {"freq": "YEARLY", "bymonth": [1, 2]} to "FREQ=YEARLY;BYMONTH=1,2".
+        string recur_text() {
+                string ret;
+                vector<string> values;
+                object([&](string const &key) {
+                        values.clear();
+                        if (lex_.peek().kind == JsonLexer::BeginArray)
+                                array([&] { scalar(values); });
+                        else
+                                scalar(values);
+                        if (!ret.empty())
+                                ret += ';';
+                        ret += upper(key);
+                        ret += '=';
+                        for (std::size_t i = 0; i != values.size(); ++i) {
+                                if (i)
+                                        ret += ',';
+                                ret += key == "until"
+                                       ? without(values[i], "-:")
+                                       : values[i];
+                        }
+                });
+                return ret;
+        }
+
+        JParam const* find_param(JProp const &p, char const *name) const {
+                for (auto const &x : p.params)
+                        if (x.name == name)
+                                return &x;
+                return nullptr;
+        }
+
+        OtherParam other_param(JParam const &v) {
+                if (v.name.compare(0, 2, "x-") == 0) {
+                        XParam ret;
+                        ret.name = strings_.intern(upper(v.name));
+                        ret.values = v.values;
+                        return OtherParam(std::move(ret));
+                }
+                IanaParam ret;
+                ret.token = upper(v.name);
+                ret.values = v.values;
+                return OtherParam(std::move(ret));
+        }
+
+        // The parameters other than `known`.
+        vector<OtherParam> other_params(
+                JProp const &p,
+                std::initializer_list<char const *> known = {}
+        ) {
+                vector<OtherParam> ret;
+                for (auto const &x : p.params) {
+                        bool skip = false;
+                        for (auto k : known)
+                                skip = skip || x.name == k;
+                        if (!skip)
+                                ret.push_back(other_param(x));
+                }
+                return ret;
+        }
+
+        template <typename T>
+        optional<T> optional_param(JProp const &p, char const *name) {
+                optional<T> ret;
+                if (auto x = find_param(p, name); x && !x->values.empty()) {
+                        ret.emplace();
+                        ret->value = x->values.front();
+                }
+                return ret;
+        }
+
+        string const& single(JProp const &p) {
+                if (p.values.empty())
+                        fail(p.offset, p.name + ": value missing");
+                return p.values.front();
+        }
+
+        // The typed values are read by the rules of IcalParser, from their
+        // RFC 5545 form.
+        template <typename T>
+        T typed(JProp const &p, string const &text,
+                result<T> (IcalParser::*rule)()) {
+                imemstream is(text.data(), text.size());
+                IcalParser parser(is, options_);
+                result<T> v;
+                try {
+                        v = (parser.*rule)();
+                } catch (std::runtime_error &) {
+                        v = no_match;
+                }
+                is.clear();
+                if (!is_match(v) || is.tellg() != std::streampos(text.size()))
+                        fail(p.offset, p.name + ": invalid " + p.type +
+                                       " value \"" + text + "\"");
+                return get<T>(v);
+        }
+
+        DateTime date_time(JProp const &p) {
+                return typed(p, without(single(p), "-:"),
+                             &IcalParser::date_time);
+        }
+        Date date(JProp const &p) {
+                return typed(p, without(single(p), "-"), &IcalParser::date);
+        }
+        UtcOffset utc_offset(JProp const &p) {
+                return typed(p, without(single(p), ":"),
+                             &IcalParser::utc_offset);
+        }
+        DurValue duration(JProp const &p) {
+                return typed(p, single(p), &IcalParser::dur_value);
+        }
+        Recur recur(JProp const &p) {
+                return typed(p, single(p), &IcalParser::recur);
+        }
+        Uri uri(JProp const &p) {
+                return typed(p, single(p), &IcalParser::uri);
+        }
+        int integer(JProp const &p) {
+                auto const &v = single(p);
+                char *end = nullptr;
+                const auto ret = std::strtol(v.c_str(), &end, 10);
+                if (v.empty() || *end != '\0')
+                        fail(p.offset, p.name + ": invalid integer");
+                return static_cast<int>(ret);
+        }
+        // TEXT is kept escaped in the AST, see Text.
+        string text(JProp const &p) {
+                return escape_text(single(p));
+        }
+
+        template <typename DtProp>
+        DtProp dt_prop(JProp const &p) {
+                DtProp ret;
+                if (auto tz = find_param(p, "tzid");
+                    tz && !tz->values.empty()) {
+                        std::string_view v = tz->values.front();
+                        if (!v.empty() && v[0] == '/') {
+                                ret.params.tz_id.prefix = TzIdPrefix{{"/"}};
+                                v.remove_prefix(1);
+                        }
+                        ret.params.tz_id.paramtext = strings_.intern(v);
+                }
+                ret.params.params = other_params(p, {"tzid"});
+                if (p.type == "date") {
+                        ret.params.value = "DATE";
+                        ret.value = date(p);
+                } else {
+                        ret.value = date_time(p);
+                }
+                return ret;
+        }
+
+        template <typename TextProp>
+        TextProp text_prop(JProp const &p) {
+                TextProp ret;
+                ret.params.alt_rep = optional_param<AltRepParam>(p, "altrep");
+                ret.params.language =
+                        optional_param<LanguageParam>(p, "language");
+                ret.params.params = other_params(p, {"altrep", "language"});
+                ret.value = text(p);
+                return ret;
+        }
+
+        // X- and IANA properties keep a VALUE parameter for their type.
+        vector<ICalParameter> any_params(JProp const &p) {
+                vector<ICalParameter> ret;
+                for (auto const &x : p.params)
+                        ret.emplace_back(other_param(x));
+                if (p.type != "unknown")
+                        ret.emplace_back(ValueTypeParam{{{upper(p.type)}}});
+                return ret;
+        }
+        string any_value(JProp const &p) {
+                string ret;
+                for (std::size_t i = 0; i != p.values.size(); ++i) {
+                        if (i)
+                                ret += ',';
+                        ret += p.type == "text" ? escape_text(p.values[i])
+                                                : p.values[i];
+                }
+                return ret;
+        }
+        XProp x_prop(JProp const &p) {
+                XProp ret;
+                ret.name = strings_.intern(upper(p.name));
+                ret.params = any_params(p);
+                ret.value = any_value(p);
+                return ret;
+        }
+        IanaProp iana_prop(JProp const &p) {
+                IanaProp ret;
+                ret.ianaToken = upper(p.name);
+                ret.params = any_params(p);
+                ret.value = any_value(p);
+                return ret;
+        }
+        bool is_x_name(string const &name) const {
+                return name.compare(0, 2, "x-") == 0;
+        }
+
+        void calprop(CalProps &ret, JProp const &p) {
+                if (p.name == "prodid") {
+                        ret.prodId.params = other_params(p);
+                        ret.prodId.value = text(p);
+                } else if (p.name == "version") {
+                        ret.version.params = other_params(p);
+                        ret.version.value = text(p);
+                } else if (p.name == "calscale") {
+                        ret.calScale.emplace();
+                        ret.calScale->params = other_params(p);
+                        ret.calScale->value = text(p);
+                } else if (p.name == "method") {
+                        ret.method.emplace();
+                        ret.method->params = other_params(p);
+                        ret.method->value = text(p);
+                }
+                // CalProps does not keep X- and IANA properties.
+        }
+
+        EventProp event_prop(JProp const &p) {
+                const auto &n = p.name;
+                if (is_x_name(n))
+                        return EventProp(x_prop(p));
+                // Such as an RRULE which IcalParser kept as an IanaProp.
+                if (p.type == "unknown")
+                        return EventProp(iana_prop(p));
+                if (n == "dtstamp") {
+                        DtStamp ret;
+                        ret.params.params = other_params(p);
+                        ret.date_time = date_time(p);
+                        return EventProp(std::move(ret));
+                }
+                if (n == "uid") {
+                        Uid ret;
+                        ret.params = other_params(p);
+                        ret.value = text(p);
+                        return EventProp(std::move(ret));
+                }
+                if (n == "dtstart")
+                        return EventProp(dt_prop<DtStart>(p));
+                if (n == "dtend")
+                        return EventProp(dt_prop<DtEnd>(p));
+                if (n == "class") {
+                        Class ret;
+                        ret.params.params = other_params(p);
+                        ret.value = single(p);
+                        return EventProp(std::move(ret));
+                }
+                if (n == "created") {
+                        Created ret;
+                        ret.params.params = other_params(p);
+                        ret.dateTime = date_time(p);
+                        return EventProp(std::move(ret));
+                }
+                if (n == "description")
+                        return EventProp(text_prop<Description>(p));
+                if (n == "summary")
+                        return EventProp(text_prop<Summary>(p));
+                if (n == "geo") {
+                        if (p.values.size() != 2)
+                                fail(p.offset, "geo: expected two floats");
+                        Geo ret;
+                        ret.params.params = other_params(p);
+                        ret.value.latitude = p.values[0];
+                        ret.value.longitude = p.values[1];
+                        return EventProp(std::move(ret));
+                }
+                if (n == "last-modified") {
+                        LastMod ret;
+                        ret.params.params = other_params(p);
+                        ret.dateTime = date_time(p);
+                        return EventProp(std::move(ret));
+                }
+                if (n == "location") {
+                        Location ret;
+                        ret.params.alt_rep =
+                                optional_param<AltRepParam>(p, "altrep");
+                        ret.params.language =
+                                optional_param<LanguageParam>(p, "language");
+                        ret.params.params =
+                                other_params(p, {"altrep", "language"});
+                        ret.value = strings_.intern(text(p));
+                        return EventProp(std::move(ret));
+                }
+                if (n == "organizer") {
+                        Organizer ret;
+                        ret.params.cn = optional_param<CnParam>(p, "cn");
+                        ret.params.dir = optional_param<DirParam>(p, "dir");
+                        ret.params.sentBy =
+                                optional_param<SentByParam>(p, "sent-by");
+                        ret.params.language =
+                                optional_param<LanguageParam>(p, "language");
+                        ret.params.params = other_params(
+                                p, {"cn", "dir", "sent-by", "language"});
+                        ret.address = uri(p);
+                        return EventProp(std::move(ret));
+                }
+                if (n == "sequence") {
+                        Seq ret;
+                        ret.params.params = other_params(p);
+                        ret.value = integer(p);
+                        return EventProp(std::move(ret));
+                }
+                if (n == "status") {
+                        Status ret;
+                        ret.params.params = other_params(p);
+                        ret.value = StatvalueEvent{{single(p)}};
+                        return EventProp(std::move(ret));
+                }
+                if (n == "transp") {
+                        Transp ret;
+                        ret.params.params = other_params(p);
+                        ret.value = single(p);
+                        return EventProp(std::move(ret));
+                }
+                if (n == "rrule") {
+                        RRule ret;
+                        ret.param.otherParams = other_params(p);
+                        ret.recur = recur(p);
+                        return EventProp(std::move(ret));
+                }
+                if (n == "categories") {
+                        Categories ret;
+                        ret.params.language =
+                                optional_param<LanguageParam>(p, "language");
+                        ret.params.params = other_params(p, {"language"});
+                        for (auto const &v : p.values)
+                                ret.values.push_back(
+                                        strings_.intern(escape_text(v)));
+                        return EventProp(std::move(ret));
+                }
+                // Including the ones the AST does not model yet, so that
+                // nothing is lost.
+                return EventProp(iana_prop(p));
+        }
+
+        // -- Components. ------------------------------------------------------
+        // ["name", [properties], [components]]
+        optional<Component> component() {
+                const auto begin = lex_.offset();
+                expect(JsonLexer::BeginArray, "'['");
+                const auto name = lower_case(string_value());
+                expect(JsonLexer::Comma, "','");
+                optional<Component> ret;
+                if (name == "vevent") {
+                        ret = event();
+                } else if (name == "vtimezone") {
+                        ret = timezone();
+                } else {
+                        skip_value();
+                        expect(JsonLexer::Comma, "','");
+                        skip_value();
+                        if (name == "vtodo") ret = TodoComp{};
+                        else if (name == "vjournal") ret = JournalComp{};
+                        else if (name == "vfreebusy") ret = FreeBusyComp{};
+                        else if (is_x_name(name)) ret = XComp{};
+                        else ret = IanaComp{};
+                }
+                expect(JsonLexer::EndArray, "']'");
+                // Over the JSON text, so it differs from that of the same
+                // component in iCalendar.
+                const auto hash = hash128(
+                        json_.substr(begin, lex_.offset() - begin));
+                visit([&](having_content_hash &c) { c.contentHash = hash; },
+                      *ret);
+                return ret;
+        }
+
+        EventComp event() {
+                EventComp ret;
+                array([&] {
+                        property(prop_);
+                        ret.properties.push_back(event_prop(prop_));
+                });
+                expect(JsonLexer::Comma, "','");
+                array([&] {
+                        subcomponent([&](string const &name,
+                                         vector<JProp> const &props) {
+                                if (name == "valarm")
+                                        ret.alarms.push_back(alarm(props));
+                        });
+                });
+                return ret;
+        }
+
+        // A component within a component, with its properties collected.
+        template <typename Fun>
+        void subcomponent(Fun const &fun) {
+                expect(JsonLexer::BeginArray, "'['");
+                const auto name = lower_case(string_value());
+                expect(JsonLexer::Comma, "','");
+                vector<JProp> props;
+                array([&] {
+                        props.emplace_back();
+                        property(props.back());
+                });
+                expect(JsonLexer::Comma, "','");
+                skip_value();
+                expect(JsonLexer::EndArray, "']'");
+                fun(name, props);
+        }
+
+        Alarm alarm(vector<JProp> const &props) {
+                JProp const *action = nullptr;
+                for (auto const &p : props)
+                        if (p.name == "action")
+                                action = &p;
+                if (!action)
+                        fail(lex_.offset(), "valarm: action missing");
+                const auto kind = upper(single(*action));
+                if (kind == "AUDIO")
+                        return Alarm(alarm_props<AudioProp>(props));
+                if (kind == "DISPLAY")
+                        return Alarm(alarm_props<DispProp>(props));
+                if (kind == "EMAIL")
+                        return Alarm(alarm_props<EmailProp>(props));
+                fail(action->offset, "valarm: unknown action " + kind);
+        }
+
+        template <typename T>
+        T alarm_props(vector<JProp> const &props) {
+                T ret;
+                for (auto const &p : props) {
+                        if (p.name == "action") {
+                                ret.action.params.params = other_params(p);
+                                ret.action.value = single(p);
+                        } else if (p.name == "trigger") {
+                                ret.trigger = trigger(p);
+                        } else if (p.name == "repeat") {
+                                ret.repeat.emplace();
+                                ret.repeat->params.params = other_params(p);
+                                ret.repeat->value = integer(p);
+                        } else if (is_x_name(p.name)) {
+                                ret.xProps.push_back(x_prop(p));
+                        } else if (!alarm_text(ret, p)) {
+                                ret.ianaProps.push_back(iana_prop(p));
+                        }
+                }
+                return ret;
+        }
+        bool alarm_text(AudioProp &, JProp const &) { return false; }
+        bool alarm_text(DispProp &ret, JProp const &p) {
+                if (p.name != "description")
+                        return false;
+                ret.description = text_prop<Description>(p);
+                return true;
+        }
+        bool alarm_text(EmailProp &ret, JProp const &p) {
+                if (p.name == "description")
+                        ret.description = text_prop<Description>(p);
+                else if (p.name == "summary")
+                        ret.summary = text_prop<Summary>(p);
+                else
+                        return false;
+                return true;
+        }
+
+        Trigger trigger(JProp const &p) {
+                if (p.type == "date-time") {
+                        TrigAbs ret;
+                        ret.params = other_params(p);
+                        ret.dateTime = date_time(p);
+                        return Trigger(std::move(ret));
+                }
+                TrigRel ret;
+                if (auto r = find_param(p, "related");
+                    r && !r->values.empty())
+                        ret.trigRelParam.value = r->values.front();
+                ret.params = other_params(p, {"related"});
+                ret.durValue = duration(p);
+                return Trigger(std::move(ret));
+        }
+
+        TimezoneComp timezone() {
+                TimezoneComp ret;
+                array([&] {
+                        property(prop_);
+                        const auto &p = prop_;
+                        if (p.name == "tzid") {
+                                ret.tzId.propParams.params = other_params(p);
+                                std::string_view v = single(p);
+                                if (!v.empty() && v[0] == '/') {
+                                        ret.tzId.prefix.value = "/";
+                                        v.remove_prefix(1);
+                                }
+                                ret.tzId.text = escape_text(v);
+                        } else if (p.name == "last-modified") {
+                                ret.lastMod.emplace();
+                                ret.lastMod->params.params = other_params(p);
+                                ret.lastMod->dateTime = date_time(p);
+                        } else if (p.name == "tzurl") {
+                                ret.tzUrl.emplace();
+                                ret.tzUrl->params.params = other_params(p);
+                                ret.tzUrl->uri = uri(p);
+                        } else if (is_x_name(p.name)) {
+                                ret.xProps.push_back(x_prop(p));
+                        } else {
+                                ret.ianaProps.push_back(iana_prop(p));
+                        }
+                });
+                expect(JsonLexer::Comma, "','");
+                // The AST holds one observance; later ones are dropped.
+                bool observance = false;
+                array([&] {
+                        subcomponent([&](string const &name,
+                                         vector<JProp> const &props) {
+                                if (observance)
+                                        return;
+                                if (name == "standard") {
+                                        ret.observance =
+                                                StandardC{tz_prop(props)};
+                                        observance = true;
+                                } else if (name == "daylight") {
+                                        ret.observance =
+                                                DaylightC{tz_prop(props)};
+                                        observance = true;
+                                }
+                        });
+                });
+                return ret;
+        }
+
+        TzProp tz_prop(vector<JProp> const &props) {
+                TzProp ret;
+                for (auto const &p : props) {
+                        if (p.name == "dtstart") {
+                                ret.dtStart = dt_prop<DtStart>(p);
+                        } else if (p.name == "tzoffsetto") {
+                                ret.offsetTo.param.otherParams =
+                                        other_params(p);
+                                ret.offsetTo.utcOffset = utc_offset(p);
+                        } else if (p.name == "tzoffsetfrom") {
+                                ret.offsetFrom.param.otherParams =
+                                        other_params(p);
+                                ret.offsetFrom.utcOffset = utc_offset(p);
+                        } else if (p.name == "rrule" && p.type == "recur") {
+                                ret.rRule.emplace();
+                                ret.rRule->param.otherParams = other_params(p);
+                                ret.rRule->recur = recur(p);
+                        } else if (p.name == "tzname") {
+                                TzName n;
+                                if (auto l = find_param(p, "language");
+                                    l && !l->values.empty())
+                                        n.param.languageParam.value =
+                                                l->values.front();
+                                n.param.otherParams =
+                                        other_params(p, {"language"});
+                                n.text = text(p);
+                                ret.tzNames.push_back(std::move(n));
+                        } else if (is_x_name(p.name)) {
+                                ret.xProps.push_back(x_prop(p));
+                        } else {
+                                ret.ianaProps.push_back(iana_prop(p));
+                        }
+                }
+                return ret;
+        }
+
+        std::string_view json_;
+        JsonLexer lex_;
+        ParserOptions options_;
+        StringPool &strings_;
+        JProp prop_;    // reused across properties
+};
+
+// Line and column (in bytes) of an offset.
+ParserPos json_pos(std::string_view json, std::size_t offset) {
+        ParserPos ret;
+        offset = std::min(offset, json.size());
+        ret.offset = static_cast<long long>(offset);
+        ret.line = 1;
+        std::size_t lineBegin = 0;
+        for (std::size_t i = 0; i != offset; ++i) {
+                if (json[i] == '\n') {
+                        ++ret.line;
+                        lineBegin = i + 1;
+                }
+        }
+        ret.col = static_cast<int>(offset - lineBegin) + 1;
+        return ret;
+}
+}
+
+result<Calendar> parse_jcal(std::string_view json,
+                            ParserOptions const &options) {
+        try {
+                return JcalReader(json, options).calendar();
+        } catch (syntax_error &e) {
+                return ParsingError{SourceCodePos{},
+                                    json_pos(json, std::streamoff(e.pos)),
+                                    e.what()};
+        }
+}
@@ -0,0 +1,84 @@
+#include "line_index.hh"
+#include <algorithm>
+#include <cstring>
+#include <istream>
+
+LineIndex::LineIndex(std::string_view text) {
+        scan(text.data(), text.size());
+        finish();
+}
+
+LineIndex::LineIndex(std::istream &is) {
+        auto *sb = is.rdbuf();
+        if (sb == nullptr)
+                return;
+        const auto pos = sb->pubseekoff(0, std::ios::cur, std::ios::in);
+        if (pos == std::streampos(-1) ||
+            sb->pubseekpos(0, std::ios::in) == std::streampos(-1))
+                return;
+
+        char buf[64 * 1024];
+        while (true) {
+                const auto n = sb->sgetn(buf, sizeof(buf));
+                if (n <= 0)
+                        break;
+                scan(buf, static_cast<std::size_t>(n));
+        }
+        finish();
+        sb->pubseekpos(pos, std::ios::in);
+}
+
+void LineIndex::scan(char const *data, std::size_t size) {
+        auto const *end = data + size;
+        auto const *p = data;
+        const auto offset = [&](char const *q) {
+                return scanned_ + (q - data);
+        };
+
+        if (pendingCR_ && p != end) {
+                pendingCR_ = false;
+                if (*p == '\n')
+                        ++p;
+                lineStarts_.push_back(offset(p));
+        }
+        while (p != end) {
+                // Find the next LF, then any CR before it.
+                auto const *lf = static_cast<char const *>(
+                        std::memchr(p, '\n', end - p));
+                auto const *stop = lf ? lf : end;
+                auto const *cr = static_cast<char const *>(
+                        std::memchr(p, '\r', stop - p));
+                if (cr != nullptr) {
+                        if (cr + 1 == end) {
+                                pendingCR_ = true;
+                                p = end;
+                                break;
+                        }
+                        p = cr + 1 + (cr[1] == '\n');
+                        lineStarts_.push_back(offset(p));
+                        continue;
+                }
+                if (lf == nullptr)
+                        break;
+                p = lf + 1;
+                lineStarts_.push_back(offset(p));
+        }
+        scanned_ += static_cast<std::streamoff>(size);
+}
+
+void LineIndex::finish() {
+        if (pendingCR_) {
+                pendingCR_ = false;
+                lineStarts_.push_back(scanned_);
+        }
+}
+
+LineIndex::Location LineIndex::locate(std::streamoff offset) const {
+        if (offset < 0)
+                return {};
+        const auto it = std::upper_bound(lineStarts_.begin(),
+                                         lineStarts_.end(), offset);
+        const auto line = it - lineStarts_.begin();
+        return {static_cast<int>(line),
+                static_cast<int>(offset - *(it - 1)) + 1};
+}
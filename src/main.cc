@@ -1,12 +1,34 @@
+// supercal [--jcal | --xcal] FILE
+// supercal --batch [--threads N] [--lenient] [--quiet] PATH...
+//
+// Prints the parsed calendar in FILE, or with --jcal or --xcal, writes it as
+// jCal or xCal.
+// A FILE ending in .json is read as jCal.
+// With --batch, parses every *.ics file below the PATHs on a thread pool,
+// prints one status line per file unless --quiet, and a summary with
+// files/s, MB/s and events/s. Exits with 1 if any file failed.
 
 #include "IcalParser.hh"
+#include "batch.hh"
+#include "jcal.hh"
 #include "parser_exceptions.hh"
+#include "xcal.hh"
 #include "icalstream.hh"
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 
-void read_file(std::string const &filename) {
+bool is_json(std::string const &filename) {
+        return filename.size() >= 5 &&
+               filename.compare(filename.size() - 5, 5, ".json") == 0;
+}
+
+enum class Output { Text, Jcal, Xcal };
+
+void read_file(std::string const &filename, Output output) {
         std::ifstream f(filename, std::ifstream::binary);
         if (!f.good()) {
                 std::cerr << "error opening \"" << filename << "\"\n";
@@ -14,10 +36,26 @@ void read_file(std::string const &filename) {
         }
         //std::stringstream ss; ss << f.rdbuf();
         try {
-                IcalParser parser(f);
-                auto ical = parser.icalobject();
-                if (is_match(ical))
+                auto ical = is_json(filename)
+                        ? parse_jcal(std::string(
+                                  std::istreambuf_iterator<char>(f), {}))
+                        : IcalParser(f).icalobject();
+                if (is_match(ical) && output == Output::Jcal) {
+                        OutputBuffer out(std::cout);
+                        write_jcal(out, get<Calendar>(ical));
+                        out.put('\n');
+                } else if (is_match(ical) && output == Output::Xcal) {
+                        OutputBuffer out(std::cout);
+                        write_xcal(out, get<Calendar>(ical));
+                } else if (is_match(ical)) {
                         std::cout << *ical << std::endl;
+                } else if (is_error(ical)) {
+                        auto const &e = get<ParsingError>(ical);
+                        std::cerr << "syntax-error:" << e.msg
+                                  << " (while parsing line "
+                                  << e.parserPos.line << ":"
+                                  << e.parserPos.col << ")\n";
+                }
         } catch (syntax_error &e) {
                 std::cerr << "syntax-error:" << e.what();
                 print_location(e.pos, f);
@@ -29,9 +67,71 @@ void read_file(std::string const &filename) {
         }
 }
 
-int main() {
-        //read_file("dev-assets/f1calendar.com/2019_full.ics");
-        read_file("C:/Users/machs/Desktop/mach.seb@gmail.com.ical/G/T/J_ Geburtstage_h3b3vuo67ftpsf541di68ghc6k@group.calendar.google.com.ics");
-        //read_file("dev-assets/mini1.ics");
+int read_batch(std::vector<std::string> const &roots,
+               BatchOptions const &options, bool quiet
+) {
+        const auto files = find_ics_files(roots);
+        const auto summary = parse_batch(files, options,
+                                         [&](FileResult const &r) {
+                if (r.ok && quiet)
+                        return;
+                if (r.ok) {
+                        std::printf("ok     %8zu events  %s\n",
+                                    r.events, r.path.c_str());
+                } else if (r.errorPos.line > 0) {
+                        std::printf("FAILED %s:%d:%d: %s\n", r.path.c_str(),
+                                    r.errorPos.line, r.errorPos.col,
+                                    r.error.c_str());
+                } else {
+                        std::printf("FAILED %s: %s\n", r.path.c_str(),
+                                    r.error.c_str());
+                }
+        });
+
+        const auto s = summary.seconds > 0 ? summary.seconds : 1e-9;
+        std::printf("%zu files, %zu failed, %.1f MB, %zu events in %.2f s: "
+                    "%.0f files/s, %.2f MB/s, %.0f events/s\n",
+                    summary.files, summary.failed, summary.bytes / 1e6,
+                    summary.events, summary.seconds,
+                    summary.files / s, summary.bytes / 1e6 / s,
+                    summary.events / s);
+        return summary.failed ? 1 : 0;
+}
+
+int main(int argc, char *argv[]) {
+        bool batch = false, quiet = false;
+        auto output = Output::Text;
+        BatchOptions options;
+        std::vector<std::string> paths;
+        for (int i = 1; i < argc; ++i) {
+                const std::string arg = argv[i];
+                if (arg == "--batch") {
+                        batch = true;
+                } else if (arg == "--threads" && i + 1 < argc) {
+                        options.threads = std::atoi(argv[++i]);
+                } else if (arg == "--lenient") {
+                        options.parser.lenient = true;
+                } else if (arg == "--quiet") {
+                        quiet = true;
+                } else if (arg == "--jcal") {
+                        output = Output::Jcal;
+                } else if (arg == "--xcal") {
+                        output = Output::Xcal;
+                } else if (arg.compare(0, 2, "--") == 0) {
+                        paths.clear();
+                        break;
+                } else {
+                        paths.push_back(arg);
+                }
+        }
+        if (paths.empty() || (!batch && paths.size() != 1)) {
+                std::cerr << "usage: " << argv[0] << " [--jcal | --xcal] FILE\n"
+                          << "       " << argv[0] << " --batch [--threads N]"
+                             " [--lenient] [--quiet] PATH...\n";
+                return 2;
+        }
+        if (batch)
+                return read_batch(paths, options, quiet);
+        read_file(paths.front(), output);
         return 0;
 }
@@ -0,0 +1,131 @@
+#include "mapped_file.hh"
+#include <utility>
+
+#ifdef _WIN32
+#  define WIN32_LEAN_AND_MEAN
+#  define NOMINMAX
+#  include <windows.h>
+#else
+#  include <cerrno>
+#  include <cstring>
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(std::string const &filename) {
+        const auto file = CreateFileA(filename.c_str(), GENERIC_READ,
+                                      FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                      FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+                throw mapping_error(filename, "CreateFile failed");
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) {
+                CloseHandle(file);
+                throw mapping_error(filename, "GetFileSizeEx failed");
+        }
+        file_ = file;
+        size_ = static_cast<std::size_t>(size.QuadPart);
+        if (size_ == 0)
+                return;
+
+        mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY,
+                                      0, 0, nullptr);
+        if (!mapping_) {
+                unmap();
+                throw mapping_error(filename, "CreateFileMapping failed");
+        }
+        data_ = static_cast<char const*>(
+                MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        if (!data_) {
+                unmap();
+                throw mapping_error(filename, "MapViewOfFile failed");
+        }
+}
+
+void MappedFile::unmap() {
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_) CloseHandle(file_);
+        data_ = nullptr;
+        mapping_ = nullptr;
+        file_ = nullptr;
+        size_ = 0;
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept :
+        data_(std::exchange(other.data_, nullptr)),
+        size_(std::exchange(other.size_, 0)),
+        file_(std::exchange(other.file_, nullptr)),
+        mapping_(std::exchange(other.mapping_, nullptr))
+{}
+
+MappedFile& MappedFile::operator= (MappedFile &&other) noexcept {
+        if (this != &other) {
+                unmap();
+                data_ = std::exchange(other.data_, nullptr);
+                size_ = std::exchange(other.size_, 0);
+                file_ = std::exchange(other.file_, nullptr);
+                mapping_ = std::exchange(other.mapping_, nullptr);
+        }
+        return *this;
+}
+
+#else
+
+MappedFile::MappedFile(std::string const &filename) {
+        const auto fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+                throw mapping_error(filename, std::strerror(errno));
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+                const auto err = errno;
+                ::close(fd);
+                throw mapping_error(filename, std::strerror(err));
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+        if (size_ == 0) {
+                ::close(fd);
+                return;
+        }
+
+        void *p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        const auto err = errno;
+        ::close(fd); // The mapping stays valid.
+        if (p == MAP_FAILED) {
+                size_ = 0;
+                throw mapping_error(filename, std::strerror(err));
+        }
+        data_ = static_cast<char const*>(p);
+}
+
+void MappedFile::unmap() {
+        if (data_)
+                ::munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept :
+        data_(std::exchange(other.data_, nullptr)),
+        size_(std::exchange(other.size_, 0))
+{}
+
+MappedFile& MappedFile::operator= (MappedFile &&other) noexcept {
+        if (this != &other) {
+                unmap();
+                data_ = std::exchange(other.data_, nullptr);
+                size_ = std::exchange(other.size_, 0);
+        }
+        return *this;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+        unmap();
+}
@@ -0,0 +1,21 @@
+#include "output_buffer.hh"
+#include <ostream>
+
+OutputBuffer::OutputBuffer(std::ostream &sink, std::size_t flushAt) :
+        sink_(&sink),
+        flushAt_(flushAt)
+{
+        buffer_.reserve(flushAt);
+}
+
+OutputBuffer::~OutputBuffer() {
+        flush();
+}
+
+void OutputBuffer::flush() {
+        if (!sink_ || buffer_.empty())
+                return;
+        sink_->write(buffer_.data(),
+                     static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+}
@@ -0,0 +1,80 @@
+#include "parse_cache.hh"
+#include "IcalParser.hh"
+
+result<std::shared_ptr<const Calendar>> ParseCache::parse(std::string_view text) {
+        const auto key = hash128(text);
+        {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (auto cal = find_locked(key)) {
+                        ++stats_.hits;
+                        return result<std::shared_ptr<const Calendar>>(cal);
+                }
+                ++stats_.misses;
+        }
+
+        imemstream is(text.data(), text.size());
+        IcalParser parser(is);
+        auto ical = parser.icalobject();
+        if (is_error(ical))
+                return get<ParsingError>(ical);
+        if (!is_match(ical))
+                return no_match;
+
+        auto cal = std::make_shared<const Calendar>(std::move(get<Calendar>(ical)));
+        std::lock_guard<std::mutex> lock(mutex_);
+        insert_locked(Entry{key, cal, text.size()});
+        return result<std::shared_ptr<const Calendar>>(cal);
+}
+
+std::shared_ptr<const Calendar> ParseCache::find(ContentHash const &key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return find_locked(key);
+}
+
+void ParseCache::clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        index_.clear();
+        lru_.clear();
+        stats_.entries = 0;
+        stats_.bytes = 0;
+}
+
+ParseCache::Stats ParseCache::stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+}
+
+std::shared_ptr<const Calendar> ParseCache::find_locked(ContentHash const &key) {
+        const auto it = index_.find(key);
+        if (it == index_.end())
+                return nullptr;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->calendar;
+}
+
+void ParseCache::insert_locked(Entry entry) {
+        // Someone else may have parsed the same text in the meantime.
+        if (const auto it = index_.find(entry.key); it != index_.end()) {
+                lru_.splice(lru_.begin(), lru_, it->second);
+                return;
+        }
+        // Documents that would not fit on their own are not cached at all.
+        if (entry.bytes > limits_.maxBytes || limits_.maxEntries == 0)
+                return;
+
+        while (!lru_.empty() &&
+               (lru_.size() + 1 > limits_.maxEntries ||
+                stats_.bytes + entry.bytes > limits_.maxBytes))
+        {
+                auto &victim = lru_.back();
+                stats_.bytes -= victim.bytes;
+                index_.erase(victim.key);
+                lru_.pop_back();
+                ++stats_.evictions;
+        }
+
+        stats_.bytes += entry.bytes;
+        lru_.push_front(std::move(entry));
+        index_.emplace(lru_.front().key, lru_.begin());
+        stats_.entries = lru_.size();
+}
@@ -1,5 +1,6 @@
 #include "parser_helpers.hh"
 #include "parser_exceptions.hh"
+#include "char_class.hh"
 
 inline namespace parser_helpers {
 
@@ -26,36 +27,45 @@ void dump_remainder_and_exit(std::istream &is) {
         exit(1);
 }
 
-CallStack callStack;
-
 void print_location(std::istream::pos_type pos, std::istream &is) {
-        const auto where = pos;
-        is.seekg(0);
-        int line = 1, col = 1;
-        while(is.tellg() != where) {
-                const auto i = is.get();
-                switch (i) {
-                case '\r':
-                        if (is.peek() == '\n')
-                                is.get();
-                case '\n':
-                        col = 1;
-                        ++line;
-                        break;
-                case EOF:
-                        std::cerr << "premature EOF while computing line/col\n";
-                        break;
-                default:
-                        ++col;
-                }
-        }
-        std::cerr << " (while parsing line " << line << ":" << col << ")\n";
+        print_location(pos, LineIndex(is));
+}
+
+void print_location(std::istream::pos_type pos, LineIndex const &index) {
+        const auto where = index.locate(pos);
+        std::cerr << " (while parsing line " << where.line << ":" << where.col
+                  << ")\n";
 }
 
 // -- Utils. -------------------------------------------------------------------
+std::streambuf::pos_type memory_streambuf::seekoff(
+        off_type off, std::ios::seekdir dir, std::ios::openmode which
+) {
+        if (which & std::ios::out)
+                return pos_type(off_type(-1));
+        off_type base = 0;
+        switch (dir) {
+        case std::ios::beg: base = 0; break;
+        case std::ios::cur: base = gptr() - eback(); break;
+        case std::ios::end: base = egptr() - eback(); break;
+        default: return pos_type(off_type(-1));
+        }
+        const auto pos = base + off;
+        if (pos < 0 || pos > egptr() - eback())
+                return pos_type(off_type(-1));
+        setg(eback(), eback() + pos, egptr());
+        return pos_type(pos);
+}
+
+std::streambuf::pos_type memory_streambuf::seekpos(
+        pos_type pos, std::ios::openmode which
+) {
+        return seekoff(off_type(pos), std::ios::beg, which);
+}
 
 
 // -- Parser Helpers. ----------------------------------------------------------
+// Case-insensitive, as quoted strings in ABNF.
 string expect_token(std::istream &is, string const &tok) {
         CALLSTACK;
         save_input_pos ptran(is);
@@ -64,7 +74,7 @@ string expect_token(std::istream &is, string const &tok) {
                 if(i == EOF) {
                         throw unexpected_token(is.tellg(), tok);
                 }
-                if(i != c) {
+                if(!equal_ignore_case(i, c)) {
                         throw syntax_error(is.tellg(), tok);
                 }
         }
@@ -0,0 +1,322 @@
+#include "push_parser.hh"
+#include "char_class.hh"
+#include "parser_exceptions.hh"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+constexpr auto npos = std::string::npos;
+
+struct Delimiter {
+        bool begin = false;     // else END
+        string name;            // upper-cased
+};
+
+// For "BEGIN:NAME" and "END:NAME" lines, unfolded and without their line
+// break.
+optional<Delimiter> delimiter(std::string_view line) {
+        if (line.empty() || !(equal_ignore_case(line[0], 'B') ||
+                              equal_ignore_case(line[0], 'E')))
+                return nullopt;
+        string unfolded;
+        if (line.find_first_of("\r\n") != npos) {
+                for (std::size_t i = 0; i != line.size(); ++i) {
+                        if (line[i] == '\r' || line[i] == '\n') {
+                                if (line[i] == '\r' && i + 1 != line.size() &&
+                                    line[i + 1] == '\n')
+                                        ++i;
+                                ++i;    // the SP or HTAB of the fold
+                                continue;
+                        }
+                        unfolded += line[i];
+                }
+                line = unfolded;
+        }
+
+        Delimiter ret;
+        std::size_t nameBegin;
+        if (line.size() > 6 && equal_ignore_case(line.substr(0, 6), "BEGIN:")) {
+                ret.begin = true;
+                nameBegin = 6;
+        } else if (line.size() > 4 &&
+                   equal_ignore_case(line.substr(0, 4), "END:")) {
+                nameBegin = 4;
+        } else {
+                return nullopt;
+        }
+        for (auto c : line.substr(nameBegin))
+                ret.name += c >= 'a' && c <= 'z' ? char(c - 'a' + 'A') : c;
+        return ret;
+}
+
+bool top_level(string const &name) {
+        return name == "VEVENT" || name == "VTODO" || name == "VJOURNAL" ||
+               name == "VFREEBUSY" || name == "VTIMEZONE";
+}
+
+// CRLF, lone CR and lone LF each count once, as in LineIndex.
+int count_line_breaks(std::string_view text) {
+        int ret = 0;
+        for (std::size_t i = 0; i != text.size(); ++i) {
+                if (text[i] == '\n') {
+                        ++ret;
+                } else if (text[i] == '\r') {
+                        ++ret;
+                        if (i + 1 != text.size() && text[i + 1] == '\n')
+                                ++i;
+                }
+        }
+        return ret;
+}
+}
+
+PushParser::PushParser(ComponentHandler onComponent,
+                       ParserOptions const &options) :
+        onComponent_(std::move(onComponent)),
+        options_(options)
+{
+}
+
+bool PushParser::feed(std::string_view chunk) {
+        if (state_ == State::Header || state_ == State::Body) {
+                buffer_.append(chunk.data(), chunk.size());
+                parse(false);
+        }
+        return state_ != State::NotCalendar && state_ != State::Failed;
+}
+
+result<CalProps> PushParser::finish() {
+        if (state_ == State::Header || state_ == State::Body)
+                parse(true);
+
+        switch (state_) {
+        case State::Done:
+                return properties_;
+        case State::NotCalendar:
+                return no_match;
+        case State::Failed:
+                return *error_;
+        case State::Header:
+                if (offset_ == 0 && buffer_.empty())
+                        return no_match;
+                break;
+        case State::Body:
+                break;
+        }
+        // END:VCALENDAR, or the END of a component, is missing.
+        fail(SYNTAX_ERROR(""));
+        return *error_;
+}
+
+// Walks the complete lines, and parses the header and each top-level
+// component as soon as its last line is there.
+void PushParser::parse(bool final) {
+        while (state_ == State::Header || state_ == State::Body) {
+                const auto end = line_end(final);
+                if (end == npos)
+                        return;
+                const auto d = delimiter(line(end));
+
+                if (state_ == State::Header) {
+                        if (offset_ == 0 && lineBegin_ == 0) {
+                                if (!d || !d->begin || d->name != "VCALENDAR") {
+                                        state_ = State::NotCalendar;
+                                        return;
+                                }
+                        } else if (d) {
+                                // The first component, or the end.
+                                if (!header(std::string_view(buffer_).substr(
+                                            0, lineBegin_)))
+                                        return;
+                                consume(lineBegin_);
+                                state_ = State::Body;
+                                continue;
+                        }
+                        lineBegin_ = end;
+                        continue;
+                }
+
+                if (depth_ == 0) {
+                        if (d && d->begin) {
+                                depth_ = 1;
+                        } else if (d && d->name == "VCALENDAR") {
+                                if (components_ == 0 && skipped_ == 0) {
+                                        fail(SYNTAX_ERROR(""));
+                                        return;
+                                }
+                                consume(end);
+                                state_ = State::Done;
+                                return;
+                        } else {
+                                fail(SYNTAX_ERROR(""));
+                                return;
+                        }
+                } else if (d && (d->begin ? top_level(d->name)
+                                          : d->name == "VCALENDAR")) {
+                        // The END line is missing. The component is cut
+                        // here, as IcalParser::skip_component() does.
+                        if (!component(std::string_view(buffer_)
+                                       .substr(0, lineBegin_)))
+                                return;
+                        consume(lineBegin_);
+                        depth_ = 0;
+                        continue;
+                } else if (d) {
+                        depth_ += d->begin ? 1 : -1;
+                        if (depth_ == 0) {
+                                if (!component(std::string_view(buffer_)
+                                               .substr(0, end)))
+                                        return;
+                                consume(end);
+                                continue;
+                        }
+                }
+                lineBegin_ = end;
+        }
+}
+
+// The end of the line starting at lineBegin_, past its line break and any
+// folds, or npos while that depends on input still to come.
+std::size_t PushParser::line_end(bool final) {
+        auto p = std::max(scanned_, lineBegin_);
+        while (true) {
+                const auto brk = buffer_.find_first_of("\r\n", p);
+                if (brk == npos) {
+                        scanned_ = buffer_.size();
+                        if (final && lineBegin_ != buffer_.size())
+                                return buffer_.size();
+                        return npos;
+                }
+                auto end = brk + 1;
+                if (buffer_[brk] == '\r' && end != buffer_.size() &&
+                    buffer_[end] == '\n')
+                        ++end;
+                if (end == buffer_.size()) {
+                        // A fold, or an LF after this CR, may follow.
+                        scanned_ = brk;
+                        return final ? end : npos;
+                }
+                if (buffer_[end] == ' ' || buffer_[end] == '\t') {
+                        p = end + 1;
+                        continue;
+                }
+                scanned_ = end;
+                return end;
+        }
+}
+
+// The line from lineBegin_ to `end`, without its line break.
+std::string_view PushParser::line(std::size_t end) const {
+        auto ret = std::string_view(buffer_).substr(lineBegin_,
+                                                     end - lineBegin_);
+        if (!ret.empty() && ret.back() == '\n')
+                ret.remove_suffix(1);
+        if (!ret.empty() && ret.back() == '\r')
+                ret.remove_suffix(1);
+        return ret;
+}
+
+// BEGIN:VCALENDAR and the calendar properties.
+bool PushParser::header(std::string_view text) {
+        imemstream is(text.data(), text.size());
+        IcalParser parser(is, options_);
+        try {
+                if (!is_match(parser.key_value_newline("BEGIN", "VCALENDAR"))) {
+                        state_ = State::NotCalendar;
+                        return false;
+                }
+                if (auto v = parser.calprops(); is_match(v))
+                        properties_ = *v;
+                is.clear();
+                if (is.tellg() != std::streampos(text.size())) {
+                        fail(ParsingError{SourceCodePos{},
+                                          global_pos(parser.parser_pos()), ""});
+                        return false;
+                }
+        } catch (syntax_error &e) {
+                fail(ParsingError{SourceCodePos{},
+                                  global_pos(parser.parser_pos(e.pos)),
+                                  e.what()});
+                return false;
+        } catch (not_implemented &e) {
+                fail(ParsingError{SourceCodePos{},
+                                  global_pos(parser.parser_pos(e.pos)),
+                                  e.what()});
+                return false;
+        }
+        return true;
+}
+
+// One top-level component, from its BEGIN to its END line.
+bool PushParser::component(std::string_view text) {
+        imemstream is(text.data(), text.size());
+        IcalParser parser(is, options_);
+        result<vector<Component>> v;
+        try {
+                v = parser.component();
+        } catch (syntax_error &e) {
+                v = ParsingError{SourceCodePos{},
+                                 parser.parser_pos(e.pos), e.what()};
+        } catch (not_implemented &e) {
+                v = ParsingError{SourceCodePos{},
+                                 parser.parser_pos(e.pos), e.what()};
+        }
+
+        skipped_ += parser.skipped_components();
+        for (auto d : parser.diagnostics()) {
+                d.componentPos = global_pos(d.componentPos);
+                d.error.parserPos = global_pos(d.error.parserPos);
+                if (diagnostics_.size() < options_.maxDiagnostics)
+                        diagnostics_.push_back(std::move(d));
+        }
+        if (is_error(v)) {
+                auto e = get<ParsingError>(v);
+                e.parserPos = global_pos(e.parserPos);
+                fail(std::move(e));
+                return false;
+        }
+        is.clear();
+        if (is.tellg() != std::streampos(text.size())) {
+                fail(ParsingError{SourceCodePos{},
+                                  global_pos(parser.parser_pos()), ""});
+                return false;
+        }
+        if (is_match(v)) {
+                for (auto &c : get<vector<Component>>(v)) {
+                        ++components_;
+                        onComponent_(std::move(c));
+                }
+        }
+        return true;
+}
+
+void PushParser::consume(std::size_t size) {
+        line_ += count_line_breaks(std::string_view(buffer_).substr(0, size));
+        offset_ += static_cast<long long>(size);
+        buffer_.erase(0, size);
+        lineBegin_ -= std::min(lineBegin_, size);
+        scanned_ -= std::min(scanned_, size);
+}
+
+// The start of the line being looked at.
+ParserPos PushParser::parser_pos() {
+        const auto before = std::string_view(buffer_).substr(0, lineBegin_);
+        return {line_ + count_line_breaks(before), 1,
+                offset_ + static_cast<long long>(lineBegin_)};
+}
+
+// From a position in the buffer to one in the whole input.
+ParserPos PushParser::global_pos(ParserPos pos) const {
+        if (pos.line > 0)
+                pos.line += line_ - 1;
+        if (pos.offset >= 0)
+                pos.offset += offset_;
+        return pos;
+}
+
+void PushParser::fail(ParsingError error) {
+        state_ = State::Failed;
+        error_ = std::move(error);
+        buffer_.clear();
+        buffer_.shrink_to_fit();
+}
@@ -1,7 +1,16 @@
 #include "rfc3629.hh"
 #include "parser_helpers.hh"
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#include <tmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
 // -- Support for RFC 3629: UTF-8, a transformation format of ISO 10646. -------
 
 inline namespace rfc3629 {
@@ -127,3 +136,211 @@ optional<string> read_utf8_4(std::istream &is) {
 }
 
 }
+
+// -- Bulk validation. ---------------------------------------------------------
+inline namespace rfc3629 {
+
+std::size_t valid_utf8_prefix(char const *data, std::size_t size) {
+        auto const *p = reinterpret_cast<unsigned char const *>(data);
+        std::size_t i = 0;
+        while (i != size) {
+                const unsigned a = p[i];
+                if (a < 0x80) {
+                        ++i;
+                        continue;
+                }
+                // Length and the range of the second byte, see the UTF8-2,
+                // UTF8-3 and UTF8-4 rules above.
+                std::size_t n;
+                unsigned lo = 0x80, hi = 0xBF;
+                if (a >= 0xC2 && a <= 0xDF) {
+                        n = 2;
+                } else if (a >= 0xE0 && a <= 0xEF) {
+                        n = 3;
+                        if (a == 0xE0) lo = 0xA0;
+                        if (a == 0xED) hi = 0x9F;
+                } else if (a >= 0xF0 && a <= 0xF4) {
+                        n = 4;
+                        if (a == 0xF0) lo = 0x90;
+                        if (a == 0xF4) hi = 0x8F;
+                } else {
+                        return i;
+                }
+                if (size - i < n || p[i+1] < lo || p[i+1] > hi)
+                        return i;
+                for (std::size_t k = 2; k != n; ++k)
+                        if (!is_utf8_tail(p[i+k]))
+                                return i;
+                i += n;
+        }
+        return i;
+}
+
+namespace {
+
+bool is_valid_utf8_scalar(char const *data, std::size_t size) {
+        return valid_utf8_prefix(data, size) == size;
+}
+
+// The lookup-table validator of Keiser and Lemire, "Validating UTF-8 In
+// Less Than One Instruction Per Byte" (2021). Every error shows up in a
+// pair of adjacent bytes; three 16-entry tables, indexed by the high and
+// low nibble of the first and the high nibble of the second byte, map a
+// pair to the set of errors it might be, and the AND of the three is the
+// set it is. Only the "2 or 3 continuations" rule needs bytes further back.
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define ICAL_UTF8_SSSE3 1
+#if defined(__GNUC__)
+#define ICAL_TARGET_SSSE3 __attribute__((target("ssse3")))
+#else
+#define ICAL_TARGET_SSSE3
+#endif
+
+constexpr std::uint8_t too_short  = 1 << 0; // 11______ 0_______
+                                           // 11______ 11______
+constexpr std::uint8_t too_long   = 1 << 1; // 0_______ 10______
+constexpr std::uint8_t overlong_3 = 1 << 2; // 11100000 100_____
+constexpr std::uint8_t too_large  = 1 << 3; // 11110100 1001____ and up
+constexpr std::uint8_t surrogate  = 1 << 4; // 11101101 101_____
+constexpr std::uint8_t overlong_2 = 1 << 5; // 1100000_ 10______
+constexpr std::uint8_t too_large_1000 = 1 << 6; // 11110101 1000____ and up
+constexpr std::uint8_t overlong_4 = 1 << 6; // 11110000 1000____
+constexpr std::uint8_t two_conts  = 1 << 7; // 10______ 10______
+constexpr std::uint8_t carry = too_short | too_long | two_conts;
+
+ICAL_TARGET_SSSE3
+inline __m128i table(std::uint8_t const (&t)[16]) {
+        return _mm_loadu_si128(reinterpret_cast<__m128i const *>(t));
+}
+
+const std::uint8_t byte_1_high[16] = {
+        // 0_______ ________ <ASCII in byte 1>
+        too_long, too_long, too_long, too_long,
+        too_long, too_long, too_long, too_long,
+        // 10______ ________ <continuation in byte 1>
+        two_conts, two_conts, two_conts, two_conts,
+        // 1100____ ________ <two byte lead in byte 1>
+        too_short | overlong_2,
+        // 1101____ ________ <two byte lead in byte 1>
+        too_short,
+        // 1110____ ________ <three byte lead in byte 1>
+        too_short | overlong_3 | surrogate,
+        // 1111____ ________ <four+ byte lead in byte 1>
+        too_short | too_large | too_large_1000 | overlong_4
+};
+const std::uint8_t byte_1_low[16] = {
+        // ____0000 ________
+        carry | overlong_3 | overlong_2 | overlong_4,
+        // ____0001 ________
+        carry | overlong_2,
+        // ____001_ ________
+        carry,
+        carry,
+        // ____0100 ________
+        carry | too_large,
+        // ____0101 ________
+        carry | too_large | too_large_1000,
+        // ____011_ ________
+        carry | too_large | too_large_1000,
+        carry | too_large | too_large_1000,
+        // ____1___ ________
+        carry | too_large | too_large_1000,
+        carry | too_large | too_large_1000,
+        carry | too_large | too_large_1000,
+        carry | too_large | too_large_1000,
+        carry | too_large | too_large_1000,
+        // ____1101 ________
+        carry | too_large | too_large_1000 | surrogate,
+        carry | too_large | too_large_1000,
+        carry | too_large | too_large_1000
+};
+const std::uint8_t byte_2_high[16] = {
+        // ________ 0_______ <ASCII in byte 2>
+        too_short, too_short, too_short, too_short,
+        too_short, too_short, too_short, too_short,
+        // ________ 1000____
+        too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 |
+        overlong_4,
+        // ________ 1001____
+        too_long | overlong_2 | two_conts | overlong_3 | too_large,
+        // ________ 101_____
+        too_long | overlong_2 | two_conts | surrogate | too_large,
+        too_long | overlong_2 | two_conts | surrogate | too_large,
+        // ________ 11______
+        too_short, too_short, too_short, too_short
+};
+
+// Errors in `in`, given the 16 bytes before it.
+ICAL_TARGET_SSSE3
+inline __m128i check_block(__m128i in, __m128i prev) {
+        const auto nibble = _mm_set1_epi8(0x0F);
+        const auto prev1 = _mm_alignr_epi8(in, prev, 15);
+        const auto prev2 = _mm_alignr_epi8(in, prev, 14);
+        const auto prev3 = _mm_alignr_epi8(in, prev, 13);
+
+        const auto b1h = _mm_shuffle_epi8(table(byte_1_high),
+                _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+        const auto b1l = _mm_shuffle_epi8(table(byte_1_low),
+                _mm_and_si128(prev1, nibble));
+        const auto b2h = _mm_shuffle_epi8(table(byte_2_high),
+                _mm_and_si128(_mm_srli_epi16(in, 4), nibble));
+        const auto special = _mm_and_si128(_mm_and_si128(b1h, b1l), b2h);
+
+        // Third or fourth byte of a sequence: only 111_____ two bytes back
+        // or 1111____ three bytes back stay >= 0x80.
+        const auto third = _mm_subs_epu8(prev2, _mm_set1_epi8(char(0xE0 - 0x80)));
+        const auto fourth = _mm_subs_epu8(prev3, _mm_set1_epi8(char(0xF0 - 0x80)));
+        const auto must23 = _mm_and_si128(_mm_or_si128(third, fourth),
+                                          _mm_set1_epi8(char(0x80)));
+        return _mm_xor_si128(must23, special);
+}
+
+ICAL_TARGET_SSSE3
+bool is_valid_utf8_ssse3(char const *data, std::size_t size) {
+        auto prev = _mm_setzero_si128();
+        auto error = _mm_setzero_si128();
+        std::size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+                const auto in = _mm_loadu_si128(
+                        reinterpret_cast<__m128i const *>(data + i));
+                error = _mm_or_si128(error, check_block(in, prev));
+                prev = in;
+        }
+        if (i != size) {
+                char tail[16] = {};
+                std::memcpy(tail, data + i, size - i);
+                const auto in = _mm_loadu_si128(
+                        reinterpret_cast<__m128i const *>(tail));
+                error = _mm_or_si128(error, check_block(in, prev));
+                prev = in;
+        }
+        // A sequence cut short by the end is followed by NULs here, which
+        // makes it too_short.
+        error = _mm_or_si128(error, check_block(_mm_setzero_si128(), prev));
+        return _mm_movemask_epi8(
+                _mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+}
+
+bool has_ssse3() {
+#if defined(__GNUC__)
+        return __builtin_cpu_supports("ssse3");
+#else
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 9)) != 0;
+#endif
+}
+#endif
+
+}
+
+bool is_valid_utf8(char const *data, std::size_t size) {
+#ifdef ICAL_UTF8_SSSE3
+        static const bool simd = has_ssse3();
+        if (simd)
+                return is_valid_utf8_ssse3(data, size);
+#endif
+        return is_valid_utf8_scalar(data, size);
+}
+
+}
@@ -1,5 +1,6 @@
 #include "rfc3986.hh"
 #include "parser_helpers.hh"
+#include <array>
 #include <istream>
 
 // -- URI (RFC 3986) Parser Helpers. ------------------------------------
@@ -701,6 +702,403 @@ optional<string> read_relative_ref(std::istream &is) {
 }
 
 
+// -- Span recognizer. ---------------------------------------------------
+namespace {
+// Character classes, as far as the URI grammar tells them apart.
+enum UriClass : unsigned char {
+        uc_other,
+        uc_alpha,
+        uc_digit,
+        uc_scheme_punct,        // "+" / "-" / "."
+        uc_unreserved,          // "_" / "~"
+        uc_sub_delim,           // sub-delims but "+"
+        uc_colon,
+        uc_at,
+        uc_slash,
+        uc_question,
+        uc_hash,
+        uc_percent,
+        uc_bracket,             // "[" / "]"
+        uc_count
+};
+
+constexpr UriClass classify_uri_char(int c) {
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+                return uc_alpha;
+        if (c >= '0' && c <= '9')
+                return uc_digit;
+        switch (c) {
+        case '+': case '-': case '.':
+                return uc_scheme_punct;
+        case '_': case '~':
+                return uc_unreserved;
+        case '!': case '$': case '&': case '\'': case '(': case ')':
+        case '*': case ',': case ';': case '=':
+                return uc_sub_delim;
+        case ':': return uc_colon;
+        case '@': return uc_at;
+        case '/': return uc_slash;
+        case '?': return uc_question;
+        case '#': return uc_hash;
+        case '%': return uc_percent;
+        case '[': case ']':
+                return uc_bracket;
+        }
+        return uc_other;
+}
+
+constexpr std::array<unsigned char, 256> make_uri_classes() {
+        std::array<unsigned char, 256> ret{};
+        for (int c = 0; c != 256; ++c)
+                ret[c] = classify_uri_char(c);
+        return ret;
+}
+
+constexpr auto uriClasses = make_uri_classes();
+
+UriClass uri_class(char c) {
+        return UriClass(uriClasses[static_cast<unsigned char>(c)]);
+}
+
+// States of the recognizer. Every state from us_colon on accepts;
+// us_authority hands over to scan_authority().
+enum UriState : unsigned char {
+        us_start,
+        us_scheme,
+        us_colon,               // after "scheme:"
+        us_slash,               // after "scheme:/"
+        us_path,
+        us_query,
+        us_fragment,
+        us_authority,
+        us_stop,
+        us_state_count
+};
+
+constexpr bool is_pchar_class(int cls) {
+        switch (cls) {
+        case uc_alpha: case uc_digit: case uc_scheme_punct:
+        case uc_unreserved: case uc_sub_delim: case uc_colon: case uc_at:
+        case uc_percent:
+                return true;
+        }
+        return false;
+}
+
+// For uc_percent, the state to enter if two HEXDIG follow.
+constexpr UriState transition(int state, int cls) {
+        switch (state) {
+        case us_start:
+                return cls == uc_alpha ? us_scheme : us_stop;
+        case us_scheme:
+                switch (cls) {
+                case uc_alpha: case uc_digit: case uc_scheme_punct:
+                        return us_scheme;
+                case uc_colon:
+                        return us_colon;
+                }
+                return us_stop;
+        case us_colon:
+        case us_slash:
+        case us_path:
+                if (is_pchar_class(cls))
+                        return us_path;
+                switch (cls) {
+                case uc_slash:
+                        return state == us_colon ? us_slash :
+                               state == us_slash ? us_authority : us_path;
+                case uc_question: return us_query;
+                case uc_hash:     return us_fragment;
+                }
+                return us_stop;
+        case us_query:
+        case us_fragment:
+                if (is_pchar_class(cls) || cls == uc_slash ||
+                    cls == uc_question)
+                        return UriState(state);
+                if (cls == uc_hash && state == us_query)
+                        return us_fragment;
+                return us_stop;
+        }
+        return us_stop;
+}
+
+constexpr std::array<std::array<unsigned char, uc_count>, us_state_count>
+make_uri_transitions() {
+        std::array<std::array<unsigned char, uc_count>, us_state_count> ret{};
+        for (int s = 0; s != us_state_count; ++s)
+                for (int c = 0; c != uc_count; ++c)
+                        ret[s][c] = transition(s, c);
+        return ret;
+}
+
+constexpr auto uriTransitions = make_uri_transitions();
+
+bool is_hexdig(char c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') ||
+               (c >= 'A' && c <= 'F');
+}
+
+// pct-encoded = "%" HEXDIG HEXDIG, with text[pos] == '%'.
+bool is_pct_encoded(std::string_view text, std::size_t pos) {
+        return pos + 2 < text.size() &&
+               is_hexdig(text[pos + 1]) && is_hexdig(text[pos + 2]);
+}
+
+//      dec-octet     = DIGIT / %x31-39 DIGIT / "1" 2DIGIT
+//                    / "2" %x30-34 DIGIT / "25" %x30-35
+//      IPv4address   = dec-octet "." dec-octet "." dec-octet "." dec-octet
+bool is_IPv4address(std::string_view s) {
+        std::size_t i = 0;
+        for (int octet = 0; octet != 4; ++octet) {
+                if (octet != 0) {
+                        if (i == s.size() || s[i] != '.')
+                                return false;
+                        ++i;
+                }
+                const auto start = i;
+                int value = 0;
+                while (i != s.size() && i - start < 3 &&
+                       s[i] >= '0' && s[i] <= '9')
+                        value = value * 10 + (s[i++] - '0');
+                const auto digits = i - start;
+                if (digits == 0 || value > 255 ||
+                    (digits > 1 && s[start] == '0'))
+                        return false;
+        }
+        return i == s.size();
+}
+
+//      IPv6address   =                            6( h16 ":" ) ls32
+//                    /                       "::" 5( h16 ":" ) ls32
+//                    / ...
+//                    / [ *6( h16 ":" ) h16 ] "::"
+//      h16           = 1*4HEXDIG
+//      ls32          = ( h16 ":" h16 ) / IPv4address
+bool is_IPv6address(std::string_view s) {
+        int groups = 0;
+        bool elided = false;
+        std::size_t i = 0;
+        if (s.substr(0, 2) == "::") {
+                elided = true;
+                i = 2;
+                if (i == s.size())
+                        return true;
+        }
+        while (true) {
+                auto j = i;
+                while (j != s.size() && is_hexdig(s[j]))
+                        ++j;
+                if (j != s.size() && s[j] == '.') {
+                        if (!is_IPv4address(s.substr(i)))
+                                return false;
+                        groups += 2;
+                        break;
+                }
+                if (j == i || j - i > 4)
+                        return false;
+                ++groups;
+                i = j;
+                if (i == s.size())
+                        break;
+                if (s[i] != ':')
+                        return false;
+                ++i;
+                if (i != s.size() && s[i] == ':') {
+                        if (elided)
+                                return false;
+                        elided = true;
+                        ++i;
+                        if (i == s.size())
+                                break;
+                } else if (i == s.size()) {
+                        return false;
+                }
+        }
+        return elided ? groups <= 7 : groups == 8;
+}
+
+//      IPvFuture     = "v" 1*HEXDIG "." 1*( unreserved / sub-delims / ":" )
+bool is_IPvFuture(std::string_view s) {
+        if (s.empty() || (s[0] != 'v' && s[0] != 'V'))
+                return false;
+        std::size_t i = 1;
+        while (i != s.size() && is_hexdig(s[i]))
+                ++i;
+        if (i == 1 || i == s.size() || s[i] != '.' || i + 1 == s.size())
+                return false;
+        for (++i; i != s.size(); ++i) {
+                switch (uri_class(s[i])) {
+                case uc_alpha: case uc_digit: case uc_scheme_punct:
+                case uc_unreserved: case uc_sub_delim: case uc_colon:
+                        break;
+                default:
+                        return false;
+                }
+        }
+        return true;
+}
+
+// Whether text[begin, end) consists of unreserved, pct-encoded and
+// sub-delims, plus ":" if `colon`.
+bool is_reg_chars(std::string_view text, std::size_t begin, std::size_t end,
+                  bool colon
+) {
+        for (auto i = begin; i != end; ++i) {
+                switch (uri_class(text[i])) {
+                case uc_alpha: case uc_digit: case uc_scheme_punct:
+                case uc_unreserved: case uc_sub_delim:
+                        break;
+                case uc_colon:
+                        if (!colon)
+                                return false;
+                        break;
+                case uc_percent:
+                        // Checked while scanning the authority.
+                        i += 2;
+                        break;
+                default:
+                        return false;
+                }
+        }
+        return true;
+}
+
+//      authority     = [ userinfo "@" ] host [ ":" port ]
+//      userinfo      = *( unreserved / pct-encoded / sub-delims / ":" )
+//      host          = IP-literal / IPv4address / reg-name
+//      IP-literal    = "[" ( IPv6address / IPvFuture  ) "]"
+//      reg-name      = *( unreserved / pct-encoded / sub-delims )
+//      port          = *DIGIT
+// Scans the authority starting at `pos` and records its parts; returns
+// where it ends, or npos if it is malformed.
+std::size_t scan_authority(std::string_view text, std::size_t pos,
+                           UriSpans &ret
+) {
+        const auto begin = pos;
+        std::size_t at = std::string_view::npos;
+        for (; pos != text.size(); ++pos) {
+                const auto cls = uri_class(text[pos]);
+                if (cls == uc_percent) {
+                        if (!is_pct_encoded(text, pos))
+                                break;
+                        pos += 2;
+                } else if (cls == uc_at) {
+                        if (at == std::string_view::npos)
+                                at = pos;
+                } else if (!is_pchar_class(cls) && cls != uc_bracket) {
+                        break;
+                }
+        }
+        const auto end = pos;
+        ret.authority = {begin, end, true};
+
+        auto host = begin;
+        if (at != std::string_view::npos) {
+                if (!is_reg_chars(text, begin, at, true))
+                        return std::string_view::npos;
+                ret.userinfo = {begin, at, true};
+                host = at + 1;
+        }
+
+        auto hostEnd = host;
+        if (host != end && text[host] == '[') {
+                const auto close = text.substr(0, end).find(']', host);
+                if (close == std::string_view::npos)
+                        return std::string_view::npos;
+                const auto literal = text.substr(host + 1, close - host - 1);
+                if (!is_IPv6address(literal) && !is_IPvFuture(literal))
+                        return std::string_view::npos;
+                hostEnd = close + 1;
+        } else {
+                while (hostEnd != end && text[hostEnd] != ':')
+                        ++hostEnd;
+                if (!is_reg_chars(text, host, hostEnd, false))
+                        return std::string_view::npos;
+        }
+        ret.host = {host, hostEnd, true};
+
+        if (hostEnd != end) {
+                if (text[hostEnd] != ':')
+                        return std::string_view::npos;
+                for (auto i = hostEnd + 1; i != end; ++i)
+                        if (uri_class(text[i]) != uc_digit)
+                                return std::string_view::npos;
+                ret.port = {hostEnd + 1, end, true};
+        }
+        return end;
+}
+}
+
+//      URI           = scheme ":" hier-part [ "?" query ] [ "#" fragment ]
+//      scheme        = ALPHA *( ALPHA / DIGIT / "+" / "-" / "." )
+//      hier-part     = "//" authority path-abempty
+//                    / path-absolute
+//                    / path-rootless
+//                    / path-empty
+//      query         = *( pchar / "/" / "?" )
+//      fragment      = *( pchar / "/" / "?" )
+optional<UriSpans> scan_URI(std::string_view text) {
+        UriSpans ret;
+        std::size_t colon = 0, pathBegin = 0, query = 0, fragment = 0;
+        std::size_t pos = 0;
+        int state = us_start;
+        while (pos != text.size()) {
+                const auto cls = uri_class(text[pos]);
+                const int next = uriTransitions[state][cls];
+                if (next == us_stop)
+                        break;
+                if (cls == uc_percent && !is_pct_encoded(text, pos))
+                        break;
+                if (next == us_authority) {
+                        UriSpans auth;
+                        const auto end = scan_authority(text, pos + 1, auth);
+                        if (end == std::string_view::npos)
+                                break;
+                        ret.authority = auth.authority;
+                        ret.userinfo = auth.userinfo;
+                        ret.host = auth.host;
+                        ret.port = auth.port;
+                        pathBegin = pos = end;
+                        state = us_path;
+                        continue;
+                }
+                if (next == us_colon)
+                        pathBegin = colon = pos + 1;
+                else if (next == us_query && state != us_query)
+                        query = pos + 1;
+                else if (next == us_fragment && state != us_fragment)
+                        fragment = pos + 1;
+                pos += cls == uc_percent ? 3 : 1;
+                state = next;
+        }
+        if (state == us_start || state == us_scheme)
+                return nullopt;
+
+        ret.length = pos;
+        ret.scheme = {0, colon - 1, true};
+        const auto hierEnd = query ? query - 1 : fragment ? fragment - 1 : pos;
+        ret.hier_part = {colon, hierEnd, true};
+        ret.path = {pathBegin, hierEnd, true};
+        if (query)
+                ret.query = {query, fragment ? fragment - 1 : pos, true};
+        if (fragment)
+                ret.fragment = {fragment, pos, true};
+        return ret;
+}
+
+Uri to_uri(std::string_view text, UriSpans const &spans) {
+        Uri ret;
+        ret.scheme = string(spans.scheme.in(text));
+        ret.hier_part = string(spans.hier_part.in(text));
+        if (spans.query.present)
+                ret.query = string(spans.query.in(text));
+        if (spans.fragment.present)
+                ret.fragment = string(spans.fragment.in(text));
+        return ret;
+}
+
+
 std::ostream& operator<<(std::ostream& os, Uri const &v) {
         return os << to_string(v);
 }
@@ -0,0 +1,249 @@
+#include "rule_stats.hh"
+#include <algorithm>
+#include <cstdio>
+#include <ostream>
+
+#ifdef ICAL_RULE_STATS
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace rule_stats_detail {
+namespace {
+
+// Ids beyond the last slot share it.
+constexpr std::size_t max_rules = 1024;
+
+struct Edge {
+        std::uint64_t rollbacks = 0;
+        std::uint64_t bytes = 0;
+};
+
+struct Block {
+        Counters rules[max_rules];
+        // Keyed by rule * (max_rules + 1) + caller; callers at the top level
+        // are max_rules. Rollbacks are rare compared to calls, so a locked
+        // map is fine here.
+        std::mutex edgesMutex;
+        std::unordered_map<std::size_t, Edge> edges;
+};
+
+struct Registry {
+        std::mutex mutex;
+        std::deque<std::string> names;
+        std::vector<std::shared_ptr<Block>> blocks; // one per thread, ever
+};
+
+Registry& registry() {
+        static Registry ret;
+        return ret;
+}
+
+Block& thread_block() {
+        thread_local std::shared_ptr<Block> block = [] {
+                auto ret = std::make_shared<Block>();
+                auto &r = registry();
+                std::lock_guard<std::mutex> lock(r.mutex);
+                r.blocks.push_back(ret);
+                return ret;
+        }();
+        return *block;
+}
+
+}
+
+std::size_t register_rule(char const *name) {
+        auto &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        // Overloads share a name, and so they share the counters.
+        for (std::size_t i = 0; i != r.names.size(); ++i)
+                if (r.names[i] == name)
+                        return i;
+        if (r.names.size() == max_rules - 1)
+                r.names.emplace_back("(other)");
+        if (r.names.size() == max_rules)
+                return max_rules - 1;
+        r.names.emplace_back(name);
+        return r.names.size() - 1;
+}
+
+Counters& counters(std::size_t rule) {
+        return thread_block().rules[rule];
+}
+
+void record_backtrack(std::size_t rule, std::size_t caller, std::uint64_t bytes) {
+        if (caller >= max_rules)
+                caller = max_rules;
+        auto &b = thread_block();
+        std::lock_guard<std::mutex> lock(b.edgesMutex);
+        auto &e = b.edges[rule * (max_rules + 1) + caller];
+        ++e.rollbacks;
+        e.bytes += bytes;
+}
+
+}
+
+std::vector<RuleStats> collect_rule_stats() {
+        using namespace rule_stats_detail;
+        auto &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+
+        std::vector<RuleStats> ret(r.names.size());
+        for (std::size_t i = 0; i != ret.size(); ++i)
+                ret[i].name = r.names[i];
+        for (auto const &block : r.blocks) {
+                for (std::size_t i = 0; i != ret.size(); ++i) {
+                        auto const &c = block->rules[i];
+                        auto &s = ret[i];
+                        s.calls += c.calls.load(std::memory_order_relaxed);
+                        s.matches += c.matches.load(std::memory_order_relaxed);
+                        s.noMatches += c.noMatches.load(std::memory_order_relaxed);
+                        s.bytesConsumed += c.bytesConsumed.load(std::memory_order_relaxed);
+                        s.rollbacks += c.rollbacks.load(std::memory_order_relaxed);
+                        s.bytesRolledBack += c.bytesRolledBack.load(std::memory_order_relaxed);
+                        s.nanoseconds += c.nanoseconds.load(std::memory_order_relaxed);
+                }
+        }
+        ret.erase(std::remove_if(ret.begin(), ret.end(),
+                                 [](RuleStats const &s) { return s.calls == 0; }),
+                  ret.end());
+        std::sort(ret.begin(), ret.end(),
+                  [](RuleStats const &a, RuleStats const &b) {
+                          return a.nanoseconds > b.nanoseconds;
+                  });
+        return ret;
+}
+
+void reset_rule_stats() {
+        using namespace rule_stats_detail;
+        auto &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (auto const &block : r.blocks) {
+                for (auto &c : block->rules) {
+                        c.calls = 0;
+                        c.matches = 0;
+                        c.noMatches = 0;
+                        c.bytesConsumed = 0;
+                        c.rollbacks = 0;
+                        c.bytesRolledBack = 0;
+                        c.nanoseconds = 0;
+                }
+                std::lock_guard<std::mutex> edgesLock(block->edgesMutex);
+                block->edges.clear();
+        }
+}
+
+std::vector<BacktrackStats> collect_backtrack_stats() {
+        using namespace rule_stats_detail;
+        auto &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+
+        std::map<std::size_t, Edge> sum;
+        for (auto const &block : r.blocks) {
+                std::lock_guard<std::mutex> edgesLock(block->edgesMutex);
+                for (auto const &kv : block->edges) {
+                        auto &e = sum[kv.first];
+                        e.rollbacks += kv.second.rollbacks;
+                        e.bytes += kv.second.bytes;
+                }
+        }
+
+        std::vector<BacktrackStats> ret;
+        for (auto const &kv : sum) {
+                const auto rule = kv.first / (max_rules + 1);
+                const auto caller = kv.first % (max_rules + 1);
+                BacktrackStats s;
+                s.rule = r.names[rule];
+                if (caller != max_rules)
+                        s.caller = r.names[caller];
+                s.rollbacks = kv.second.rollbacks;
+                s.bytesRolledBack = kv.second.bytes;
+                ret.push_back(std::move(s));
+        }
+        std::sort(ret.begin(), ret.end(),
+                  [](BacktrackStats const &a, BacktrackStats const &b) {
+                          return a.bytesRolledBack > b.bytesRolledBack;
+                  });
+        return ret;
+}
+
+#else
+
+std::vector<RuleStats> collect_rule_stats() {
+        return {};
+}
+
+void reset_rule_stats() {
+}
+
+std::vector<BacktrackStats> collect_backtrack_stats() {
+        return {};
+}
+
+#endif
+
+void print_rule_stats(std::ostream &os) {
+        if (!rule_stats_enabled()) {
+                os << "rule statistics are not compiled in "
+                      "(configure with -DSUPERCAL_RULE_STATS=ON)\n";
+                return;
+        }
+        char line[256];
+        std::snprintf(line, sizeof(line),
+                      "%-28s %12s %12s %12s %14s %10s %14s %10s\n",
+                      "rule", "calls", "matches", "no-matches",
+                      "consumed", "rollbacks", "rolled back", "ms");
+        os << line;
+        for (auto const &s : collect_rule_stats()) {
+                std::snprintf(line, sizeof(line),
+                              "%-28s %12llu %12llu %12llu %14llu %10llu %14llu %10.1f\n",
+                              s.name.c_str(),
+                              (unsigned long long)s.calls,
+                              (unsigned long long)s.matches,
+                              (unsigned long long)s.noMatches,
+                              (unsigned long long)s.bytesConsumed,
+                              (unsigned long long)s.rollbacks,
+                              (unsigned long long)s.bytesRolledBack,
+                              s.nanoseconds / 1e6);
+                os << line;
+        }
+}
+
+void print_backtrack_report(std::ostream &os, std::uint64_t inputBytes) {
+        if (!rule_stats_enabled()) {
+                os << "backtracking statistics are not compiled in "
+                      "(configure with -DSUPERCAL_RULE_STATS=ON)\n";
+                return;
+        }
+        const auto stats = collect_backtrack_stats();
+        std::uint64_t total = 0;
+        for (auto const &s : stats)
+                total += s.bytesRolledBack;
+
+        char line[256];
+        os << "re-scanned bytes: " << total;
+        if (inputBytes) {
+                std::snprintf(line, sizeof(line), " (%.2f per input byte)",
+                              double(total) / inputBytes);
+                os << line;
+        }
+        os << "\n";
+        std::snprintf(line, sizeof(line), "%-28s %-28s %10s %14s %10s %7s\n",
+                      "rule", "called from", "rollbacks", "re-scanned",
+                      "avg", "share");
+        os << line;
+        for (auto const &s : stats) {
+                std::snprintf(line, sizeof(line),
+                              "%-28s %-28s %10llu %14llu %10.1f %6.2f%%\n",
+                              s.rule.c_str(),
+                              s.caller.empty() ? "-" : s.caller.c_str(),
+                              (unsigned long long)s.rollbacks,
+                              (unsigned long long)s.bytesRolledBack,
+                              double(s.bytesRolledBack) / s.rollbacks,
+                              total ? 100.0 * s.bytesRolledBack / total : 0.0);
+                os << line;
+        }
+}
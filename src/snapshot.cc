@@ -0,0 +1,381 @@
+#include "snapshot.hh"
+#include <cstring>
+#include <ostream>
+#include <unordered_map>
+
+namespace {
+
+// -- Conversions. -------------------------------------------------------------
+int to_int(string const &v) {
+        int ret = 0;
+        for (auto c : v) {
+                if (c < '0' || c > '9')
+                        break;
+                ret = ret * 10 + (c - '0');
+        }
+        return ret;
+}
+
+SnapDateTime snap_date(Date const &v) {
+        SnapDateTime ret;
+        ret.year = static_cast<std::int16_t>(to_int(v.year));
+        ret.month = static_cast<std::uint8_t>(to_int(v.month));
+        ret.day = static_cast<std::uint8_t>(to_int(v.day));
+        ret.flags = snap_has_date;
+        return ret;
+}
+
+SnapDateTime snap_date(DateTime const &v) {
+        auto ret = snap_date(v.date);
+        ret.hour = static_cast<std::uint8_t>(to_int(v.time.hour.value));
+        ret.minute = static_cast<std::uint8_t>(to_int(v.time.minute.value));
+        ret.second = static_cast<std::uint8_t>(to_int(v.time.second.value));
+        ret.flags |= snap_has_time;
+        if (v.time.utc)
+                ret.flags |= snap_is_utc;
+        return ret;
+}
+
+template <typename ...Types>
+SnapDateTime snap_date(xvariant<Types...> const &v) {
+        SnapDateTime ret;
+        visit([&ret](auto const &d) { ret = snap_date(d); }, v);
+        return ret;
+}
+
+std::int32_t seconds(UtcOffset const &v) {
+        const auto &z = v.numZone;
+        auto ret = to_int(z.hour.value) * 3600 + to_int(z.minute.value) * 60;
+        if (z.second)
+                ret += to_int(z.second->value);
+        return z.sign < 0 ? -ret : ret;
+}
+
+template <typename T>
+constexpr std::size_t align8(T v) {
+        return (static_cast<std::size_t>(v) + 7) & ~std::size_t(7);
+}
+
+// Checksum over the header with its checksum field zeroed, plus whatever
+// a newer minor version appended to the header.
+std::uint64_t header_checksum(char const *data, std::size_t headerSize) {
+        SnapshotHeader h;
+        std::memcpy(&h, data, sizeof(h));
+        h.headerChecksum = 0;
+        auto ret = hash128(&h, sizeof(h));
+        if (headerSize > sizeof(h))
+                ret = hash128(data + sizeof(h), headerSize - sizeof(h), ret.lo);
+        return ret.lo;
+}
+
+std::uint64_t payload_checksum(char const *data, std::size_t headerSize,
+                               std::size_t totalSize
+) {
+        return hash128(data + headerSize, totalSize - headerSize).lo;
+}
+
+// -- SnapshotBuilder. ---------------------------------------------------------
+class SnapshotBuilder {
+public:
+        SnapStr str(string const &v) {
+                const auto it = stringIndex_.find(v);
+                if (it != stringIndex_.end())
+                        return it->second;
+                SnapStr ret;
+                ret.offset = static_cast<std::uint32_t>(strings_.size());
+                ret.length = static_cast<std::uint32_t>(v.size());
+                strings_ += v;
+                stringIndex_.emplace(v, ret);
+                return ret;
+        }
+
+        template <typename String>
+        SnapList list(vector<String> const &v) {
+                SnapList ret;
+                ret.first = static_cast<std::uint32_t>(lists_.size());
+                ret.count = static_cast<std::uint32_t>(v.size());
+                for (auto const &s : v)
+                        lists_.push_back(str(s));
+                return ret;
+        }
+
+        void component(Component const &v) {
+                SnapComponent c;
+                c.kind = static_cast<std::uint16_t>(v.index());
+                c.contentHash = content_hash(v);
+                c.firstProperty = static_cast<std::uint32_t>(props_.size());
+                visit([this, &c](auto const &comp) { add(c, comp); }, v);
+                c.propertyCount = static_cast<std::uint32_t>(
+                        props_.size() - c.firstProperty);
+                comps_.push_back(c);
+        }
+
+        std::vector<char> finish(CalProps const &cal);
+
+private:
+        SnapProperty& prop(SnapPropertyKind kind) {
+                props_.emplace_back();
+                props_.back().kind = static_cast<std::uint16_t>(kind);
+                return props_.back();
+        }
+
+        // -- Components. ------------------------------------------------------
+        void add(SnapComponent &c, EventComp const &v) {
+                c.alarmCount = static_cast<std::uint32_t>(v.alarms.size());
+                for (auto const &p : v.properties)
+                        visit([this](auto const &x) { add(x); }, p);
+        }
+
+        void add(SnapComponent &, TimezoneComp const &v) {
+                prop(SnapPropertyKind::TzId).value = str(v.tzId.text);
+                if (v.lastMod)
+                        add(*v.lastMod);
+                if (auto p = get_if<StandardC>(&v.observance))
+                        add(SnapPropertyKind::Standard, p->tzProp);
+                if (auto p = get_if<DaylightC>(&v.observance))
+                        add(SnapPropertyKind::Daylight, p->tzProp);
+                for (auto const &x : v.xProps)
+                        add(x);
+                for (auto const &x : v.ianaProps)
+                        add(x);
+        }
+
+        template <typename T>
+        void add(SnapComponent &, T const &) {}
+
+        void add(SnapPropertyKind kind, TzProp const &v) {
+                auto &p = prop(kind);
+                p.dateTime = snap_date(v.dtStart.value);
+                p.integer = seconds(v.offsetTo.utcOffset);
+                p.aux = seconds(v.offsetFrom.utcOffset);
+        }
+
+        // -- Properties. ------------------------------------------------------
+        void add(DtStamp const &v) {
+                prop(SnapPropertyKind::DtStamp).dateTime = snap_date(v.date_time);
+        }
+        void add(Uid const &v) {
+                prop(SnapPropertyKind::Uid).value = str(v.value);
+        }
+        void add(DtStart const &v) {
+                auto &p = prop(SnapPropertyKind::DtStart);
+                p.dateTime = snap_date(v.value);
+                p.name = str(v.params.tz_id.paramtext);
+        }
+        void add(DtEnd const &v) {
+                auto &p = prop(SnapPropertyKind::DtEnd);
+                p.dateTime = snap_date(v.value);
+                p.name = str(v.params.tz_id.paramtext);
+        }
+        void add(Class const &v) {
+                prop(SnapPropertyKind::Class).value = str(v.value);
+        }
+        void add(Created const &v) {
+                prop(SnapPropertyKind::Created).dateTime = snap_date(v.dateTime);
+        }
+        void add(Description const &v) {
+                prop(SnapPropertyKind::Description).value = str(v.value.raw());
+        }
+        void add(Geo const &v) {
+                auto &p = prop(SnapPropertyKind::Geo);
+                p.name = str(v.value.latitude);
+                p.value = str(v.value.longitude);
+        }
+        void add(LastMod const &v) {
+                prop(SnapPropertyKind::LastMod).dateTime = snap_date(v.dateTime);
+        }
+        void add(Location const &v) {
+                prop(SnapPropertyKind::Location).value = str(v.value);
+        }
+        void add(Organizer const &v) {
+                auto &p = prop(SnapPropertyKind::Organizer);
+                p.value = str(to_string(v.address));
+                if (v.params.cn)
+                        p.name = str(v.params.cn->value);
+        }
+        void add(Seq const &v) {
+                prop(SnapPropertyKind::Seq).integer = v.value;
+        }
+        void add(Status const &v) {
+                auto &p = prop(SnapPropertyKind::Status);
+                visit([&](having_string_value const &s) {
+                        p.value = str(s.value);
+                }, v.value);
+        }
+        void add(Summary const &v) {
+                prop(SnapPropertyKind::Summary).value = str(v.value.raw());
+        }
+        void add(Transp const &v) {
+                prop(SnapPropertyKind::Transp).value = str(v.value);
+        }
+        void add(RRule const &v) {
+                auto &p = prop(SnapPropertyKind::RRule);
+                const auto &r = v.recur;
+                p.flags = static_cast<std::uint16_t>(r.freq);
+                if (auto until = get_if<EndDate>(&r.duration))
+                        p.dateTime = snap_date(*until);
+                else if (auto count = get_if<string>(&r.duration))
+                        p.integer = to_int(*count);
+                if (r.interval)
+                        p.aux = to_int(*r.interval);
+        }
+        void add(Categories const &v) {
+                prop(SnapPropertyKind::Categories).list = list(v.values);
+        }
+        void add(XProp const &v) {
+                auto &p = prop(SnapPropertyKind::XProp);
+                p.name = str(v.name);
+                p.value = str(v.value);
+        }
+        void add(IanaProp const &v) {
+                auto &p = prop(SnapPropertyKind::IanaProp);
+                p.name = str(v.ianaToken);
+                p.value = str(v.value);
+        }
+        void add(Priority const &)  { prop(SnapPropertyKind::Priority); }
+        void add(Url const &)       { prop(SnapPropertyKind::Url); }
+        void add(RecurId const &)   { prop(SnapPropertyKind::RecurId); }
+        void add(Duration const &)  { prop(SnapPropertyKind::Duration); }
+        void add(Attach const &)    { prop(SnapPropertyKind::Attach); }
+        void add(Attendee const &)  { prop(SnapPropertyKind::Attendee); }
+        void add(Comment const &)   { prop(SnapPropertyKind::Comment); }
+        void add(Contact const &)   { prop(SnapPropertyKind::Contact); }
+        void add(ExDate const &)    { prop(SnapPropertyKind::ExDate); }
+        void add(RStatus const &)   { prop(SnapPropertyKind::RStatus); }
+        void add(Related const &)   { prop(SnapPropertyKind::Related); }
+        void add(Resources const &) { prop(SnapPropertyKind::Resources); }
+        void add(RDate const &)     { prop(SnapPropertyKind::RDate); }
+
+        string strings_;
+        std::unordered_map<string, SnapStr> stringIndex_;
+        vector<SnapStr> lists_;
+        vector<SnapComponent> comps_;
+        vector<SnapProperty> props_;
+};
+
+template <typename T>
+void put(std::vector<char> &out, SnapSection &section, vector<T> const &v) {
+        section.offset = out.size();
+        section.count = v.size();
+        out.resize(align8(out.size() + v.size() * sizeof(T)));
+        if (!v.empty())
+                std::memcpy(&out[section.offset], v.data(), v.size() * sizeof(T));
+}
+
+std::vector<char> SnapshotBuilder::finish(CalProps const &cal) {
+        SnapshotHeader h{};
+        std::memcpy(h.magic, snapshot_magic, sizeof(h.magic));
+        h.versionMajor = snapshot_version_major;
+        h.versionMinor = snapshot_version_minor;
+        h.headerSize = sizeof(SnapshotHeader);
+        h.byteOrder = snapshot_byte_order;
+
+        h.prodId = str(cal.prodId.value);
+        h.version = str(cal.version.value);
+        if (cal.calScale)
+                h.calScale = str(cal.calScale->value);
+        if (cal.method)
+                h.method = str(cal.method->value);
+
+        std::vector<char> out(sizeof(SnapshotHeader));
+        vector<char> strings(strings_.begin(), strings_.end());
+        put(out, h.strings, strings);
+        put(out, h.lists, lists_);
+        put(out, h.components, comps_);
+        put(out, h.properties, props_);
+
+        h.totalSize = out.size();
+        h.payloadChecksum = payload_checksum(out.data(), h.headerSize,
+                                             out.size());
+        std::memcpy(out.data(), &h, sizeof(h));
+        h.headerChecksum = header_checksum(out.data(), h.headerSize);
+        std::memcpy(out.data(), &h, sizeof(h));
+        return out;
+}
+
+}
+
+// -- Writer. ------------------------------------------------------------------
+std::vector<char> make_snapshot(Calendar const &cal) {
+        SnapshotBuilder builder;
+        for (auto const &c : cal.components)
+                builder.component(c);
+        return builder.finish(cal.properties);
+}
+
+void write_snapshot(std::ostream &os, Calendar const &cal) {
+        const auto bytes = make_snapshot(cal);
+        os.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+// -- Reader. ------------------------------------------------------------------
+namespace {
+template <typename T>
+SnapRange<T> section(char const *data, SnapshotHeader const &h,
+                     SnapSection const &s, char const *name
+) {
+        if (s.offset % alignof(T) != 0 ||
+            s.offset < h.headerSize ||
+            s.offset > h.totalSize ||
+            s.count > (h.totalSize - s.offset) / sizeof(T))
+                throw invalid_snapshot(string("bad ") + name + " section");
+        return {reinterpret_cast<T const*>(data + s.offset),
+                static_cast<std::size_t>(s.count)};
+}
+}
+
+SnapshotView::SnapshotView(void const *data, std::size_t size) :
+        data_(static_cast<char const*>(data)),
+        size_(size)
+{
+        if (size_ < sizeof(SnapshotHeader))
+                throw invalid_snapshot("truncated header");
+        if (reinterpret_cast<std::uintptr_t>(data_) % 8 != 0)
+                throw invalid_snapshot("misaligned buffer");
+
+        const auto &h = *reinterpret_cast<SnapshotHeader const*>(data_);
+        if (std::memcmp(h.magic, snapshot_magic, sizeof(h.magic)) != 0)
+                throw invalid_snapshot("bad magic");
+        if (h.byteOrder != snapshot_byte_order)
+                throw invalid_snapshot("foreign byte order");
+        if (h.versionMajor != snapshot_version_major)
+                throw invalid_snapshot("unsupported version");
+        if (h.headerSize < sizeof(SnapshotHeader) || h.headerSize > size_)
+                throw invalid_snapshot("bad header size");
+        if (h.headerChecksum != header_checksum(data_, h.headerSize))
+                throw invalid_snapshot("header checksum mismatch");
+        if (h.totalSize < h.headerSize || h.totalSize > size_)
+                throw invalid_snapshot("truncated payload");
+
+        header_ = &h;
+        const auto strings = section<char>(data_, h, h.strings, "string");
+        strings_ = std::string_view(strings.begin(), strings.size());
+        lists_ = section<SnapStr>(data_, h, h.lists, "list");
+        components_ = section<SnapComponent>(data_, h, h.components, "component");
+        properties_ = section<SnapProperty>(data_, h, h.properties, "property");
+}
+
+SnapRange<SnapProperty> SnapshotView::properties(SnapComponent const &c) const {
+        if (c.firstProperty > properties_.size() ||
+            c.propertyCount > properties_.size() - c.firstProperty)
+                throw invalid_snapshot("property range out of bounds");
+        return {properties_.begin() + c.firstProperty, c.propertyCount};
+}
+
+std::string_view SnapshotView::str(SnapStr const &v) const {
+        if (v.offset > strings_.size() ||
+            v.length > strings_.size() - v.offset)
+                throw invalid_snapshot("string out of bounds");
+        return strings_.substr(v.offset, v.length);
+}
+
+SnapRange<SnapStr> SnapshotView::list(SnapList const &v) const {
+        if (v.first > lists_.size() || v.count > lists_.size() - v.first)
+                throw invalid_snapshot("list out of bounds");
+        return {lists_.begin() + v.first, v.count};
+}
+
+bool SnapshotView::verify_payload() const {
+        return header_->payloadChecksum ==
+               payload_checksum(data_, header_->headerSize, header_->totalSize);
+}
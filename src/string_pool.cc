@@ -0,0 +1,40 @@
+#include "string_pool.hh"
+#include <ostream>
+
+namespace {
+std::string const emptyString;
+}
+
+InternedString::InternedString() : str_(&emptyString) {}
+
+std::ostream& operator<<(std::ostream& os, InternedString const &v) {
+        return os << v.str();
+}
+
+InternedString StringPool::intern(std::string_view s) {
+        if (s.empty())
+                return InternedString();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (const auto it = index_.find(s); it != index_.end())
+                return InternedString(it->second);
+        auto const &stored = strings_.emplace_back(s);
+        index_.emplace(stored, &stored);
+        bytes_ += stored.size();
+        return InternedString(&stored);
+}
+
+std::size_t StringPool::size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return strings_.size();
+}
+
+std::size_t StringPool::bytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return bytes_;
+}
+
+StringPool& StringPool::global() {
+        // Leaked, so that InternedStrings in static objects stay valid.
+        static auto *pool = new StringPool();
+        return *pool;
+}
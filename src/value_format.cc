@@ -0,0 +1,114 @@
+#include "value_format.hh"
+
+char const* to_string(Freq v) {
+        switch (v) {
+        case Secondly: return "SECONDLY";
+        case Minutely: return "MINUTELY";
+        case Hourly:   return "HOURLY";
+        case Daily:    return "DAILY";
+        case Weekly:   return "WEEKLY";
+        case Monthly:  return "MONTHLY";
+        case Yearly:   return "YEARLY";
+        }
+        return "";
+}
+
+char const* to_string(WeekDay v) {
+        switch (v) {
+        case Sunday:    return "SU";
+        case Monday:    return "MO";
+        case Tuesday:   return "TU";
+        case Wednesday: return "WE";
+        case Thursday:  return "TH";
+        case Friday:    return "FR";
+        case Saturday:  return "SA";
+        }
+        return "";
+}
+
+std::string to_string(WeekDayNum const &v) {
+        std::string ret;
+        if (v.week) {
+                if (v.week->sign < 0)
+                        ret += '-';
+                ret += v.week->ordWk;
+        }
+        ret += to_string(v.weekDay);
+        return ret;
+}
+
+void append_value(std::string &out, Date const &v) {
+        out += v.year; out += '-'; out += v.month; out += '-'; out += v.day;
+}
+
+void append_value(std::string &out, DateTime const &v) {
+        append_value(out, v.date);
+        out += 'T';
+        out += v.time.hour.value; out += ':';
+        out += v.time.minute.value; out += ':';
+        out += v.time.second.value;
+        if (v.time.utc)
+                out += 'Z';
+}
+
+void append_value(std::string &out, UtcOffset const &v) {
+        const auto &z = v.numZone;
+        out += z.sign < 0 ? '-' : '+';
+        out += z.hour.value; out += ':'; out += z.minute.value;
+        if (z.second) {
+                out += ':';
+                out += z.second->value;
+        }
+}
+
+namespace {
+void append(std::string &out, DurSecond const &v) {
+        out += v.second; out += 'S';
+}
+
+void append(std::string &out, DurMinute const &v) {
+        out += v.minute; out += 'M';
+        if (v.second)
+                append(out, *v.second);
+}
+
+void append(std::string &out, DurHour const &v) {
+        out += v.hour; out += 'H';
+        if (v.minute)
+                append(out, *v.minute);
+}
+
+void append(std::string &out, DurTime const &v) {
+        out += 'T';
+        visit([&out](auto const &t) { append(out, t); }, v);
+}
+}
+
+void append_value(std::string &out, DurValue const &v) {
+        if (!v.positive)
+                out += '-';
+        out += 'P';
+        if (auto d = get_if<DurDate>(&v.value)) {
+                out += d->day.value; out += 'D';
+                if (d->time)
+                        append(out, *d->time);
+        } else if (auto t = get_if<DurTime>(&v.value)) {
+                append(out, *t);
+        } else {
+                out += get<DurWeek>(v.value).value; out += 'W';
+        }
+}
+
+Date const& date_of(EndDate const &v) {
+        if (auto d = get_if<Date>(&v))
+                return *d;
+        return get<DateTime>(v).date;
+}
+
+std::string lower_case(std::string_view v) {
+        std::string ret(v);
+        for (auto &c : ret)
+                if (c >= 'A' && c <= 'Z')
+                        c = char(c - 'A' + 'a');
+        return ret;
+}
@@ -0,0 +1,582 @@
+#include "xcal.hh"
+#include "value_format.hh"
+#include <cstring>
+
+// -- XML text. ----------------------------------------------------------------
+namespace {
+bool needs_xml_escape(char c) {
+        return c == '&' || c == '<' || c == '>' || c == '\r';
+}
+
+void append_xml_escape(OutputBuffer &out, char c) {
+        switch (c) {
+        case '&':  out << "&amp;"; return;
+        case '<':  out << "&lt;"; return;
+        case '>':  out << "&gt;"; return;
+        case '\r': out << "&#13;"; return;
+        }
+}
+}
+
+// UTF-8 passes through, as in append_json_string().
+void append_xml_text(OutputBuffer &out, std::string_view v) {
+        auto p = v.data();
+        const auto end = p + v.size();
+        while (p != end) {
+                auto run = p;
+                for (; end - run >= 8; run += 8) {
+                        const auto x = swar::load(run);
+                        if (swar::has_byte(x, '&') || swar::has_byte(x, '<') ||
+                            swar::has_byte(x, '>') || swar::has_byte(x, '\r'))
+                                break;
+                }
+                while (run != end && !needs_xml_escape(*run))
+                        ++run;
+                out.append(std::string_view(p, run - p));
+                if (run == end)
+                        break;
+                append_xml_escape(out, *run);
+                p = run + 1;
+        }
+}
+
+namespace {
+
+// -- XcalWriter. --------------------------------------------------------------
+// A property is begin(), its parameters, values(), its value elements and
+// end(). <parameters> is opened by the first parameter, if there is one,
+// and closed by values().
+class XcalWriter {
+public:
+        explicit XcalWriter(OutputBuffer &out) : out_(out) {}
+
+        void document(Calendar const &cal) {
+                out_ << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+                        "<icalendar xmlns="
+                        "\"urn:ietf:params:xml:ns:icalendar-2.0\">";
+                calendar(cal);
+                out_ << "</icalendar>\n";
+        }
+
+        void calendar(Calendar const &cal) {
+                open("vcalendar");
+                open("properties");
+                calprops(cal.properties);
+                close("properties");
+                open("components");
+                for (auto const &c : cal.components)
+                        component(c);
+                close("components");
+                close("vcalendar");
+        }
+
+        void component(Component const &v) {
+                visit([this](auto const &c) { add(c); }, v);
+        }
+
+private:
+        // -- XML. -------------------------------------------------------------
+        void open(std::string_view name) {
+                out_.put('<');
+                out_ << name;
+                out_.put('>');
+        }
+        void close(std::string_view name) {
+                out_ << "</";
+                out_ << name;
+                out_.put('>');
+        }
+        void element(std::string_view name, std::string_view text) {
+                open(name);
+                append_xml_text(out_, text);
+                close(name);
+        }
+        // TEXT as in the file, to be decoded.
+        void text(std::string_view raw) {
+                if (std::memchr(raw.data(), '\\', raw.size()))
+                        element("text", unescape_text(raw));
+                else
+                        element("text", raw);
+        }
+        void text(string const &raw) {
+                text(std::string_view(raw));
+        }
+        void text(Text const &v) {
+                if (v.has_escapes())
+                        element("text", unescape_text(v.raw()));
+                else
+                        element("text", v.raw());
+        }
+        template <typename T>
+        void formatted(std::string_view type, T const &v) {
+                scratch_.clear();
+                append_value(scratch_, v);
+                element(type, scratch_);
+        }
+
+        // -- Properties and parameters. ---------------------------------------
+        void begin(std::string_view name) {
+                property_.assign(name.data(), name.size());
+                open(property_);
+                inParams_ = false;
+        }
+        void values() {
+                if (inParams_)
+                        close("parameters");
+                inParams_ = false;
+        }
+        void end() {
+                close(property_);
+        }
+
+        void param_begin(std::string_view name) {
+                if (!inParams_)
+                        open("parameters");
+                inParams_ = true;
+                open(name);
+        }
+        // RFC 6321, 3.5: the value type is that of the parameter.
+        void param(std::string_view name, std::string_view type,
+                   std::string_view value) {
+                param_begin(name);
+                element(type, value);
+                close(name);
+        }
+        void param(std::string_view name, std::string_view value) {
+                param(name, "text", value);
+        }
+        void param(std::string_view name, std::string_view type,
+                   vector<string> const &values) {
+                param_begin(name);
+                for (auto const &v : values)
+                        element(type, v);
+                close(name);
+        }
+        void params(vector<OtherParam> const &v) {
+                for (auto const &p : v)
+                        param(p);
+        }
+        void param(OtherParam const &v) {
+                if (auto p = get_if<XParam>(&v))
+                        param(lower_case(p->name.view()), "text", p->values);
+                else
+                        param(lower_case(get<IanaParam>(v).token), "text",
+                              get<IanaParam>(v).values);
+        }
+        void param(TzIdParam const &v) {
+                if (v.paramtext.empty())
+                        return;
+                scratch_ = v.prefix ? v.prefix->value : string();
+                scratch_ += v.paramtext.str();
+                param("tzid", scratch_);
+        }
+        void param(ICalParameter const &v) {
+                visit([this](auto const &p) { any_param(p); }, v);
+        }
+        void any_param(AltRepParam const &v)   {
+                param("altrep", "uri", v.value);
+        }
+        void any_param(CnParam const &v)       { param("cn", v.value); }
+        void any_param(CuTypeParam const &v)   { param("cutype", v.value); }
+        void any_param(DelFromParam const &v)  {
+                param("delegated-from", "cal-address", v.values);
+        }
+        void any_param(DelToParam const &v)    {
+                param("delegated-to", "cal-address", v.values);
+        }
+        void any_param(DirParam const &v)      { param("dir", "uri", v.value); }
+        void any_param(EncodingParam const &v) { param("encoding", v.value); }
+        void any_param(FmtTypeParam const &v)  { param("fmttype", v.value); }
+        void any_param(FbTypeParam const &v)   { param("fbtype", v.value); }
+        void any_param(LanguageParam const &v) { param("language", v.value); }
+        void any_param(MemberParam const &v)   {
+                vector<string> uris;
+                for (auto const &u : v.values)
+                        uris.push_back(to_string(u));
+                param("member", "cal-address", uris);
+        }
+        void any_param(PartStatParam const &v) {
+                visit([this](having_string_value const &p) {
+                        param("partstat", p.value);
+                }, v);
+        }
+        void any_param(RangeParam const &v)    { param("range", v.value); }
+        void any_param(TrigRelParam const &v)  { param("related", v.value); }
+        void any_param(RelTypeParam const &v)  { param("reltype", v.value); }
+        void any_param(RoleParam const &v)     { param("role", v.value); }
+        void any_param(RsvpParam const &v)     {
+                param("rsvp", "boolean", lower_case(v.value));
+        }
+        void any_param(SentByParam const &v)   {
+                param("sent-by", "cal-address", v.value);
+        }
+        void any_param(TzIdParam const &v)     { param(v); }
+        // The type of the value, see other_value().
+        void any_param(ValueTypeParam const &) {}
+        void any_param(OtherParam const &v)    { param(v); }
+
+        // Typed by a VALUE parameter, else "unknown" (RFC 6321, 5).
+        void other_value(vector<ICalParameter> const &params,
+                         string const &value) {
+                string t = "unknown";
+                for (auto const &p : params)
+                        if (auto v = get_if<ValueTypeParam>(&p))
+                                t = lower_case(v->value.value);
+                values();
+                if (t == "text")
+                        text(value);
+                else
+                        element(t, value);
+        }
+
+        // A property with other-params only and a single value.
+        template <typename Value>
+        void simple(std::string_view name, vector<OtherParam> const &ps,
+                    Value const &value) {
+                begin(name);
+                params(ps);
+                values();
+                single(value);
+                end();
+        }
+        void single(Text const &v)     { text(v); }
+        void single(string const &v)   { text(v); }
+        void single(Date const &v)     { formatted("date", v); }
+        void single(DateTime const &v) { formatted("date-time", v); }
+        void single(int v) {
+                element("integer", std::to_string(v));
+        }
+
+        // -- Calendar properties. ---------------------------------------------
+        void calprops(CalProps const &v) {
+                simple("prodid", v.prodId.params, v.prodId.value);
+                simple("version", v.version.params, v.version.value);
+                if (v.calScale)
+                        simple("calscale", v.calScale->params,
+                               v.calScale->value);
+                if (v.method)
+                        simple("method", v.method->params, v.method->value);
+        }
+
+        // -- Components. ------------------------------------------------------
+        void add(EventComp const &v) {
+                open("vevent");
+                open("properties");
+                for (auto const &p : v.properties)
+                        visit([this](auto const &x) { add(x); }, p);
+                close("properties");
+                if (!v.alarms.empty()) {
+                        open("components");
+                        for (auto const &a : v.alarms)
+                                visit([this](auto const &x) { alarm(x); }, a);
+                        close("components");
+                }
+                close("vevent");
+        }
+
+        void add(TimezoneComp const &v) {
+                open("vtimezone");
+                open("properties");
+                begin("tzid");
+                params(v.tzId.propParams.params);
+                values();
+                scratch_ = v.tzId.prefix.value + v.tzId.text;
+                text(scratch_);
+                end();
+                if (v.lastMod)
+                        add(*v.lastMod);
+                if (v.tzUrl) {
+                        begin("tzurl");
+                        params(v.tzUrl->params.params);
+                        values();
+                        element("uri", to_string(v.tzUrl->uri));
+                        end();
+                }
+                for (auto const &x : v.xProps)
+                        add(x);
+                for (auto const &x : v.ianaProps)
+                        add(x);
+                close("properties");
+                open("components");
+                if (auto p = get_if<StandardC>(&v.observance))
+                        observance("standard", p->tzProp);
+                if (auto p = get_if<DaylightC>(&v.observance))
+                        observance("daylight", p->tzProp);
+                close("components");
+                close("vtimezone");
+        }
+
+        // Not modelled by the AST yet.
+        template <typename T>
+        void add(T const &) {}
+
+        void observance(std::string_view name, TzProp const &v) {
+                open(name);
+                open("properties");
+                add(v.dtStart);
+                offset("tzoffsetto", v.offsetTo.param.otherParams,
+                       v.offsetTo.utcOffset);
+                offset("tzoffsetfrom", v.offsetFrom.param.otherParams,
+                       v.offsetFrom.utcOffset);
+                if (v.rRule)
+                        add(*v.rRule);
+                for (auto const &n : v.tzNames) {
+                        begin("tzname");
+                        if (!n.param.languageParam.value.empty())
+                                param("language", n.param.languageParam.value);
+                        params(n.param.otherParams);
+                        values();
+                        text(n.text);
+                        end();
+                }
+                for (auto const &x : v.xProps)
+                        add(x);
+                for (auto const &x : v.ianaProps)
+                        add(x);
+                close("properties");
+                close(name);
+        }
+
+        void offset(std::string_view name, vector<OtherParam> const &ps,
+                    UtcOffset const &v) {
+                begin(name);
+                params(ps);
+                values();
+                formatted("utc-offset", v);
+                end();
+        }
+
+        template <typename Alarm>
+        void alarm(Alarm const &v) {
+                open("valarm");
+                open("properties");
+                alarm_props(v);
+                if (v.repeat)
+                        simple("repeat", v.repeat->params.params,
+                               v.repeat->value);
+                for (auto const &x : v.xProps)
+                        add(x);
+                for (auto const &x : v.ianaProps)
+                        add(x);
+                close("properties");
+                close("valarm");
+        }
+        void alarm_props(AudioProp const &v) {
+                add(v.action);
+                add(v.trigger);
+        }
+        void alarm_props(DispProp const &v) {
+                add(v.action);
+                add(v.description);
+                add(v.trigger);
+        }
+        void alarm_props(EmailProp const &v) {
+                add(v.action);
+                add(v.description);
+                add(v.trigger);
+                add(v.summary);
+        }
+
+        // -- Properties. ------------------------------------------------------
+        void add(DtStamp const &v) {
+                simple("dtstamp", v.params.params, v.date_time);
+        }
+        void add(Uid const &v) {
+                simple("uid", v.params, v.value);
+        }
+        template <typename DtProp>
+        void date_prop(std::string_view name, DtProp const &v) {
+                begin(name);
+                param(v.params.tz_id);
+                params(v.params.params);
+                values();
+                if (auto d = get_if<Date>(&v.value))
+                        formatted("date", *d);
+                else
+                        formatted("date-time", get<DateTime>(v.value));
+                end();
+        }
+        void add(DtStart const &v) { date_prop("dtstart", v); }
+        void add(DtEnd const &v)   { date_prop("dtend", v); }
+        void add(Class const &v) {
+                simple("class", v.params.params, v.value);
+        }
+        void add(Created const &v) {
+                simple("created", v.params.params, v.dateTime);
+        }
+        template <typename TextProp>
+        void text_prop(std::string_view name, TextProp const &v) {
+                begin(name);
+                if (v.params.alt_rep)
+                        param("altrep", "uri", v.params.alt_rep->value);
+                if (v.params.language)
+                        param("language", v.params.language->value);
+                params(v.params.params);
+                values();
+                text(v.value);
+                end();
+        }
+        void add(Description const &v) { text_prop("description", v); }
+        void add(Summary const &v)     { text_prop("summary", v); }
+        void add(Geo const &v) {
+                begin("geo");
+                params(v.params.params);
+                values();
+                element("latitude", v.value.latitude);
+                element("longitude", v.value.longitude);
+                end();
+        }
+        void add(LastMod const &v) {
+                simple("last-modified", v.params.params, v.dateTime);
+        }
+        void add(Location const &v) {
+                begin("location");
+                if (v.params.alt_rep)
+                        param("altrep", "uri", v.params.alt_rep->value);
+                if (v.params.language)
+                        param("language", v.params.language->value);
+                params(v.params.params);
+                values();
+                text(v.value.view());
+                end();
+        }
+        void add(Organizer const &v) {
+                begin("organizer");
+                const auto &p = v.params;
+                if (p.cn) param("cn", p.cn->value);
+                if (p.dir) param("dir", "uri", p.dir->value);
+                if (p.sentBy) param("sent-by", "cal-address", p.sentBy->value);
+                if (p.language) param("language", p.language->value);
+                params(p.params);
+                values();
+                element("cal-address", to_string(v.address));
+                end();
+        }
+        void add(Seq const &v) {
+                simple("sequence", v.params.params, v.value);
+        }
+        void add(Status const &v) {
+                visit([&](having_string_value const &s) {
+                        simple("status", v.params.params, s.value);
+                }, v.value);
+        }
+        void add(Transp const &v) {
+                simple("transp", v.params.params, v.value);
+        }
+        void add(RRule const &v) {
+                begin("rrule");
+                params(v.param.otherParams);
+                values();
+                recur(v.recur);
+                end();
+        }
+        void add(Categories const &v) {
+                begin("categories");
+                if (v.params.language)
+                        param("language", v.params.language->value);
+                params(v.params.params);
+                values();
+                for (auto const &c : v.values)
+                        text(c.view());
+                end();
+        }
+        void add(XProp const &v) {
+                begin(lower_case(v.name.view()));
+                for (auto const &p : v.params)
+                        param(p);
+                other_value(v.params, v.value);
+                end();
+        }
+        void add(IanaProp const &v) {
+                begin(lower_case(v.ianaToken));
+                for (auto const &p : v.params)
+                        param(p);
+                other_value(v.params, v.value);
+                end();
+        }
+        void add(Action const &v) {
+                simple("action", v.params.params, v.value);
+        }
+        void add(Trigger const &v) {
+                begin("trigger");
+                if (auto r = get_if<TrigRel>(&v)) {
+                        if (!r->trigRelParam.value.empty())
+                                param("related", r->trigRelParam.value);
+                        params(r->params);
+                        values();
+                        formatted("duration", r->durValue);
+                } else {
+                        auto const &a = get<TrigAbs>(v);
+                        params(a.params);
+                        values();
+                        formatted("date-time", a.dateTime);
+                }
+                end();
+        }
+
+        // RFC 6321, 3.6.10: an element per value.
+        template <typename T, typename Fun>
+        void recur_part(std::string_view name, optional<vector<T>> const &v,
+                        Fun const &fun) {
+                if (!v)
+                        return;
+                for (auto const &x : *v)
+                        element(name, fun(x));
+        }
+        void recur(Recur const &v) {
+                open("recur");
+                element("freq", to_string(v.freq));
+                if (auto until = get_if<EndDate>(&v.duration)) {
+                        // Default constructed without UNTIL and COUNT.
+                        if (!date_of(*until).year.empty()) {
+                                if (auto d = get_if<Date>(until))
+                                        formatted("until", *d);
+                                else
+                                        formatted("until",
+                                                  get<DateTime>(*until));
+                        }
+                } else if (auto count = get_if<string>(&v.duration)) {
+                        if (!count->empty())
+                                element("count", *count);
+                }
+                if (v.interval)
+                        element("interval", *v.interval);
+                const auto num = [](string const &x) { return x; };
+                const auto signedNum = [](auto const &x) {
+                        return (x.sign < 0 ? "-" : "") + x.day;
+                };
+                recur_part("bysecond", v.bySecond, num);
+                recur_part("byminute", v.byMinute, num);
+                recur_part("byhour", v.byHour, num);
+                recur_part("byday", v.byDay, [](WeekDayNum const &x) {
+                        return to_string(x);
+                });
+                recur_part("bymonthday", v.byMonthDay, signedNum);
+                recur_part("byyearday", v.byYearDay, signedNum);
+                recur_part("bymonth", v.byMonth, num);
+                recur_part("bysetpos", v.bySetpos, signedNum);
+                if (v.wkst)
+                        element("wkst", to_string(*v.wkst));
+                close("recur");
+        }
+
+        OutputBuffer &out_;
+        string property_;
+        bool inParams_ = false;
+        string scratch_;
+};
+}
+
+void write_xcal(OutputBuffer &out, Calendar const &cal) {
+        XcalWriter(out).document(cal);
+}
+
+void write_xcal(OutputBuffer &out, Component const &c) {
+        XcalWriter(out).component(c);
+}
+
+std::string to_xcal(Calendar const &cal) {
+        OutputBuffer out;
+        write_xcal(out, cal);
+        return out.take();
+}